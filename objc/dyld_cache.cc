@@ -0,0 +1,337 @@
+#include "objc/dyld_cache.h"
+#include <string.h>
+#include <algorithm>
+
+namespace objc{
+	namespace{
+		//dyld_cache_header
+		const size_t kHeaderMagic = 0;
+		const size_t kHeaderMagicSize = 16;
+		const size_t kHeaderMappingOffset = 16;
+		const size_t kHeaderMappingCount = 20;
+		const size_t kHeaderImagesOffset = 24;
+		const size_t kHeaderImagesCount = 28;
+		const size_t kHeaderSize = 32;
+		const size_t kHeaderSlideInfoOffset = 56;
+		const size_t kHeaderSlideInfoSize = 64;
+		const size_t kHeaderLocalSymbolsOffset = 72;
+		const size_t kHeaderLocalSymbolsSize = 80;
+		//older caches end the header before the local symbols fields
+		const size_t kHeaderLocalSymbolsEnd = 88;
+		//caches with a slide info per mapping list dyld_cache_mapping_and_slide_info
+		const size_t kHeaderMappingWithSlideOffset = 0x138;
+		const size_t kHeaderMappingWithSlideCount = 0x13C;
+		const size_t kHeaderMappingWithSlideEnd = 0x140;
+		const size_t kSlideMappingInfoOffset = 24;
+		const size_t kSlideMappingInfoSize = 32;
+		const size_t kSlideMappingSize = 56;
+		//dyld_cache_slide_info2 and 3,the version comes first in both
+		const size_t kSlideVersion = 0;
+		const size_t kSlide2DeltaMask = 24;
+		const size_t kSlide2ValueAdd = 32;
+		const size_t kSlide2Size = 40;
+		const size_t kSlide3AuthValueAdd = 16;
+		const size_t kSlide3Size = 24;
+		//dyld_cache_mapping_info
+		const size_t kMappingAddress = 0;
+		const size_t kMappingSize = 8;
+		const size_t kMappingFileOffset = 16;
+		const size_t kMappingMaxProt = 24;
+		const size_t kMappingInitProt = 28;
+		const size_t kMappingInfoSize = 32;
+		//dyld_cache_image_info
+		const size_t kImageAddress = 0;
+		const size_t kImagePathFileOffset = 24;
+		const size_t kImageInfoSize = 32;
+		//MAXPATHLEN,bounds the path pool behind the image table
+		const size_t kMaxPathSize = 1024;
+		//dyld_cache_local_symbols_info,offsets are relative to it
+		const size_t kLocalNlistOffset = 0;
+		const size_t kLocalNlistCount = 4;
+		const size_t kLocalStringsOffset = 8;
+		const size_t kLocalStringsSize = 12;
+		const size_t kLocalEntriesOffset = 16;
+		const size_t kLocalEntriesCount = 20;
+		const size_t kLocalInfoSize = 24;
+		//dyld_cache_local_symbols_entry
+		const size_t kEntryDylibOffset = 0;
+		const size_t kEntryNlistStart = 4;
+		const size_t kEntryNlistCount = 8;
+		const size_t kEntrySize = 12;
+		//nlist and nlist_64 differ only in the width of n_value
+		const size_t kNlistStrx = 0;
+		const size_t kNlistType = 4;
+		const size_t kNlistValue = 8;
+		const size_t kNlistSize = 12;
+		const size_t kNlist64Size = 16;
+		const uint8 kNlistStab = 0xe0;
+		const uint8 kNlistTypeMask = 0x0e;
+		const uint8 kNlistSect = 0x0e;
+		bool AddressLess(const DyldLocalSymbol& left,const DyldLocalSymbol& right){
+			return left.address<right.address;
+		}
+		bool SameAddress(const DyldLocalSymbol& left,const DyldLocalSymbol& right){
+			return left.address==right.address;
+		}
+		//caches are only built for little endian targets
+		uint32 Load32(const uint8* p){
+			uint32 value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		uint64_t Load64(const uint8* p){
+			uint64_t value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		//len bytes at offset of the local symbols info,NULL past its end
+		const uint8* InfoAt(const uint8* info,uint64_t info_size,uint64_t offset,size_t len){
+			return (offset<=info_size&&len<=info_size-offset)?info+offset:NULL;
+		}
+	}
+	DyldCache::DyldCache(void){
+		memset(&pointer_format_,0,sizeof(pointer_format_));
+	}
+	DyldCache::~DyldCache(void){
+	}
+	bool DyldCache::Open(const std::string& path){
+		Close();
+		if(!file_.Open(path)||!ReadTables()){
+			Close();
+			return false;
+		}
+		ReadSlideInfo(Load32(file_.data()+kHeaderMappingOffset));
+		return true;
+	}
+	bool DyldCache::OpenTables(const std::string& path){
+		Close();
+		//the header,then the mapping and image tables it points to,then the
+		//path pool behind them.the images themselves stay unmapped
+		const uint8* header = NULL;
+		if(!file_.OpenView(path,0,kHeaderSize)||(header = AtOffset(0,kHeaderSize))==NULL){
+			Close();
+			return false;
+		}
+		uint32 images_offset = Load32(header+kHeaderImagesOffset);
+		uint32 images_count = Load32(header+kHeaderImagesCount);
+		uint64_t tables_end = uint64_t(Load32(header+kHeaderMappingOffset))+uint64_t(Load32(header+kHeaderMappingCount))*kMappingInfoSize;
+		tables_end = std::max(tables_end,uint64_t(images_offset)+uint64_t(images_count)*kImageInfoSize);
+		const uint8* images = NULL;
+		if(!file_.OpenView(path,0,tables_end)||(images = AtOffset(images_offset,size_t(images_count)*kImageInfoSize))==NULL){
+			Close();
+			return false;
+		}
+		uint64_t paths_end = tables_end;
+		for(uint32 index=0;index<images_count;index++){
+			paths_end = std::max(paths_end,uint64_t(Load32(images+index*kImageInfoSize+kImagePathFileOffset))+kMaxPathSize);
+		}
+		if(!file_.OpenView(path,0,paths_end)||!ReadTables()){
+			Close();
+			return false;
+		}
+		//the local symbols follow the mappings,a view of their own
+		header = AtOffset(0,kHeaderLocalSymbolsEnd);
+		if(header!=NULL&&Load32(header+kHeaderMappingOffset)>=kHeaderLocalSymbolsEnd&&Load64(header+kHeaderLocalSymbolsSize)!=0){
+			symbols_file_.OpenView(path,Load64(header+kHeaderLocalSymbolsOffset),Load64(header+kHeaderLocalSymbolsSize));
+		}
+		return true;
+	}
+	bool DyldCache::ReadTables(){
+		const uint8* header = AtOffset(0,kHeaderSize);
+		if(header==NULL||memcmp(header+kHeaderMagic,"dyld_v1",7)!=0){
+			return false;
+		}
+		//"dyld_v1  arm64e",the architecture is right aligned
+		std::string magic(reinterpret_cast<const char*>(header+kHeaderMagic),strnlen(reinterpret_cast<const char*>(header+kHeaderMagic),kHeaderMagicSize));
+		size_t arch_start = magic.find_first_not_of(' ',7);
+		arch_ = (arch_start!=std::string::npos)?magic.substr(arch_start):"";
+		uint32 mapping_offset = Load32(header+kHeaderMappingOffset);
+		uint32 mapping_count = Load32(header+kHeaderMappingCount);
+		const uint8* mappings = AtOffset(mapping_offset,size_t(mapping_count)*kMappingInfoSize);
+		if(mappings==NULL){
+			return false;
+		}
+		for(uint32 index=0;index<mapping_count;index++){
+			const uint8* info = mappings+index*kMappingInfoSize;
+			MachoSegment mapping;
+			memset(mapping.segname,0,sizeof(mapping.segname));
+			mapping.vmaddr = Load64(info+kMappingAddress);
+			mapping.vmsize = Load64(info+kMappingSize);
+			mapping.fileoff = Load64(info+kMappingFileOffset);
+			mapping.filesize = mapping.vmsize;
+			mapping.maxprot = Load32(info+kMappingMaxProt);
+			mapping.initprot = Load32(info+kMappingInitProt);
+			//checked against the file,a tables only view does not hold them
+			if(mapping.fileoff<=file_.file_size()&&mapping.filesize<=file_.file_size()-mapping.fileoff){
+				mappings_.push_back(mapping);
+			}
+		}
+		uint32 images_offset = Load32(header+kHeaderImagesOffset);
+		uint32 images_count = Load32(header+kHeaderImagesCount);
+		const uint8* images = AtOffset(images_offset,size_t(images_count)*kImageInfoSize);
+		if(images==NULL){
+			return false;
+		}
+		images_.reserve(images_count);
+		for(uint32 index=0;index<images_count;index++){
+			const uint8* info = images+index*kImageInfoSize;
+			DyldCacheImage image;
+			image.address = Load64(info+kImageAddress);
+			image.path = "";
+			uint32 path_offset = Load32(info+kImagePathFileOffset);
+			const uint8* path_data = AtOffset(path_offset,1);
+			if(path_data!=NULL&&memchr(path_data,0,file_.size()-path_offset)!=NULL){
+				image.path = reinterpret_cast<const char*>(path_data);
+			}
+			if(OffsetOf(image.address,&image.offset)){
+				images_.push_back(image);
+			}
+		}
+		return true;
+	}
+	void DyldCache::ReadSlideInfo(uint32 header_size){
+		memset(&pointer_format_,0,sizeof(pointer_format_));
+		//the header's own slide info covers the one data mapping of older
+		//caches,newer ones have it per mapping and the same format in all
+		uint64_t info_offset = 0;
+		uint64_t info_size = 0;
+		const uint8* header = AtOffset(0,header_size);
+		if(header==NULL){
+			return;
+		}
+		if(header_size>=kHeaderMappingWithSlideEnd&&Load32(header+kHeaderMappingWithSlideCount)!=0){
+			uint32 count = Load32(header+kHeaderMappingWithSlideCount);
+			const uint8* mappings = AtOffset(Load32(header+kHeaderMappingWithSlideOffset),size_t(count)*kSlideMappingSize);
+			for(uint32 index=0;mappings!=NULL&&index<count&&info_size==0;index++){
+				info_offset = Load64(mappings+index*kSlideMappingSize+kSlideMappingInfoOffset);
+				info_size = Load64(mappings+index*kSlideMappingSize+kSlideMappingInfoSize);
+			}
+		}
+		else if(header_size>=kHeaderSlideInfoSize+8){
+			info_offset = Load64(header+kHeaderSlideInfoOffset);
+			info_size = Load64(header+kHeaderSlideInfoSize);
+		}
+		const uint8* info = (info_size>=kSlide3Size)?AtOffset(info_offset,kSlide3Size):NULL;
+		if(info==NULL){
+			return;
+		}
+		//v1 rebases plain pointers,v4 is for 32-bit caches
+		uint32 version = Load32(info+kSlideVersion);
+		if(version==MachoPointerFormat::kSlideInfoV2&&info_size>=kSlide2Size&&(info = AtOffset(info_offset,kSlide2Size))!=NULL){
+			pointer_format_.version = version;
+			pointer_format_.value_mask = ~Load64(info+kSlide2DeltaMask);
+			pointer_format_.value_add = Load64(info+kSlide2ValueAdd);
+		}
+		else if(version==MachoPointerFormat::kSlideInfoV3){
+			pointer_format_.version = version;
+			pointer_format_.value_mask = ~uint64_t(0);
+			pointer_format_.value_add = Load64(info+kSlide3AuthValueAdd);
+		}
+	}
+	void DyldCache::Close(){
+		file_.Close();
+		arch_.clear();
+		mappings_.clear();
+		images_.clear();
+		memset(&pointer_format_,0,sizeof(pointer_format_));
+		symbols_file_.Close();
+	}
+	bool DyldCache::OpenImage(size_t index,MachoImage* image) const{
+		if(index>=images_.size()||!image->ParseAt(file_.data(),file_.size(),images_[index].offset)){
+			return false;
+		}
+		image->set_fallback_segments(&mappings_);
+		image->set_pointer_format((pointer_format_.version!=0)?&pointer_format_:NULL);
+		return true;
+	}
+	size_t DyldCache::FindImage(uint64_t address) const{
+		size_t index = 0;
+		while(index<images_.size()&&images_[index].address!=address){
+			index++;
+		}
+		return index;
+	}
+	bool DyldCache::is64() const{
+		return arch_.compare(0,6,"x86_64")==0||(arch_.compare(0,5,"arm64")==0&&arch_!="arm64_32");
+	}
+	bool DyldCache::LocalSymbols(size_t index,std::vector<DyldLocalSymbol>* symbols) const{
+		symbols->clear();
+		const uint8* header = AtOffset(0,kHeaderLocalSymbolsEnd);
+		if(index>=images_.size()||header==NULL||Load32(header+kHeaderMappingOffset)<kHeaderLocalSymbolsEnd){
+			return false;
+		}
+		//from the own view of OpenTables or the whole file of Open
+		uint64_t info_size = Load64(header+kHeaderLocalSymbolsSize);
+		const uint8* info = symbols_file_.data();
+		if(info!=NULL){
+			info_size = symbols_file_.size();
+		}
+		else if(info_size==static_cast<size_t>(info_size)){
+			info = AtOffset(Load64(header+kHeaderLocalSymbolsOffset),static_cast<size_t>(info_size));
+		}
+		if(info==NULL||info_size<kLocalInfoSize){
+			return false;
+		}
+		uint32 entries_count = Load32(info+kLocalEntriesCount);
+		const uint8* entries = InfoAt(info,info_size,Load32(info+kLocalEntriesOffset),size_t(entries_count)*kEntrySize);
+		if(entries==NULL){
+			return false;
+		}
+		//entries are keyed by the file offset of the image's mach header
+		const uint8* entry = NULL;
+		for(uint32 position=0;position<entries_count&&entry==NULL;position++){
+			if(Load32(entries+position*kEntrySize+kEntryDylibOffset)==images_[index].offset){
+				entry = entries+position*kEntrySize;
+			}
+		}
+		if(entry==NULL){
+			return false;
+		}
+		uint32 nlist_start = Load32(entry+kEntryNlistStart);
+		uint32 nlist_count = Load32(entry+kEntryNlistCount);
+		bool wide = is64();
+		size_t nlist_size = wide?kNlist64Size:kNlistSize;
+		if(uint64_t(nlist_start)+nlist_count>Load32(info+kLocalNlistCount)){
+			return false;
+		}
+		const uint8* nlist = InfoAt(info,info_size,Load32(info+kLocalNlistOffset)+uint64_t(nlist_start)*nlist_size,size_t(nlist_count)*nlist_size);
+		uint32 strings_size = Load32(info+kLocalStringsSize);
+		const char* strings = reinterpret_cast<const char*>(InfoAt(info,info_size,Load32(info+kLocalStringsOffset),strings_size));
+		if(nlist==NULL||strings==NULL){
+			return false;
+		}
+		//one pass over the nlists,names stay in the mapped string pool
+		symbols->reserve(nlist_count);
+		for(const uint8* sym = nlist;sym<nlist+size_t(nlist_count)*nlist_size;sym += nlist_size){
+			uint8 type = sym[kNlistType];
+			uint32 strx = Load32(sym+kNlistStrx);
+			if((type&kNlistStab)!=0||(type&kNlistTypeMask)!=kNlistSect||strx==0||strx>=strings_size||
+				memchr(strings+strx,0,strings_size-strx)==NULL){
+				continue;
+			}
+			DyldLocalSymbol symbol;
+			symbol.address = wide?Load64(sym+kNlistValue):Load32(sym+kNlistValue);
+			symbol.name = strings+strx;
+			symbols->push_back(symbol);
+		}
+		//the first name of an address wins,as in the symbol table it came from
+		std::stable_sort(symbols->begin(),symbols->end(),AddressLess);
+		symbols->erase(std::unique(symbols->begin(),symbols->end(),SameAddress),symbols->end());
+		return true;
+	}
+	const uint8* DyldCache::AtOffset(uint64_t offset,size_t len) const{
+		if(offset>file_.size()||len>file_.size()-offset){
+			return NULL;
+		}
+		return file_.data()+offset;
+	}
+	bool DyldCache::OffsetOf(uint64_t vmaddr,uint64_t* offset) const{
+		for(std::vector<MachoSegment>::const_iterator it = mappings_.begin();it!=mappings_.end();++it){
+			if(vmaddr>=it->vmaddr&&vmaddr-it->vmaddr<it->filesize){
+				*offset = it->fileoff+(vmaddr-it->vmaddr);
+				return true;
+			}
+		}
+		return false;
+	}
+}
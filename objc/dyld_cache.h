@@ -0,0 +1,91 @@
+#ifndef OBJC_DYLD_CACHE_H_
+#define OBJC_DYLD_CACHE_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include "objc/macho_image.h"
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:the layouts follow dyld_cache_header,dyld_cache_mapping_info
+//and dyld_cache_image_info of the sdk's ldr/mach-o/common.h,which needs the
+//ida runtime and cannot be used by the standalone tools
+namespace objc{
+	struct DyldCacheImage
+	{
+		//vm address of the mach header
+		uint64_t address;
+		//file offset of the mach header
+		uint64_t offset;
+		const char* path;
+	};
+	struct DyldLocalSymbol
+	{
+		uint64_t address;
+		//points into the mapped cache
+		const char* name;
+	};
+	//read-only view of a single file dyld_shared_cache.the file is mapped,
+	//not read,so opening a multi-GB cache costs only the header and tables
+	class DyldCache
+	{
+	public:
+		DyldCache(void);
+		~DyldCache(void);
+		bool Open(const std::string& path);
+		//maps the header with its tables and the local symbols only:images(),
+		//arch() and LocalSymbols work,OpenImage does not.for the 32-bit
+		//plugin,which has no address space for a multi-GB cache
+		bool OpenTables(const std::string& path);
+		void Close();
+		//"arm64","x86_64"... from the magic
+		const std::string& arch() const{
+			return arch_;
+		}
+		//the mappings as segments,usable as MachoImage fallback segments
+		const std::vector<MachoSegment>& mappings() const{
+			return mappings_;
+		}
+		const std::vector<DyldCacheImage>& images() const{
+			return images_;
+		}
+		//image index of the cache parsed into image,pointers outside of it
+		//resolve through the cache mappings
+		bool OpenImage(size_t index,MachoImage* image) const;
+		//pointer width of the images,from arch()
+		bool is64() const;
+		//image whose mach header is at address,images().size() if none is
+		size_t FindImage(uint64_t address) const;
+		//the section symbols stripped from image index,read from
+		//dyld_cache_local_symbols_info.sorted by address,one per address
+		bool LocalSymbols(size_t index,std::vector<DyldLocalSymbol>* symbols) const;
+		const uint8* AtOffset(uint64_t offset,size_t len) const;
+		//file offset of a vm address,false if no mapping holds it
+		bool OffsetOf(uint64_t vmaddr,uint64_t* offset) const;
+		const uint8* data() const{
+			return file_.data();
+		}
+		size_t size() const{
+			return file_.size();
+		}
+		//slide info v2 or v3 of the data mappings,version 0 when the
+		//pointers are stored plain
+		const MachoPointerFormat& pointer_format() const{
+			return pointer_format_;
+		}
+	private:
+		bool ReadTables();
+		void ReadSlideInfo(uint32 header_size);
+		MappedFile file_;
+		//local symbols of OpenTables
+		MappedFile symbols_file_;
+		std::string arch_;
+		std::vector<MachoSegment> mappings_;
+		std::vector<DyldCacheImage> images_;
+		MachoPointerFormat pointer_format_;
+		DISALLOW_EVIL_CONSTRUCTORS(DyldCache);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,260 @@
+#include "objc/dyld_cache_index.h"
+#include <string.h>
+#include <algorithm>
+#include "objc/objc2_metadata.h"
+
+namespace objc{
+	namespace{
+		struct RawMethod
+		{
+			const char* class_name;
+			const char* selector;
+			uint64_t imp;
+			bool class_method;
+		};
+		//what one image contributes,filled by one task without locks
+		struct ImageObjc
+		{
+			ImageObjc():walked(false){}
+			std::vector<const char*> classes;
+			std::vector<const char*> protocols;
+			std::vector<RawMethod> methods;
+			bool walked;
+		};
+		class ImageVisitor
+		{
+		public:
+			explicit ImageVisitor(ImageObjc* image):image_(image){}
+			void VisitClass(uint64_t,const char* name){
+				image_->classes.push_back(name);
+			}
+			void VisitMethod(const char* class_name,const char* selector,uint64_t imp,bool class_method){
+				RawMethod method;
+				method.class_name = class_name;
+				method.selector = selector;
+				method.imp = imp;
+				method.class_method = class_method;
+				image_->methods.push_back(method);
+			}
+			void VisitProtocol(uint64_t,const char* name){
+				image_->protocols.push_back(name);
+			}
+		private:
+			ImageObjc* image_;
+		};
+		class ImageTask:public ParallelTask
+		{
+		public:
+			ImageTask(const DyldCache& cache,std::vector<ImageObjc>* images):cache_(cache),images_(images){}
+			virtual void Run(size_t index) const{
+				MachoImage image;
+				if(!cache_.OpenImage(index,&image)){
+					return;
+				}
+				ImageVisitor visitor(&(*images_)[index]);
+				WalkObjc2Metadata(image,&visitor);
+				(*images_)[index].walked = true;
+			}
+		private:
+			const DyldCache& cache_;
+			std::vector<ImageObjc>* images_;
+		};
+		struct SelectorOrder
+		{
+			bool operator()(const std::pair<uint32,DyldCacheIndex::Implementation>& a,const std::pair<uint32,DyldCacheIndex::Implementation>& b) const{
+				if(a.first!=b.first){
+					return a.first<b.first;
+				}
+				if(a.second.class_id!=b.second.class_id){
+					return a.second.class_id<b.second.class_id;
+				}
+				return a.second.class_method<b.second.class_method;
+			}
+		};
+		struct ImplementationOrder
+		{
+			bool operator()(const DyldCacheIndex::Implementation& a,const DyldCacheIndex::Implementation& b) const{
+				if(a.class_id!=b.class_id){
+					return a.class_id<b.class_id;
+				}
+				return a.class_method<b.class_method;
+			}
+		};
+	}
+	NameTable::NameTable(void){
+	}
+	NameTable::~NameTable(void){
+	}
+	uint32 NameTable::Hash(const char* name){
+		//fnv-1a
+		uint32 hash = 2166136261u;
+		for(;*name!='\0';name++){
+			hash = (hash^static_cast<uint8>(*name))*16777619u;
+		}
+		return hash;
+	}
+	uint32 NameTable::Intern(const char* name){
+		if((names_.size()+1)*2>slots_.size()){
+			Grow();
+		}
+		uint32 hash = Hash(name);
+		size_t mask = slots_.size()-1;
+		for(size_t slot = hash&mask;;slot = (slot+1)&mask){
+			uint32 entry = slots_[slot];
+			if(entry==0){
+				uint32 id = static_cast<uint32>(names_.size());
+				names_.push_back(name);
+				hashes_.push_back(hash);
+				slots_[slot] = id+1;
+				return id;
+			}
+			//uniqued strings of the cache usually match by address
+			if(hashes_[entry-1]==hash&&(names_[entry-1]==name||strcmp(names_[entry-1],name)==0)){
+				return entry-1;
+			}
+		}
+	}
+	uint32 NameTable::Find(const char* name) const{
+		if(slots_.empty()){
+			return kNotFound;
+		}
+		uint32 hash = Hash(name);
+		size_t mask = slots_.size()-1;
+		for(size_t slot = hash&mask;;slot = (slot+1)&mask){
+			uint32 entry = slots_[slot];
+			if(entry==0){
+				return kNotFound;
+			}
+			if(hashes_[entry-1]==hash&&strcmp(names_[entry-1],name)==0){
+				return entry-1;
+			}
+		}
+	}
+	void NameTable::Grow(){
+		size_t capacity = slots_.empty()?1024:slots_.size()*2;
+		std::vector<uint32>(capacity,0).swap(slots_);
+		size_t mask = capacity-1;
+		for(uint32 id=0;id<names_.size();id++){
+			size_t slot = hashes_[id]&mask;
+			while(slots_[slot]!=0){
+				slot = (slot+1)&mask;
+			}
+			slots_[slot] = id+1;
+		}
+	}
+	size_t NameTable::memory() const{
+		return names_.capacity()*sizeof(const char*)+hashes_.capacity()*sizeof(uint32)+slots_.capacity()*sizeof(uint32);
+	}
+	void NameTable::Clear(){
+		std::vector<const char*>().swap(names_);
+		std::vector<uint32>().swap(hashes_);
+		std::vector<uint32>().swap(slots_);
+	}
+	DyldCacheIndex::DyldCacheIndex(void):images_walked_(0){
+	}
+	DyldCacheIndex::~DyldCacheIndex(void){
+	}
+	void DyldCacheIndex::Build(const DyldCache& cache,ThreadPool* pool){
+		classes_.Clear();
+		selectors_.Clear();
+		protocols_.Clear();
+		class_images_.clear();
+		protocol_images_.clear();
+		images_walked_ = 0;
+		std::vector<ImageObjc> images(cache.images().size());
+		pool->ParallelFor(images.size(),ImageTask(cache,&images));
+		//interning is serial,in image order so ids do not depend on the pool
+		std::vector<std::pair<uint32,Implementation> > methods;
+		for(uint32 index=0;index<images.size();index++){
+			ImageObjc& image = images[index];
+			if(!image.walked){
+				continue;
+			}
+			images_walked_++;
+			for(std::vector<const char*>::const_iterator it = image.classes.begin();it!=image.classes.end();++it){
+				uint32 id = classes_.Intern(*it);
+				if(id>=class_images_.size()){
+					class_images_.resize(id+1,kNotFound);
+				}
+				if(class_images_[id]==kNotFound){
+					class_images_[id] = index;
+				}
+			}
+			for(std::vector<const char*>::const_iterator it = image.protocols.begin();it!=image.protocols.end();++it){
+				protocol_images_.push_back(std::make_pair(protocols_.Intern(*it),index));
+			}
+			for(std::vector<RawMethod>::const_iterator it = image.methods.begin();it!=image.methods.end();++it){
+				Implementation method;
+				method.imp = it->imp;
+				method.class_id = classes_.Intern(it->class_name);
+				method.image = index;
+				method.class_method = it->class_method?1:0;
+				methods.push_back(std::make_pair(selectors_.Intern(it->selector),method));
+			}
+			//the raw lists are the bulk of the transient memory
+			std::vector<const char*>().swap(image.classes);
+			std::vector<RawMethod>().swap(image.methods);
+		}
+		class_images_.resize(classes_.size(),kNotFound);
+		std::sort(protocol_images_.begin(),protocol_images_.end());
+		protocol_images_.erase(std::unique(protocol_images_.begin(),protocol_images_.end()),protocol_images_.end());
+		//stable so the first image keeps precedence for duplicate definitions
+		std::stable_sort(methods.begin(),methods.end(),SelectorOrder());
+		selector_offsets_.assign(selectors_.size()+1,0);
+		methods_.clear();
+		methods_.reserve(methods.size());
+		for(std::vector<std::pair<uint32,Implementation> >::const_iterator it = methods.begin();it!=methods.end();++it){
+			selector_offsets_[it->first+1]++;
+			methods_.push_back(it->second);
+		}
+		for(size_t index=1;index<selector_offsets_.size();index++){
+			selector_offsets_[index] += selector_offsets_[index-1];
+		}
+	}
+	size_t DyldCacheIndex::Implementers(const char* selector,const Implementation** first) const{
+		uint32 id = selectors_.Find(selector);
+		if(id==kNotFound){
+			*first = NULL;
+			return 0;
+		}
+		*first = &methods_[selector_offsets_[id]];
+		return selector_offsets_[id+1]-selector_offsets_[id];
+	}
+	const DyldCacheIndex::Implementation* DyldCacheIndex::Lookup(const char* class_name,const char* selector,bool class_method) const{
+		uint32 class_id = classes_.Find(class_name);
+		const Implementation* first = NULL;
+		size_t count = Implementers(selector,&first);
+		if(class_id==kNotFound||count==0){
+			return NULL;
+		}
+		Implementation key;
+		key.class_id = class_id;
+		key.class_method = class_method?1:0;
+		//first of the equal range,the sort in Build is stable so that is the
+		//definition of the first image like ClassImage
+		const Implementation* found = std::lower_bound(first,first+count,key,ImplementationOrder());
+		if(found==first+count||found->class_id!=class_id||found->class_method!=key.class_method){
+			return NULL;
+		}
+		return found;
+	}
+	uint32 DyldCacheIndex::ClassImage(const char* class_name) const{
+		uint32 id = classes_.Find(class_name);
+		return (id!=kNotFound)?class_images_[id]:kNotFound;
+	}
+	void DyldCacheIndex::ProtocolImages(const char* protocol,std::vector<uint32>* images) const{
+		uint32 id = protocols_.Find(protocol);
+		if(id==kNotFound){
+			return;
+		}
+		std::vector<std::pair<uint32,uint32> >::const_iterator it = std::lower_bound(protocol_images_.begin(),protocol_images_.end(),std::make_pair(id,0u));
+		for(;it!=protocol_images_.end()&&it->first==id;++it){
+			images->push_back(it->second);
+		}
+	}
+	size_t DyldCacheIndex::memory() const{
+		return classes_.memory()+selectors_.memory()+protocols_.memory()+class_images_.capacity()*sizeof(uint32)+
+			protocol_images_.capacity()*sizeof(protocol_images_[0])+selector_offsets_.capacity()*sizeof(uint32)+
+			methods_.capacity()*sizeof(Implementation);
+	}
+}
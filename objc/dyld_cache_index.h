@@ -0,0 +1,103 @@
+#ifndef OBJC_DYLD_CACHE_INDEX_H_
+#define OBJC_DYLD_CACHE_INDEX_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+#include "objc/dyld_cache.h"
+#include "objc/objc_thread_pool.h"
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here
+namespace objc{
+	//interns nul terminated names by content,the names are not copied and
+	//must outlive the table
+	class NameTable
+	{
+	public:
+		enum{
+			kNotFound = 0xFFFFFFFF
+		};
+		NameTable(void);
+		~NameTable(void);
+		uint32 Intern(const char* name);
+		uint32 Find(const char* name) const;
+		const char* name(uint32 id) const{
+			return names_[id];
+		}
+		uint32 size() const{
+			return static_cast<uint32>(names_.size());
+		}
+		size_t memory() const;
+		void Clear();
+	private:
+		static uint32 Hash(const char* name);
+		void Grow();
+		std::vector<const char*> names_;
+		std::vector<uint32> hashes_;
+		//open addressing,id+1 or 0 when free
+		std::vector<uint32> slots_;
+		DISALLOW_EVIL_CONSTRUCTORS(NameTable);
+	};
+	//classes,selectors and protocols of every image of a shared cache.the
+	//images are walked in parallel,names point into the mapped cache and the
+	//methods are kept grouped by selector,so memory follows the metadata and
+	//a lookup is two hash probes and a binary search
+	class DyldCacheIndex
+	{
+	public:
+		enum{
+			kNotFound = NameTable::kNotFound
+		};
+		struct Implementation
+		{
+			uint64_t imp;
+			uint32 class_id;
+			uint32 image;
+			//instance methods sort before class methods of the same class
+			uint32 class_method;
+		};
+		DyldCacheIndex(void);
+		~DyldCacheIndex(void);
+		//the cache must stay open while the index is used
+		void Build(const DyldCache& cache,ThreadPool* pool);
+		//-[class_name selector] or +[...],NULL if no image implements it
+		const Implementation* Lookup(const char* class_name,const char* selector,bool class_method) const;
+		//every implementation of selector,returns the count
+		size_t Implementers(const char* selector,const Implementation** first) const;
+		//image defining the class,kNotFound if none does
+		uint32 ClassImage(const char* class_name) const;
+		void ProtocolImages(const char* protocol,std::vector<uint32>* images) const;
+		const NameTable& classes() const{
+			return classes_;
+		}
+		const NameTable& selectors() const{
+			return selectors_;
+		}
+		size_t method_count() const{
+			return methods_.size();
+		}
+		uint32 protocol_count() const{
+			return protocols_.size();
+		}
+		uint32 images_walked() const{
+			return images_walked_;
+		}
+		size_t memory() const;
+	private:
+		NameTable classes_;
+		NameTable selectors_;
+		NameTable protocols_;
+		std::vector<uint32> class_images_;
+		//protocols are defined by several images,(protocol,image) sorted
+		std::vector<std::pair<uint32,uint32> > protocol_images_;
+		//methods_ of selector s are [selector_offsets_[s],selector_offsets_[s+1])
+		//sorted by class and kind
+		std::vector<uint32> selector_offsets_;
+		std::vector<Implementation> methods_;
+		uint32 images_walked_;
+		DISALLOW_EVIL_CONSTRUCTORS(DyldCacheIndex);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
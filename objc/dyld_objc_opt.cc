@@ -0,0 +1,318 @@
+#include "objc/dyld_objc_opt.h"
+#include <string.h>
+#include <algorithm>
+
+#define MIX64(a,b,c) \
+{ \
+	a -= b; a -= c; a ^= (c>>43); \
+	b -= c; b -= a; b ^= (a<<9); \
+	c -= a; c -= b; c ^= (b>>8); \
+	a -= b; a -= c; a ^= (c>>38); \
+	b -= c; b -= a; b ^= (a<<23); \
+	c -= a; c -= b; c ^= (b>>5); \
+	a -= b; a -= c; a ^= (c>>35); \
+	b -= c; b -= a; b ^= (a<<49); \
+	c -= a; c -= b; c ^= (b>>11); \
+	a -= b; a -= c; a ^= (c>>12); \
+	b -= c; b -= a; b ^= (a<<18); \
+	c -= a; c -= b; c ^= (b>>22); \
+}
+
+namespace objc{
+	namespace{
+		//objc_opt_t,offsets are relative to its start
+		const size_t kOptVersion = 0;
+		const size_t kOptHeaderSize = 32;
+		//objc_stringhash_t
+		const size_t kHashCapacity = 0;
+		const size_t kHashOccupied = 4;
+		const size_t kHashShift = 8;
+		const size_t kHashMask = 12;
+		const size_t kHashSalt = 24;
+		const size_t kHashScramble = 32;
+		const size_t kHashTab = kHashScramble+256*4;
+		//objc_classheader_t
+		const size_t kClassHeaderSize = 8;
+		//tables larger than this are not from a cache builder
+		const uint32 kMaxCapacity = 1<<26;
+		const uint32 kMinVersion = 12;
+		const uint32 kMaxVersion = 15;
+		//from version 15 on the header has flags and classes point at
+		//header_info_ro,whose mach header is relative to the entry
+		const uint32 kRelativeHeaderVersion = 15;
+		uint32 Load32(const uint8* p){
+			uint32 value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		uint64_t Load64(const uint8* p){
+			uint64_t value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		const char* CString(const DyldCache& cache,uint64_t vmaddr){
+			uint64_t offset;
+			if(!cache.OffsetOf(vmaddr,&offset)||offset>=cache.size()){
+				return NULL;
+			}
+			const char* str = reinterpret_cast<const char*>(cache.data()+offset);
+			return (memchr(str,0,cache.size()-static_cast<size_t>(offset))!=NULL)?str:NULL;
+		}
+	}
+	ObjcOptStringHash::ObjcOptStringHash(void):cache_(NULL),base_(NULL),vmaddr_(0),capacity_(0),occupied_(0),shift_(0),mask_(0),
+		salt_(0),scramble_(NULL),tab_(NULL),checkbytes_(NULL),offsets_(NULL),end_(0){
+	}
+	bool ObjcOptStringHash::Parse(const DyldCache& cache,uint64_t vmaddr){
+		*this = ObjcOptStringHash();
+		uint64_t offset;
+		if(!cache.OffsetOf(vmaddr,&offset)){
+			return false;
+		}
+		const uint8* base = cache.AtOffset(offset,kHashTab);
+		if(base==NULL){
+			return false;
+		}
+		uint32 capacity = Load32(base+kHashCapacity);
+		uint32 mask = Load32(base+kHashMask);
+		if(capacity>kMaxCapacity||mask>=kMaxCapacity||((mask+1)&mask)!=0){
+			return false;
+		}
+		//tab[mask+1],checkbytes[capacity],offsets[capacity]
+		uint64_t size = kHashTab+uint64_t(mask)+1+uint64_t(capacity)*5;
+		if(cache.AtOffset(offset,static_cast<size_t>(size))==NULL){
+			return false;
+		}
+		cache_ = &cache;
+		base_ = base;
+		vmaddr_ = vmaddr;
+		capacity_ = capacity;
+		occupied_ = Load32(base+kHashOccupied);
+		shift_ = Load32(base+kHashShift);
+		mask_ = mask;
+		salt_ = Load64(base+kHashSalt);
+		scramble_ = base+kHashScramble;
+		tab_ = base+kHashTab;
+		checkbytes_ = tab_+mask+1;
+		offsets_ = checkbytes_+capacity;
+		end_ = size;
+		return true;
+	}
+	uint32 ObjcOptStringHash::Find(const char* key) const{
+		if(base_==NULL||capacity_==0){
+			return kNotFound;
+		}
+		size_t length = strlen(key);
+		uint64_t value = Hash(reinterpret_cast<const uint8*>(key),length,salt_);
+		uint32 index = ((shift_<64)?static_cast<uint32>(value>>shift_):0)^Load32(scramble_+tab_[value&mask_]*4);
+		if(index>=capacity_){
+			return kNotFound;
+		}
+		//the check byte rejects most misses without touching the string
+		uint8 check = static_cast<uint8>(((key[0]&0x7)<<5)|(length&0x1f));
+		if(checkbytes_[index]!=check||Load32(offsets_+index*4)==0){
+			return kNotFound;
+		}
+		const char* name = CString(*cache_,EntryAddress(index));
+		return (name!=NULL&&strcmp(name,key)==0)?index:kNotFound;
+	}
+	uint64_t ObjcOptStringHash::EntryAddress(uint32 index) const{
+		return vmaddr_+static_cast<int32_t>(Load32(offsets_+index*4));
+	}
+	//bob jenkins' lookup8,the hash the cache builder used for the table
+	uint64_t ObjcOptStringHash::Hash(const uint8* k,size_t length,uint64_t level){
+		uint64_t a = level;
+		uint64_t b = level;
+		uint64_t c = 0x9e3779b97f4a7c13ULL;
+		size_t len = length;
+		while(len>=24){
+			a += Load64(k);
+			b += Load64(k+8);
+			c += Load64(k+16);
+			MIX64(a,b,c);
+			k += 24;
+			len -= 24;
+		}
+		c += length;
+		//the last 0..23 bytes go to a,b and c in order,the first byte of c
+		//is reserved for the length
+		for(size_t index=0;index<len;index++){
+			uint64_t byte = k[index];
+			if(index<8){
+				a += byte<<(index*8);
+			}
+			else if(index<16){
+				b += byte<<((index-8)*8);
+			}
+			else{
+				c += byte<<((index-16)*8+8);
+			}
+		}
+		MIX64(a,b,c);
+		return c;
+	}
+#undef MIX64
+	ObjcOptTables::ObjcOptTables(void):cache_(NULL),version_(0),pointer_size_(8){
+	}
+	ObjcOptTables::~ObjcOptTables(void){
+	}
+	bool ObjcOptTables::Open(const DyldCache& cache){
+		cache_ = &cache;
+		version_ = 0;
+		headers_.clear();
+		const char kLibobjc[] = "/libobjc.A.dylib";
+		const std::vector<DyldCacheImage>& images = cache.images();
+		MachoImage libobjc;
+		const MachoSection* section = NULL;
+		for(size_t index=0;index<images.size()&&section==NULL;index++){
+			size_t length = strlen(images[index].path);
+			if(length>=sizeof(kLibobjc)-1&&strcmp(images[index].path+length-(sizeof(kLibobjc)-1),kLibobjc)==0&&cache.OpenImage(index,&libobjc)){
+				section = libobjc.FindSection("__objc_opt_ro");
+			}
+		}
+		uint64_t offset;
+		const uint8* header = (section!=NULL&&cache.OffsetOf(section->addr,&offset))?cache.AtOffset(offset,kOptHeaderSize):NULL;
+		if(header==NULL){
+			return false;
+		}
+		uint32 version = Load32(header+kOptVersion);
+		if(version<kMinVersion||version>kMaxVersion){
+			return false;
+		}
+		version_ = version;
+		pointer_size_ = libobjc.is64()?8:4;
+		//12:selopt,headeropt,clsopt 13,14:+protocolopt
+		//15:flags,selopt,headeropt_ro,clsopt,unused,headeropt_rw,protocolopt2
+		size_t selopt = 4;
+		size_t clsopt = 12;
+		size_t protocolopt = (version>=13)?16:0;
+		if(version>=kRelativeHeaderVersion){
+			selopt = 8;
+			clsopt = 16;
+			protocolopt = 28;
+		}
+		int32_t table = static_cast<int32_t>(Load32(header+selopt));
+		if(table!=0){
+			selectors_.Parse(cache,section->addr+table);
+		}
+		table = static_cast<int32_t>(Load32(header+clsopt));
+		if(table!=0){
+			classes_.Parse(cache,section->addr+table);
+		}
+		table = (protocolopt!=0)?static_cast<int32_t>(Load32(header+protocolopt)):0;
+		if(table!=0){
+			protocols_.Parse(cache,section->addr+table);
+		}
+		headers_.reserve(images.size());
+		for(size_t index=0;index<images.size();index++){
+			headers_.push_back(std::make_pair(images[index].address,static_cast<uint32>(index)));
+		}
+		std::sort(headers_.begin(),headers_.end());
+		return true;
+	}
+	uint64_t ObjcOptTables::FindSelector(const char* name) const{
+		uint32 index = selectors_.Find(name);
+		return (index!=ObjcOptStringHash::kNotFound)?selectors_.EntryAddress(index):0;
+	}
+	void ObjcOptTables::FindClass(const char* name,std::vector<OptClass>* classes) const{
+		classes->clear();
+		uint32 index = classes_.Find(name);
+		if(index==ObjcOptStringHash::kNotFound){
+			return;
+		}
+		//objc_classheader_t classOffsets[capacity],uint32 duplicateCount,
+		//objc_classheader_t duplicateOffsets[duplicateCount]
+		uint64_t entry = classes_.end_address()+uint64_t(index)*kClassHeaderSize;
+		int32_t cls_offset;
+		int32_t hi_offset;
+		if(!ReadInt32(entry,&cls_offset)||!ReadInt32(entry+4,&hi_offset)){
+			return;
+		}
+		bool duplicated = (cls_offset&1)!=0;
+		uint32 first = 0;
+		uint32 count = 1;
+		if(duplicated){
+			//clsOffset is count<<1|1 and hiOffset the first duplicate
+			count = static_cast<uint32>(cls_offset)>>1;
+			first = static_cast<uint32>(hi_offset);
+			entry = classes_.end_address()+uint64_t(classes_.capacity())*kClassHeaderSize+4;
+		}
+		for(uint32 position=0;position<count;position++){
+			if(duplicated){
+				uint64_t duplicate = entry+uint64_t(first+position)*kClassHeaderSize;
+				if(!ReadInt32(duplicate,&cls_offset)||!ReadInt32(duplicate+4,&hi_offset)){
+					return;
+				}
+			}
+			OptClass cls;
+			cls.cls = classes_.address()+cls_offset;
+			cls.image = ImageOfHeader(classes_.address()+hi_offset);
+			classes->push_back(cls);
+		}
+	}
+	uint64_t ObjcOptTables::FindProtocol(const char* name) const{
+		uint32 index = protocols_.Find(name);
+		if(index==ObjcOptStringHash::kNotFound){
+			return 0;
+		}
+		int32_t protocol_offset;
+		if(version_<kRelativeHeaderVersion){
+			//uint32 protocolOffsets[capacity]
+			if(!ReadInt32(protocols_.end_address()+uint64_t(index)*4,&protocol_offset)){
+				return 0;
+			}
+			return protocols_.address()+protocol_offset;
+		}
+		//protocolopt2 is laid out like clsopt,a duplicated protocol is
+		//answered with its first definition
+		uint64_t entry = protocols_.end_address()+uint64_t(index)*kClassHeaderSize;
+		int32_t hi_offset;
+		if(!ReadInt32(entry,&protocol_offset)||!ReadInt32(entry+4,&hi_offset)){
+			return 0;
+		}
+		if(protocol_offset&1){
+			entry = protocols_.end_address()+uint64_t(protocols_.capacity())*kClassHeaderSize+4+uint64_t(static_cast<uint32>(hi_offset))*kClassHeaderSize;
+			if(!ReadInt32(entry,&protocol_offset)){
+				return 0;
+			}
+		}
+		return protocols_.address()+protocol_offset;
+	}
+	uint32 ObjcOptTables::ImageOfHeader(uint64_t header_info) const{
+		uint64_t mhdr;
+		if(version_>=kRelativeHeaderVersion){
+			//header_info_ro.mhdr_offset is relative to itself
+			uint64_t relative;
+			if(!ReadPointer(header_info,&relative)){
+				return ObjcOptStringHash::kNotFound;
+			}
+			if(pointer_size_==4){
+				relative = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(relative)));
+			}
+			mhdr = header_info+relative;
+		}
+		//header_info.next comes first,then the absolute mach header
+		else if(!ReadPointer(header_info+pointer_size_,&mhdr)){
+			return ObjcOptStringHash::kNotFound;
+		}
+		std::vector<std::pair<uint64_t,uint32> >::const_iterator it = std::lower_bound(headers_.begin(),headers_.end(),std::make_pair(mhdr,uint32(0)));
+		return (it!=headers_.end()&&it->first==mhdr)?it->second:ObjcOptStringHash::kNotFound;
+	}
+	bool ObjcOptTables::ReadInt32(uint64_t vmaddr,int32_t* value) const{
+		uint64_t offset;
+		const uint8* p = cache_->OffsetOf(vmaddr,&offset)?cache_->AtOffset(offset,4):NULL;
+		if(p==NULL){
+			return false;
+		}
+		*value = static_cast<int32_t>(Load32(p));
+		return true;
+	}
+	bool ObjcOptTables::ReadPointer(uint64_t vmaddr,uint64_t* value) const{
+		uint64_t offset;
+		const uint8* p = cache_->OffsetOf(vmaddr,&offset)?cache_->AtOffset(offset,pointer_size_):NULL;
+		if(p==NULL){
+			return false;
+		}
+		*value = (pointer_size_==8)?Load64(p):Load32(p);
+		return true;
+	}
+}
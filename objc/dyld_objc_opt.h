@@ -0,0 +1,106 @@
+#ifndef OBJC_DYLD_OBJC_OPT_H_
+#define OBJC_DYLD_OBJC_OPT_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <utility>
+#include <vector>
+#include "objc/dyld_cache.h"
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:the layouts follow objc_opt_t,objc_stringhash_t and
+//objc_clsopt_t of libobjc's objc-shared-cache.h,versions 12 to 15
+namespace objc{
+	//objc_stringhash_t:a perfect hash built by the cache builder,a lookup is
+	//one hash,one check byte and one strcmp
+	class ObjcOptStringHash
+	{
+	public:
+		enum{
+			kNotFound = 0xFFFFFFFF
+		};
+		ObjcOptStringHash(void);
+		//vmaddr is the address of the table,entries are relative to it
+		bool Parse(const DyldCache& cache,uint64_t vmaddr);
+		uint32 Find(const char* key) const;
+		//address of the table plus the offset stored for index
+		uint64_t EntryAddress(uint32 index) const;
+		uint32 capacity() const{
+			return capacity_;
+		}
+		uint32 occupied() const{
+			return occupied_;
+		}
+		uint64_t address() const{
+			return vmaddr_;
+		}
+		//first byte after the offsets,where derived tables keep their arrays
+		uint64_t end_address() const{
+			return vmaddr_+end_;
+		}
+	private:
+		static uint64_t Hash(const uint8* key,size_t length,uint64_t level);
+		const DyldCache* cache_;
+		const uint8* base_;
+		uint64_t vmaddr_;
+		uint32 capacity_;
+		uint32 occupied_;
+		uint32 shift_;
+		uint32 mask_;
+		uint64_t salt_;
+		const uint8* scramble_;
+		const uint8* tab_;
+		const uint8* checkbytes_;
+		const uint8* offsets_;
+		uint64_t end_;
+	};
+	//the selector,class and protocol tables libobjc keeps preoptimized in
+	//__objc_opt_ro,read in place instead of scanning every image
+	class ObjcOptTables
+	{
+	public:
+		struct OptClass
+		{
+			uint64_t cls;
+			//index into DyldCache::images,ObjcOptStringHash::kNotFound if unknown
+			uint32 image;
+		};
+		ObjcOptTables(void);
+		~ObjcOptTables(void);
+		//false if the cache has no libobjc or an objc_opt_t version this does not know
+		bool Open(const DyldCache& cache);
+		uint32 version() const{
+			return version_;
+		}
+		//address of the uniqued selector string,0 if the cache has none
+		uint64_t FindSelector(const char* name) const;
+		//every class_t with that name,more than one when images disagree
+		void FindClass(const char* name,std::vector<OptClass>* classes) const;
+		uint64_t FindProtocol(const char* name) const;
+		const ObjcOptStringHash& selectors() const{
+			return selectors_;
+		}
+		const ObjcOptStringHash& classes() const{
+			return classes_;
+		}
+		const ObjcOptStringHash& protocols() const{
+			return protocols_;
+		}
+	private:
+		//header_info address to the index of its image
+		uint32 ImageOfHeader(uint64_t header_info) const;
+		bool ReadInt32(uint64_t vmaddr,int32_t* value) const;
+		bool ReadPointer(uint64_t vmaddr,uint64_t* value) const;
+		const DyldCache* cache_;
+		uint32 version_;
+		ObjcOptStringHash selectors_;
+		ObjcOptStringHash classes_;
+		ObjcOptStringHash protocols_;
+		uint32 pointer_size_;
+		//mach header address and image index,sorted by address
+		std::vector<std::pair<uint64_t,uint32> > headers_;
+		DISALLOW_EVIL_CONSTRUCTORS(ObjcOptTables);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,590 @@
+#include "objc/macho_image.h"
+#include <string.h>
+#include <algorithm>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace objc{
+	namespace{
+		const uint32 kFatMagic = 0xCAFEBABE;
+		const uint32 kMhMagic = 0xFEEDFACE;
+		const uint32 kMhMagic64 = 0xFEEDFACF;
+		const uint32 kLcSegment = 0x1;
+		const uint32 kLcSegment64 = 0x19;
+		const uint32 kLcDyldInfo = 0x22;
+		const uint32 kLcDyldInfoOnly = 0x80000022;
+		//bind opcodes of mach-o/loader.h,the immediate is in the low nibble
+		const uint8 kBindOpcodeMask = 0xF0;
+		const uint8 kBindImmediateMask = 0x0F;
+		const uint8 kBindDone = 0x00;
+		const uint8 kBindSetDylibOrdinalUleb = 0x20;
+		const uint8 kBindSetSymbol = 0x40;
+		const uint8 kBindSetAddendSleb = 0x60;
+		const uint8 kBindSetSegmentAndOffset = 0x70;
+		const uint8 kBindAddAddrUleb = 0x80;
+		const uint8 kBindDoBind = 0x90;
+		const uint8 kBindDoBindAddAddrUleb = 0xA0;
+		const uint8 kBindDoBindAddAddrScaled = 0xB0;
+		const uint8 kBindDoBindUlebTimesSkipping = 0xC0;
+		const size_t kMachHeaderSize = 28;
+		const size_t kMachHeader64Size = 32;
+		const size_t kSegmentCommandSize = 56;
+		const size_t kSegmentCommand64Size = 72;
+		const size_t kSectionSize = 68;
+		const size_t kSection64Size = 80;
+		const size_t kFatArchSize = 20;
+		//dyld_cache_slide_pointer3:authenticated pointers keep a 32-bit
+		//offset from the cache base,plain ones the tag byte in bits 43..50
+		const uint64_t kSlide3Authenticated = 0x8000000000000000ULL;
+		const uint64_t kSlide3AuthOffsetMask = 0xFFFFFFFFULL;
+		const uint64_t kSlide3PlainTagMask = 0x0007F80000000000ULL;
+		const uint64_t kSlide3PlainValueMask = 0x000007FFFFFFFFFFULL;
+		uint32 Load32(const uint8* p){
+			uint32 value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		uint64_t Load64(const uint8* p){
+			uint64_t value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		uint32 LoadBig32(const uint8* p){
+			return (uint32(p[0])<<24)|(uint32(p[1])<<16)|(uint32(p[2])<<8)|uint32(p[3]);
+		}
+		//false when the number runs past end
+		bool ReadUleb(const uint8** p,const uint8* end,uint64_t* value){
+			uint64_t result = 0;
+			for(uint32 shift=0;*p<end&&shift<64;shift+=7){
+				uint8 byte = *(*p)++;
+				result |= uint64_t(byte&0x7F)<<shift;
+				if((byte&0x80)==0){
+					*value = result;
+					return true;
+				}
+			}
+			return false;
+		}
+		bool BindLess(const MachoBind& left,const MachoBind& right){
+			return left.address<right.address;
+		}
+		void CopyName(char* dst,const uint8* src){
+			memcpy(dst,src,16);
+			dst[16] = '\0';
+		}
+	}
+	MappedFile::MappedFile(void):data_(NULL),size_(0),view_(NULL),view_size_(0),file_size_(0){
+#ifdef _WIN32
+		file_ = INVALID_HANDLE_VALUE;
+		mapping_ = NULL;
+#else
+		fd_ = -1;
+#endif
+	}
+	MappedFile::~MappedFile(void){
+		Close();
+	}
+	bool MappedFile::Open(const std::string& path){
+		return OpenView(path,0,~uint64_t(0));
+	}
+	bool MappedFile::OpenView(const std::string& path,uint64_t offset,uint64_t size){
+		Close();
+#ifdef _WIN32
+		file_ = CreateFileA(path.c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+		if(file_==INVALID_HANDLE_VALUE){
+			return false;
+		}
+		LARGE_INTEGER file_size;
+		if(!GetFileSizeEx(file_,&file_size)){
+			Close();
+			return false;
+		}
+		file_size_ = static_cast<uint64_t>(file_size.QuadPart);
+		SYSTEM_INFO system;
+		GetSystemInfo(&system);
+		uint64_t granularity = system.dwAllocationGranularity;
+#else
+		fd_ = open(path.c_str(),O_RDONLY);
+		if(fd_<0){
+			return false;
+		}
+		struct stat st;
+		if(fstat(fd_,&st)!=0){
+			Close();
+			return false;
+		}
+		file_size_ = static_cast<uint64_t>(st.st_size);
+		uint64_t granularity = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+		//the view is clamped to the file,the mapping starts on a granularity
+		//boundary and data_ points past the head of it
+		if(offset>=file_size_){
+			Close();
+			return false;
+		}
+		if(size>file_size_-offset){
+			size = file_size_-offset;
+		}
+		uint64_t view_offset = offset-offset%granularity;
+		uint64_t view_size = size+(offset-view_offset);
+		if(view_size!=static_cast<size_t>(view_size)){
+			Close();
+			return false;
+		}
+#ifdef _WIN32
+		mapping_ = CreateFileMappingA(file_,NULL,PAGE_READONLY,0,0,NULL);
+		if(mapping_==NULL){
+			Close();
+			return false;
+		}
+		void* addr = MapViewOfFile(mapping_,FILE_MAP_READ,static_cast<DWORD>(view_offset>>32),static_cast<DWORD>(view_offset),static_cast<size_t>(view_size));
+		if(addr==NULL){
+			Close();
+			return false;
+		}
+#else
+		void* addr = mmap(NULL,static_cast<size_t>(view_size),PROT_READ,MAP_PRIVATE,fd_,static_cast<off_t>(view_offset));
+		if(addr==MAP_FAILED){
+			Close();
+			return false;
+		}
+#endif
+		view_ = reinterpret_cast<const uint8*>(addr);
+		view_size_ = static_cast<size_t>(view_size);
+		data_ = view_+(offset-view_offset);
+		size_ = static_cast<size_t>(size);
+		return true;
+	}
+	void MappedFile::Close(){
+#ifdef _WIN32
+		if(view_!=NULL){
+			UnmapViewOfFile(view_);
+		}
+		if(mapping_!=NULL){
+			CloseHandle(mapping_);
+			mapping_ = NULL;
+		}
+		if(file_!=INVALID_HANDLE_VALUE){
+			CloseHandle(file_);
+			file_ = INVALID_HANDLE_VALUE;
+		}
+#else
+		if(view_!=NULL){
+			munmap(const_cast<uint8*>(view_),view_size_);
+		}
+		if(fd_>=0){
+			close(fd_);
+			fd_ = -1;
+		}
+#endif
+		view_ = NULL;
+		view_size_ = 0;
+		data_ = NULL;
+		size_ = 0;
+		file_size_ = 0;
+	}
+	MachoImage::MachoImage(void):data_(NULL),size_(0),slice_data_(NULL),slice_size_(0),header_offset_(0),fallback_segments_(NULL),pointer_format_(NULL),is64_(false),swapped_(false),cputype_(0),flags_(0),bind_offset_(0),bind_size_(0){
+	}
+	MachoImage::~MachoImage(void){
+	}
+	bool MachoImage::Parse(const uint8* data,size_t size){
+		data_ = data;
+		size_ = size;
+		slices_.clear();
+		if(data==NULL||size<8){
+			return false;
+		}
+		if(LoadBig32(data)==kFatMagic){
+			uint32 count = LoadBig32(data+4);
+			if(count==0||count>(size-8)/kFatArchSize){
+				return false;
+			}
+			for(uint32 index=0;index<count;index++){
+				const uint8* arch = data+8+index*kFatArchSize;
+				MachoSlice slice;
+				slice.cputype = LoadBig32(arch);
+				slice.cpusubtype = LoadBig32(arch+4);
+				slice.offset = LoadBig32(arch+8);
+				slice.size = LoadBig32(arch+12);
+				if(slice.offset>size||slice.size>size-slice.offset){
+					continue;
+				}
+				slices_.push_back(slice);
+			}
+		}
+		else{
+			MachoSlice slice;
+			slice.cputype = 0;
+			slice.cpusubtype = 0;
+			slice.offset = 0;
+			slice.size = size;
+			slices_.push_back(slice);
+		}
+		for(size_t index=0;index<slices_.size();index++){
+			if(SelectSlice(index)){
+				return true;
+			}
+		}
+		return false;
+	}
+	bool MachoImage::SelectSlice(size_t index){
+		if(index>=slices_.size()){
+			return false;
+		}
+		slice_data_ = data_+slices_[index].offset;
+		slice_size_ = static_cast<size_t>(slices_[index].size);
+		header_offset_ = 0;
+		return ParseHeader();
+	}
+	bool MachoImage::ParseAt(const uint8* data,size_t size,uint64_t header_offset){
+		data_ = data;
+		size_ = size;
+		slices_.clear();
+		if(data==NULL||header_offset>=size){
+			return false;
+		}
+		MachoSlice slice;
+		slice.cputype = 0;
+		slice.cpusubtype = 0;
+		slice.offset = 0;
+		slice.size = size;
+		slices_.push_back(slice);
+		slice_data_ = data;
+		slice_size_ = size;
+		header_offset_ = header_offset;
+		return ParseHeader();
+	}
+	bool MachoImage::SelectCpu(uint32 cputype){
+		for(size_t index=0;index<slices_.size();index++){
+			if(SelectSlice(index)&&cputype_==cputype){
+				return true;
+			}
+		}
+		return false;
+	}
+	uint32 MachoImage::Swap32(uint32 value) const{
+		if(!swapped_){
+			return value;
+		}
+		return (value>>24)|((value>>8)&0xFF00)|((value<<8)&0xFF0000)|(value<<24);
+	}
+	uint64_t MachoImage::Swap64(uint64_t value) const{
+		if(!swapped_){
+			return value;
+		}
+		return (uint64_t(Swap32(uint32(value)))<<32)|Swap32(uint32(value>>32));
+	}
+	bool MachoImage::ParseHeader(){
+		segments_.clear();
+		sections_.clear();
+		bind_offset_ = 0;
+		bind_size_ = 0;
+		if(slice_size_-header_offset_<kMachHeaderSize){
+			return false;
+		}
+		const uint8* header = slice_data_+header_offset_;
+		uint32 magic = Load32(header);
+		if(magic==kMhMagic||magic==kMhMagic64){
+			swapped_ = false;
+		}
+		else{
+			swapped_ = true;
+			magic = Swap32(magic);
+			if(magic!=kMhMagic&&magic!=kMhMagic64){
+				return false;
+			}
+		}
+		is64_ = (magic==kMhMagic64);
+		cputype_ = Swap32(Load32(header+4));
+		flags_ = Swap32(Load32(header+24));
+		uint32 ncmds = Swap32(Load32(header+16));
+		uint32 sizeofcmds = Swap32(Load32(header+20));
+		size_t header_size = is64_?kMachHeader64Size:kMachHeaderSize;
+		if(header_size+size_t(sizeofcmds)>slice_size_-header_offset_){
+			return false;
+		}
+		const uint8* cmd = header+header_size;
+		const uint8* cmds_end = cmd+sizeofcmds;
+		for(uint32 index=0;index<ncmds;index++){
+			if(cmd+8>cmds_end){
+				return false;
+			}
+			uint32 cmd_id = Swap32(Load32(cmd));
+			uint32 cmd_size = Swap32(Load32(cmd+4));
+			if(cmd_size<8||cmd+cmd_size>cmds_end){
+				return false;
+			}
+			if(cmd_id==kLcSegment||cmd_id==kLcSegment64){
+				bool seg64 = (cmd_id==kLcSegment64);
+				size_t seg_size = seg64?kSegmentCommand64Size:kSegmentCommandSize;
+				size_t sect_size = seg64?kSection64Size:kSectionSize;
+				if(cmd_size<seg_size){
+					return false;
+				}
+				MachoSegment segment;
+				CopyName(segment.segname,cmd+8);
+				const uint8* field = cmd+24;
+				uint32 nsects;
+				if(seg64){
+					segment.vmaddr = Swap64(Load64(field));
+					segment.vmsize = Swap64(Load64(field+8));
+					segment.fileoff = Swap64(Load64(field+16));
+					segment.filesize = Swap64(Load64(field+24));
+					segment.maxprot = Swap32(Load32(field+32));
+					segment.initprot = Swap32(Load32(field+36));
+					nsects = Swap32(Load32(field+40));
+				}
+				else{
+					segment.vmaddr = Swap32(Load32(field));
+					segment.vmsize = Swap32(Load32(field+4));
+					segment.fileoff = Swap32(Load32(field+8));
+					segment.filesize = Swap32(Load32(field+12));
+					segment.maxprot = Swap32(Load32(field+16));
+					segment.initprot = Swap32(Load32(field+20));
+					nsects = Swap32(Load32(field+24));
+				}
+				if(seg_size+size_t(nsects)*sect_size>cmd_size){
+					return false;
+				}
+				segments_.push_back(segment);
+				const uint8* sect = cmd+seg_size;
+				for(uint32 sindex=0;sindex<nsects;sindex++,sect+=sect_size){
+					MachoSection section;
+					CopyName(section.sectname,sect);
+					CopyName(section.segname,sect+16);
+					if(seg64){
+						section.addr = Swap64(Load64(sect+32));
+						section.size = Swap64(Load64(sect+40));
+						section.offset = Swap32(Load32(sect+48));
+						section.flags = Swap32(Load32(sect+64));
+					}
+					else{
+						section.addr = Swap32(Load32(sect+32));
+						section.size = Swap32(Load32(sect+36));
+						section.offset = Swap32(Load32(sect+40));
+						section.flags = Swap32(Load32(sect+56));
+					}
+					sections_.push_back(section);
+				}
+			}
+			else if((cmd_id==kLcDyldInfo||cmd_id==kLcDyldInfoOnly)&&cmd_size>=24){
+				bind_offset_ = Swap32(Load32(cmd+16));
+				bind_size_ = Swap32(Load32(cmd+20));
+			}
+			cmd += cmd_size;
+		}
+		return true;
+	}
+	const MachoSection* MachoImage::FindSection(const char* segname,const char* sectname) const{
+		for(std::vector<MachoSection>::const_iterator it = sections_.begin();it!=sections_.end();++it){
+			if(!strcmp(it->segname,segname)&&!strcmp(it->sectname,sectname)){
+				return &*it;
+			}
+		}
+		return NULL;
+	}
+	const MachoSection* MachoImage::FindSection(const char* sectname) const{
+		for(std::vector<MachoSection>::const_iterator it = sections_.begin();it!=sections_.end();++it){
+			if(!strcmp(it->sectname,sectname)){
+				return &*it;
+			}
+		}
+		return NULL;
+	}
+	const MachoSegment* MachoImage::FindSegment(const char* segname) const{
+		for(std::vector<MachoSegment>::const_iterator it = segments_.begin();it!=segments_.end();++it){
+			if(!strcmp(it->segname,segname)){
+				return &*it;
+			}
+		}
+		return NULL;
+	}
+	const MachoSegment* MachoImage::FindMappedSegment(uint64_t vmaddr) const{
+		for(std::vector<MachoSegment>::const_iterator it = segments_.begin();it!=segments_.end();++it){
+			if(vmaddr>=it->vmaddr&&vmaddr-it->vmaddr<it->filesize){
+				return &*it;
+			}
+		}
+		if(fallback_segments_!=NULL){
+			for(std::vector<MachoSegment>::const_iterator it = fallback_segments_->begin();it!=fallback_segments_->end();++it){
+				if(vmaddr>=it->vmaddr&&vmaddr-it->vmaddr<it->filesize){
+					return &*it;
+				}
+			}
+		}
+		return NULL;
+	}
+	const uint8* MachoImage::At(uint64_t vmaddr,size_t len) const{
+		const MachoSegment* segment = FindMappedSegment(vmaddr);
+		if(segment==NULL){
+			return NULL;
+		}
+		uint64_t delta = vmaddr-segment->vmaddr;
+		if(len>segment->filesize-delta){
+			return NULL;
+		}
+		return AtOffset(segment->fileoff+delta,len);
+	}
+	const uint8* MachoImage::AtOffset(uint64_t offset,size_t len) const{
+		if(offset>slice_size_||len>slice_size_-offset){
+			return NULL;
+		}
+		return slice_data_+offset;
+	}
+	uint32 MachoImage::Decode32(const uint8* p) const{
+		return Swap32(Load32(p));
+	}
+	uint64_t MachoImage::Decode64(const uint8* p) const{
+		return Swap64(Load64(p));
+	}
+	bool MachoImage::ReadU32(uint64_t vmaddr,uint32* value) const{
+		const uint8* p = At(vmaddr,sizeof(uint32));
+		if(p==NULL){
+			return false;
+		}
+		*value = Swap32(Load32(p));
+		return true;
+	}
+	bool MachoImage::ReadU64(uint64_t vmaddr,uint64_t* value) const{
+		const uint8* p = At(vmaddr,sizeof(uint64_t));
+		if(p==NULL){
+			return false;
+		}
+		*value = Swap64(Load64(p));
+		return true;
+	}
+	bool MachoImage::ReadPtr(uint64_t vmaddr,uint64_t* value) const{
+		if(is64_){
+			if(!ReadU64(vmaddr,value)){
+				return false;
+			}
+			*value = Target(*value);
+			return true;
+		}
+		uint32 value32 = 0;
+		if(!ReadU32(vmaddr,&value32)){
+			return false;
+		}
+		*value = value32;
+		return true;
+	}
+	uint64_t MachoImage::DecodeTarget(uint64_t stored) const{
+		if(pointer_format_->version==MachoPointerFormat::kSlideInfoV2){
+			//a null pointer is not rebased and stays null
+			uint64_t value = stored&pointer_format_->value_mask;
+			return (value!=0)?value+pointer_format_->value_add:0;
+		}
+		if(pointer_format_->version==MachoPointerFormat::kSlideInfoV3){
+			if((stored&kSlide3Authenticated)!=0){
+				return (stored&kSlide3AuthOffsetMask)+pointer_format_->value_add;
+			}
+			return ((stored&kSlide3PlainTagMask)<<13)|(stored&kSlide3PlainValueMask);
+		}
+		return stored;
+	}
+	const char* MachoImage::ReadCString(uint64_t vmaddr) const{
+		const MachoSegment* segment = FindMappedSegment(vmaddr);
+		if(segment==NULL){
+			return NULL;
+		}
+		uint64_t delta = vmaddr-segment->vmaddr;
+		size_t len = static_cast<size_t>(segment->filesize-delta);
+		const uint8* p = AtOffset(segment->fileoff+delta,0);
+		if(p==NULL){
+			return NULL;
+		}
+		if(len>slice_size_-static_cast<size_t>(p-slice_data_)){
+			len = slice_size_-static_cast<size_t>(p-slice_data_);
+		}
+		if(memchr(p,0,len)==NULL){
+			return NULL;
+		}
+		return reinterpret_cast<const char*>(p);
+	}
+	void MachoImage::CollectBinds(std::vector<MachoBind>* binds) const{
+		if((flags_&kMhDylibInCache)!=0||bind_size_==0){
+			return;
+		}
+		const uint8* p = AtOffset(bind_offset_,bind_size_);
+		if(p==NULL){
+			return;
+		}
+		const uint8* end = p+bind_size_;
+		uint64_t ptr_size = pointer_size();
+		uint64_t address = 0;
+		uint64_t value = 0;
+		uint64_t skip = 0;
+		bool mapped = false;
+		MachoBind bind = {0,NULL};
+		size_t first = binds->size();
+		while(p<end){
+			uint8 opcode = *p&kBindOpcodeMask;
+			uint8 immediate = *p&kBindImmediateMask;
+			p++;
+			uint64_t count = 1;
+			switch(opcode){
+			case kBindDone:
+				p = end;
+				continue;
+			case kBindSetDylibOrdinalUleb:
+			case kBindSetAddendSleb:
+				//the sleb ends like an uleb,neither value matters here
+				if(!ReadUleb(&p,end,&value)){
+					p = end;
+				}
+				continue;
+			case kBindSetSymbol:
+				bind.symbol = reinterpret_cast<const char*>(p);
+				p = static_cast<const uint8*>(memchr(p,0,end-p));
+				p = (p!=NULL)?p+1:end;
+				continue;
+			case kBindSetSegmentAndOffset:
+				mapped = (immediate<segments_.size()&&ReadUleb(&p,end,&value));
+				address = mapped?segments_[immediate].vmaddr+value:0;
+				continue;
+			case kBindAddAddrUleb:
+				if(ReadUleb(&p,end,&value)){
+					address += value;
+				}
+				continue;
+			case kBindDoBind:
+				skip = 0;
+				break;
+			case kBindDoBindAddAddrUleb:
+				if(!ReadUleb(&p,end,&skip)){
+					p = end;
+				}
+				break;
+			case kBindDoBindAddAddrScaled:
+				skip = immediate*ptr_size;
+				break;
+			case kBindDoBindUlebTimesSkipping:
+				if(!ReadUleb(&p,end,&count)||!ReadUleb(&p,end,&skip)){
+					p = end;
+					count = 0;
+				}
+				break;
+			default:
+				//ordinal and type immediates need nothing,threaded binds of
+				//arm64e end what can be followed
+				if(opcode>kBindDoBindUlebTimesSkipping){
+					p = end;
+				}
+				continue;
+			}
+			//a count from a broken stream cannot run past the segment
+			for(;count!=0&&mapped&&bind.symbol!=NULL&&FindMappedSegment(address)!=NULL;count--){
+				bind.address = address;
+				binds->push_back(bind);
+				address += ptr_size+skip;
+			}
+		}
+		std::sort(binds->begin()+first,binds->end(),BindLess);
+	}
+}
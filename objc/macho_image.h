@@ -0,0 +1,217 @@
+#ifndef OBJC_MACHO_IMAGE_H_
+#define OBJC_MACHO_IMAGE_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:the image and the parser built on it are also used
+//outside of ida by the standalone tools
+namespace objc{
+	//read-only mapping of a file or of a part of it
+	class MappedFile
+	{
+	public:
+		MappedFile(void);
+		~MappedFile(void);
+		bool Open(const std::string& path);
+		//size bytes from offset,fewer at the end of the file.data() is the
+		//byte at offset.keeps the 32-bit plugin from mapping all of a cache
+		bool OpenView(const std::string& path,uint64_t offset,uint64_t size);
+		void Close();
+		const uint8* data() const{
+			return data_;
+		}
+		size_t size() const{
+			return size_;
+		}
+		uint64_t file_size() const{
+			return file_size_;
+		}
+	private:
+		const uint8* data_;
+		size_t size_;
+		//the mapping,aligned down to the allocation granularity
+		const uint8* view_;
+		size_t view_size_;
+		uint64_t file_size_;
+#ifdef _WIN32
+		void* file_;
+		void* mapping_;
+#else
+		int fd_;
+#endif
+		DISALLOW_EVIL_CONSTRUCTORS(MappedFile);
+	};
+	struct MachoSection
+	{
+		char segname[17];
+		char sectname[17];
+		uint64_t addr;
+		uint64_t size;
+		uint32 offset;
+		uint32 flags;
+	};
+	struct MachoSegment
+	{
+		char segname[17];
+		uint64_t vmaddr;
+		uint64_t vmsize;
+		uint64_t fileoff;
+		uint64_t filesize;
+		uint32 maxprot;
+		uint32 initprot;
+	};
+	//a pointer dyld fills with the address of symbol from another image
+	struct MachoBind
+	{
+		uint64_t address;
+		//inside the mapped file
+		const char* symbol;
+	};
+	//how the pointers of a dyld cache image store their target.slide info
+	//v2 (arm64,x86_64) keeps the delta to the next rebase in the high bits,
+	//v3 (arm64e) packs the tag byte or,for authenticated pointers,an offset
+	//from the cache base
+	struct MachoPointerFormat
+	{
+		enum{
+			kSlideInfoV2 = 2,
+			kSlideInfoV3 = 3
+		};
+		uint32 version;
+		//v2:~delta_mask
+		uint64_t value_mask;
+		//v2:value_add,v3:auth_value_add
+		uint64_t value_add;
+	};
+	struct MachoSlice
+	{
+		uint32 cputype;
+		uint32 cpusubtype;
+		uint64_t offset;
+		uint64_t size;
+	};
+	//bounds-checked view over one mach-o image inside a buffer,the buffer
+	//may be a thin file or a fat file whose slice is picked by SelectSlice
+	class MachoImage
+	{
+	public:
+		enum{
+			kCpuTypeX86 = 7,
+			kCpuTypeArm = 12,
+			kCpuArch64 = 0x01000000,
+			kCpuTypeX86_64 = kCpuTypeX86|kCpuArch64,
+			kCpuTypeArm64 = kCpuTypeArm|kCpuArch64,
+			//mach header flag of images linked into a dyld shared cache
+			kMhDylibInCache = 0x80000000
+		};
+		MachoImage(void);
+		~MachoImage(void);
+		//parses the fat header if any and selects the first slice
+		bool Parse(const uint8* data,size_t size);
+		const std::vector<MachoSlice>& slices() const{
+			return slices_;
+		}
+		bool SelectSlice(size_t index);
+		//image inside a dyld shared cache:the header is at header_offset and
+		//segment file offsets are relative to data
+		bool ParseAt(const uint8* data,size_t size,uint64_t header_offset);
+		//searched by At and ReadCString when an address is outside the image,
+		//for pointers from a cached image into the rest of the cache.not owned
+		void set_fallback_segments(const std::vector<MachoSegment>* segments){
+			fallback_segments_ = segments;
+		}
+		//set for images of a dyld cache with slide info,NULL stores plain
+		//pointers.not owned
+		void set_pointer_format(const MachoPointerFormat* format){
+			pointer_format_ = format;
+		}
+		const MachoPointerFormat* pointer_format() const{
+			return pointer_format_;
+		}
+		//vm address a stored 64-bit pointer refers to
+		uint64_t Target(uint64_t stored) const{
+			return (pointer_format_==NULL)?stored:DecodeTarget(stored);
+		}
+		bool SelectCpu(uint32 cputype);
+		bool is64() const{
+			return is64_;
+		}
+		bool swapped() const{
+			return swapped_;
+		}
+		uint32 cputype() const{
+			return cputype_;
+		}
+		uint32 flags() const{
+			return flags_;
+		}
+		const std::vector<MachoSegment>& segments() const{
+			return segments_;
+		}
+		const std::vector<MachoSection>& sections() const{
+			return sections_;
+		}
+		const MachoSection* FindSection(const char* segname,const char* sectname) const;
+		//first section with this name in any segment
+		const MachoSection* FindSection(const char* sectname) const;
+		const MachoSegment* FindSegment(const char* segname) const;
+		//pointer to len bytes at a vm address,NULL if they are not all backed by file data
+		const uint8* At(uint64_t vmaddr,size_t len) const;
+		//file bytes of the selected slice,offsets are slice relative
+		const uint8* AtOffset(uint64_t offset,size_t len) const;
+		bool ReadU32(uint64_t vmaddr,uint32* value) const;
+		bool ReadU64(uint64_t vmaddr,uint64_t* value) const;
+		bool ReadPtr(uint64_t vmaddr,uint64_t* value) const;
+		//decode fields of a buffer returned by At
+		uint32 Decode32(const uint8* p) const;
+		uint64_t Decode64(const uint8* p) const;
+		uint64_t DecodePtr(const uint8* p) const{
+			return is64_?Target(Decode64(p)):Decode32(p);
+		}
+		//NUL terminated string fully inside its segment,NULL otherwise
+		const char* ReadCString(uint64_t vmaddr) const;
+		//the binds of the LC_DYLD_INFO bind opcodes by address.images with
+		//chained fixups or only external relocations have none,images of a
+		//shared cache are bound already
+		void CollectBinds(std::vector<MachoBind>* binds) const;
+		uint32 pointer_size() const{
+			return is64_?8:4;
+		}
+		const uint8* slice_data() const{
+			return slice_data_;
+		}
+		size_t slice_size() const{
+			return slice_size_;
+		}
+	private:
+		bool ParseHeader();
+		const MachoSegment* FindMappedSegment(uint64_t vmaddr) const;
+		uint32 Swap32(uint32 value) const;
+		uint64_t Swap64(uint64_t value) const;
+		uint64_t DecodeTarget(uint64_t stored) const;
+		const uint8* data_;
+		size_t size_;
+		const uint8* slice_data_;
+		size_t slice_size_;
+		uint64_t header_offset_;
+		const std::vector<MachoSegment>* fallback_segments_;
+		const MachoPointerFormat* pointer_format_;
+		bool is64_;
+		bool swapped_;
+		uint32 cputype_;
+		uint32 flags_;
+		//bind opcode stream of LC_DYLD_INFO,slice relative
+		uint32 bind_offset_;
+		uint32 bind_size_;
+		std::vector<MachoSlice> slices_;
+		std::vector<MachoSegment> segments_;
+		std::vector<MachoSection> sections_;
+		DISALLOW_EVIL_CONSTRUCTORS(MachoImage);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
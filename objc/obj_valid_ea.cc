@@ -1,20 +1,93 @@
 #include "objc/obj_valid_ea.h"
 #include <ida.hpp>
-#include <funcs.hpp>
+#include <segment.hpp>
 #include <kernwin.hpp>
+#include <string.h>
 
 namespace objc{
-	const unsigned long kMaxBuferLength = 1024;
+	namespace{
+		uint32 SegmentFlags(segment_t* seg,const char* name){
+			uint32 flags = 0;
+			//no permission information means everything is allowed
+			uchar perm = (seg->perm!=0)?seg->perm:(SEGPERM_READ|SEGPERM_WRITE|SEGPERM_EXEC);
+			if(perm&SEGPERM_READ){
+				flags |= SegmentIntervals::kAddressRead;
+			}
+			if(perm&SEGPERM_WRITE){
+				flags |= SegmentIntervals::kAddressWrite;
+			}
+			if(perm&SEGPERM_EXEC){
+				flags |= SegmentIntervals::kAddressExec;
+			}
+			if(seg->type==SEG_CODE){
+				flags |= SegmentIntervals::kAddressCode;
+			}
+			else if(seg->type==SEG_DATA||seg->type==SEG_BSS){
+				flags |= SegmentIntervals::kAddressData;
+			}
+			if(!strncmp(name,"__objc_",7)||!strncmp(name,"__OBJC",6)){
+				flags |= SegmentIntervals::kAddressObjc;
+			}
+			return flags;
+		}
+	}
+	SegmentIntervals ObjcValidEA::intervals_;
+	SegmentIntervals::SegmentIntervals(void):built_(false){
+	}
+	SegmentIntervals::~SegmentIntervals(void){
+	}
+	void SegmentIntervals::Build(){
+		Release();
+		//getnseg returns the segments sorted by address
+		int seg_num = get_segm_qty();
+		for(int index=0;index<seg_num;index++){
+			segment_t* seg = getnseg(index);
+			if(seg==NULL||seg->endEA<=seg->startEA||seg->type==SEG_NULL){
+				continue;
+			}
+			char seg_name[1024] = {0};
+			get_true_segm_name(seg,seg_name,1024);
+			if(!strcmp(seg_name,"__LINKEDIT")){
+				continue;
+			}
+			uint32 flags = SegmentFlags(seg,seg_name);
+			if(!ends_.empty()&&ends_.back()==seg->startEA&&flags_.back()==flags){
+				ends_.back() = seg->endEA;
+				continue;
+			}
+			starts_.push_back(seg->startEA);
+			ends_.push_back(seg->endEA);
+			flags_.push_back(flags);
+		}
+		built_ = true;
+	}
+	void SegmentIntervals::Release(){
+		std::vector<uint64_t>().swap(starts_);
+		std::vector<uint64_t>().swap(ends_);
+		std::vector<uint32>().swap(flags_);
+		built_ = false;
+	}
 	ObjcValidEA::ObjcValidEA(void){
 	}
 	ObjcValidEA::~ObjcValidEA(void){
 	}
+	void ObjcValidEA::BuildSegmentIntervals(){
+		intervals_.Build();
+		msg("objc: %u valid address intervals\n",static_cast<uint32>(intervals_.size()));
+	}
+	void ObjcValidEA::ReleaseSegmentIntervals(){
+		intervals_.Release();
+	}
 	bool ObjcValidEA::IsValidAddress(uint32 ea){
-		if(inf.minEA <= ea && ea < inf.maxEA){
-			return true;
+		if(!intervals_.built()){
+			return (inf.minEA<=ea&&ea<inf.maxEA);
 		}
-		else{
-			return false;
+		return intervals_.Flags(ea)!=0;
+	}
+	bool ObjcValidEA::IsAddressIn(uint32 ea,uint32 flags){
+		if(!intervals_.built()){
+			return IsValidAddress(ea);
 		}
+		return (intervals_.Flags(ea)&flags)!=0;
 	}
 }
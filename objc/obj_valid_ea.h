@@ -1,18 +1,79 @@
 #ifndef OBJC_OBJCVALIDEA_H_
 #define OBJC_OBJCVALIDEA_H_
 //////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
 #include "thirdparty/glog/basictypes.h"
+#include <vector>
 //////////////////////////////////////////////////////////////////////////
 namespace objc{
+	//the segments of the database as sorted [start,end) intervals,adjacent
+	//segments with the same flags merged.one table serves every ObjcValidEA.
+	//no ida headers here,the header is reached from the decoding layer
+	class SegmentIntervals
+	{
+	public:
+		enum{
+			kAddressRead = 0x1,
+			kAddressWrite = 0x2,
+			kAddressExec = 0x4,
+			kAddressCode = 0x8,
+			kAddressData = 0x10,
+			//__objc_* and __OBJC sections
+			kAddressObjc = 0x20
+		};
+		SegmentIntervals(void);
+		~SegmentIntervals(void);
+		//__LINKEDIT and zero-length segments are left out
+		void Build();
+		void Release();
+		bool built() const{
+			return built_;
+		}
+		//flags of the interval holding ea,0 if ea is in none
+		uint32 Flags(uint64_t ea) const{
+			if(starts_.empty()){
+				return 0;
+			}
+			//branchless lower bound:the loop runs log2(n) times whatever
+			//the answer and the compare compiles to a conditional move
+			const uint64_t* base = &starts_[0];
+			size_t count = starts_.size();
+			while(count>1){
+				size_t half = count/2;
+				base = (base[half]<=ea)?base+half:base;
+				count -= half;
+			}
+			size_t index = base-&starts_[0];
+			return (*base<=ea&&ea<ends_[index])?flags_[index]:0;
+		}
+		size_t size() const{
+			return starts_.size();
+		}
+	private:
+		std::vector<uint64_t> starts_;
+		std::vector<uint64_t> ends_;
+		std::vector<uint32> flags_;
+		bool built_;
+		DISALLOW_EVIL_CONSTRUCTORS(SegmentIntervals);
+	};
 	class ObjcValidEA
 	{
 	public:
 		ObjcValidEA(void);
 		~ObjcValidEA(void);
+		//built at the start of a run and released at its end,outside of a
+		//run IsValidAddress falls back to the database bounds
+		static void BuildSegmentIntervals();
+		static void ReleaseSegmentIntervals();
 	protected:
+		//inside a loaded segment,gaps between segments and __LINKEDIT are not
 		bool IsValidAddress(uint32 ea);
+		//inside a segment with any of flags,see SegmentIntervals
+		bool IsAddressIn(uint32 ea,uint32 flags);
 	private:
+		static SegmentIntervals intervals_;
 		DISALLOW_EVIL_CONSTRUCTORS(ObjcValidEA);
 	};
 }
-#endif
\ No newline at end of file
+#endif
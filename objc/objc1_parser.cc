@@ -0,0 +1,158 @@
+#include "objc/objc1_parser.h"
+#include <algorithm>
+
+namespace objc{
+	namespace{
+		//sizeof(objc_module),the size field of old compilers is not trusted
+		const uint32 kModuleRecordSize = 0x10;
+		//upper bound for sane counts,protects against garbage
+		const uint32 kMaxMethodCount = 0x100000;
+		const uint32 kMaxDefinitionCount = 0x10000;
+		void SortUnique(std::vector<uint64_t>* addresses){
+			std::sort(addresses->begin(),addresses->end());
+			addresses->erase(std::unique(addresses->begin(),addresses->end()),addresses->end());
+		}
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::Read32(uint64_t ea,uint32* value) const{
+		const uint8* p = image_.At(ea,4);
+		if(p==NULL){
+			return false;
+		}
+		*value = Layout::Load32(p);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::ReadModule(uint64_t ea,Objc1Module* module) const{
+		const uint8* p = image_.At(ea,kModuleRecordSize);
+		if(p==NULL){
+			return false;
+		}
+		module->version = Layout::Load32(p+Objc1Layout::kModuleVersion);
+		module->size = Layout::Load32(p+Objc1Layout::kModuleSize);
+		module->name = Layout::Load32(p+Objc1Layout::kModuleName);
+		module->symtab = Layout::Load32(p+Objc1Layout::kModuleSymtab);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::ReadSymtab(uint64_t ea,Objc1Symtab* symtab) const{
+		const uint8* p = image_.At(ea,Objc1Layout::kSymtabDefs);
+		if(p==NULL){
+			return false;
+		}
+		symtab->sel_ref_count = Layout::Load32(p+Objc1Layout::kSymtabSelRefCount);
+		symtab->refs = Layout::Load32(p+Objc1Layout::kSymtabRefs);
+		symtab->class_count = Layout::Load16(p+Objc1Layout::kSymtabClassCount);
+		symtab->category_count = Layout::Load16(p+Objc1Layout::kSymtabCategoryCount);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::ReadClass(uint64_t ea,Objc1Class* cls) const{
+		const uint8* p = image_.At(ea,Objc1Layout::kClassSize);
+		if(p==NULL){
+			return false;
+		}
+		cls->isa = Layout::Load32(p+Objc1Layout::kClassIsa);
+		cls->superclass = Layout::Load32(p+Objc1Layout::kClassSuperclass);
+		cls->name = Layout::Load32(p+Objc1Layout::kClassName);
+		cls->version = Layout::Load32(p+Objc1Layout::kClassVersion);
+		cls->info = Layout::Load32(p+Objc1Layout::kClassInfo);
+		cls->instance_size = Layout::Load32(p+Objc1Layout::kClassInstanceSize);
+		cls->ivars = Layout::Load32(p+Objc1Layout::kClassIvars);
+		cls->methods = Layout::Load32(p+Objc1Layout::kClassMethods);
+		cls->cache = Layout::Load32(p+Objc1Layout::kClassCache);
+		cls->protocols = Layout::Load32(p+Objc1Layout::kClassProtocols);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::ReadCategory(uint64_t ea,Objc1Category* category) const{
+		const uint8* p = image_.At(ea,Objc1Layout::kCategoryProtocols+4);
+		if(p==NULL){
+			return false;
+		}
+		category->name = Layout::Load32(p+Objc1Layout::kCategoryName);
+		category->class_name = Layout::Load32(p+Objc1Layout::kCategoryClassName);
+		category->instance_methods = Layout::Load32(p+Objc1Layout::kCategoryInstanceMethods);
+		category->class_methods = Layout::Load32(p+Objc1Layout::kCategoryClassMethods);
+		category->protocols = Layout::Load32(p+Objc1Layout::kCategoryProtocols);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::ReadMethodList(uint64_t ea,std::vector<Objc1Method>* methods) const{
+		methods->clear();
+		uint32 count = 0;
+		if(ea==0||!Read32(ea+Objc1Layout::kMethodListCount,&count)||count>kMaxMethodCount){
+			return false;
+		}
+		const uint8* p = image_.At(ea+Objc1Layout::kMethodListEntries,size_t(count)*Objc1Layout::kMethodSize);
+		if(p==NULL){
+			return false;
+		}
+		methods->resize(count);
+		for(uint32 index=0;index<count;index++,p += Objc1Layout::kMethodSize){
+			(*methods)[index].name = Layout::Load32(p+Objc1Layout::kMethodName);
+			(*methods)[index].types = Layout::Load32(p+Objc1Layout::kMethodTypes);
+			(*methods)[index].imp = Layout::Load32(p+Objc1Layout::kMethodImp);
+		}
+		return true;
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::ReadDefinition(uint64_t symtab,uint32 index,uint64_t* definition) const{
+		uint32 value = 0;
+		if(!Read32(symtab+Objc1Layout::kSymtabDefs+uint64_t(index)*4,&value)||value==0){
+			return false;
+		}
+		*definition = value;
+		return true;
+	}
+	template<typename Layout>
+	bool Objc1Parser<Layout>::ReadChain(Objc1Chain* chain) const{
+		const MachoSection* section = image_.FindSection("__OBJC","__module_info");
+		if(section==NULL){
+			return false;
+		}
+		for(uint64_t ea = section->addr;ea+kModuleRecordSize<=section->addr+section->size;ea += kModuleRecordSize){
+			Objc1Module module;
+			Objc1Symtab symtab;
+			if(!ReadModule(ea,&module)){
+				break;
+			}
+			chain->modules.push_back(ea);
+			//a module without classes or categories has no symtab
+			if(module.symtab==0||!ReadSymtab(module.symtab,&symtab)){
+				continue;
+			}
+			chain->symtabs.push_back(module.symtab);
+			uint32 count = symtab.class_count+symtab.category_count;
+			if(count>kMaxDefinitionCount){
+				continue;
+			}
+			for(uint32 index=0;index<count;index++){
+				uint64_t definition = 0;
+				if(!ReadDefinition(module.symtab,index,&definition)){
+					continue;
+				}
+				if(index>=symtab.class_count){
+					chain->categories.push_back(definition);
+					continue;
+				}
+				Objc1Class cls;
+				if(ReadClass(definition,&cls)){
+					chain->classes.push_back(definition);
+					if(cls.isa!=0){
+						chain->metaclasses.push_back(cls.isa);
+					}
+				}
+			}
+		}
+		//the same class may be listed by several modules
+		SortUnique(&chain->symtabs);
+		SortUnique(&chain->classes);
+		SortUnique(&chain->metaclasses);
+		SortUnique(&chain->categories);
+		return true;
+	}
+	template class Objc1Parser<Layout32>;
+	template class Objc1Parser<Layout32BE>;
+	template class Objc1Parser<Layout64>;
+}
@@ -0,0 +1,91 @@
+#ifndef OBJC_OBJC1_PARSER_H_
+#define OBJC_OBJC1_PARSER_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+#include "objc/macho_image.h"
+#include "objc/objc_layout.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//objc1 runtime structures,every field is 32-bit,see Objc1Layout
+	struct Objc1Module
+	{
+		uint32 version;
+		uint32 size;
+		uint32 name;
+		uint32 symtab;
+	};
+	struct Objc1Symtab
+	{
+		uint32 sel_ref_count;
+		uint32 refs;
+		uint32 class_count;
+		uint32 category_count;
+	};
+	struct Objc1Class
+	{
+		uint32 isa;
+		uint32 superclass;
+		uint32 name;
+		uint32 version;
+		uint32 info;
+		uint32 instance_size;
+		uint32 ivars;
+		uint32 methods;
+		uint32 cache;
+		uint32 protocols;
+	};
+	struct Objc1Category
+	{
+		uint32 name;
+		uint32 class_name;
+		uint32 instance_methods;
+		uint32 class_methods;
+		uint32 protocols;
+	};
+	struct Objc1Method
+	{
+		uint32 name;
+		uint32 types;
+		uint32 imp;
+	};
+	//what the __module_info chain leads to:module -> symtab -> class and
+	//category definitions -> metaclasses.sorted,every address once
+	struct Objc1Chain
+	{
+		std::vector<uint64_t> modules;
+		std::vector<uint64_t> symtabs;
+		std::vector<uint64_t> classes;
+		std::vector<uint64_t> metaclasses;
+		std::vector<uint64_t> categories;
+	};
+	//Layout only supplies the byte order,objc1 images are 32-bit
+	template<typename Layout>
+	class Objc1Parser
+	{
+	public:
+		explicit Objc1Parser(const MachoImage& image):image_(image){}
+		~Objc1Parser(void){}
+		bool ReadModule(uint64_t ea,Objc1Module* module) const;
+		bool ReadSymtab(uint64_t ea,Objc1Symtab* symtab) const;
+		bool ReadClass(uint64_t ea,Objc1Class* cls) const;
+		bool ReadCategory(uint64_t ea,Objc1Category* category) const;
+		//objc_method_list:obsolete,count,methods.false if the list is not in the image
+		bool ReadMethodList(uint64_t ea,std::vector<Objc1Method>* methods) const;
+		//the address of definition index of the symtab at ea,classes come first
+		bool ReadDefinition(uint64_t symtab,uint32 index,uint64_t* definition) const;
+		//follows every module of __module_info,false if the image has none
+		bool ReadChain(Objc1Chain* chain) const;
+		const char* ReadString(uint64_t ea) const{
+			return image_.ReadCString(ea);
+		}
+	private:
+		bool Read32(uint64_t ea,uint32* value) const;
+		const MachoImage& image_;
+		DISALLOW_EVIL_CONSTRUCTORS(Objc1Parser);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
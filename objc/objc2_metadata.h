@@ -0,0 +1,100 @@
+#ifndef OBJC_OBJC2_METADATA_H_
+#define OBJC_OBJC2_METADATA_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+#include "objc/objc2_parser.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//walks an image from __objc_classlist,__objc_catlist and __objc_protolist
+	//and reports what it finds to visitor,which provides
+	//  void VisitClass(uint64_t ea,const char* name);
+	//  void VisitMethod(const char* class_name,const char* selector,uint64_t imp,bool class_method);
+	//  void VisitProtocol(uint64_t ea,const char* name);
+	//category methods are reported as methods of the class they extend,
+	//categories on classes of other images are skipped
+	template<typename Layout,typename Visitor>
+	class Objc2MetadataWalker
+	{
+	public:
+		Objc2MetadataWalker(const Objc2Parser<Layout>& parser,Visitor* visitor):parser_(parser),visitor_(visitor){}
+		void Walk(){
+			std::vector<uint64_t> pointers;
+			parser_.ReadPointerList("__objc_classlist",&pointers);
+			for(std::vector<uint64_t>::const_iterator it = pointers.begin();it!=pointers.end();++it){
+				Objc2Class cls;
+				Objc2ClassRo ro;
+				const char* name = parser_.ReadClassName(*it,&cls,&ro);
+				if(name==NULL){
+					continue;
+				}
+				visitor_->VisitClass(*it,name);
+				WalkMethods(ro.base_methods,name,false);
+				Objc2Class meta;
+				Objc2ClassRo meta_ro;
+				if(parser_.ReadClassName(cls.isa,&meta,&meta_ro)!=NULL){
+					WalkMethods(meta_ro.base_methods,name,true);
+				}
+			}
+			pointers.clear();
+			parser_.ReadPointerList("__objc_catlist",&pointers);
+			for(std::vector<uint64_t>::const_iterator it = pointers.begin();it!=pointers.end();++it){
+				Objc2Category category;
+				Objc2Class cls;
+				Objc2ClassRo ro;
+				const char* name = NULL;
+				if(!parser_.ReadCategory(*it,&category)||(name = parser_.ReadClassName(category.cls,&cls,&ro))==NULL){
+					continue;
+				}
+				WalkMethods(category.instance_methods,name,false);
+				WalkMethods(category.class_methods,name,true);
+			}
+			pointers.clear();
+			parser_.ReadPointerList("__objc_protolist",&pointers);
+			for(std::vector<uint64_t>::const_iterator it = pointers.begin();it!=pointers.end();++it){
+				Objc2Protocol protocol;
+				const char* name = NULL;
+				if(parser_.ReadProtocol(*it,&protocol)&&(name = parser_.ReadString(protocol.name))!=NULL){
+					visitor_->VisitProtocol(*it,name);
+				}
+			}
+		}
+	private:
+		void WalkMethods(uint64_t list,const char* class_name,bool class_method){
+			typename Objc2Parser<Layout>::MethodList methods;
+			if(list==0||!parser_.ReadMethodList(list,&methods)){
+				return;
+			}
+			for(uint32 index=0;index<methods.count();index++){
+				Objc2Method method;
+				const char* selector = NULL;
+				if(methods.Get(index,&method)&&(selector = parser_.ReadString(method.name))!=NULL){
+					visitor_->VisitMethod(class_name,selector,method.imp,class_method);
+				}
+			}
+		}
+		const Objc2Parser<Layout>& parser_;
+		Visitor* visitor_;
+		DISALLOW_EVIL_CONSTRUCTORS(Objc2MetadataWalker);
+	};
+	//picks the layout of image
+	template<typename Visitor>
+	void WalkObjc2Metadata(const MachoImage& image,Visitor* visitor){
+		if(image.is64()){
+			Objc2Parser<Layout64> parser(image);
+			Objc2MetadataWalker<Layout64,Visitor>(parser,visitor).Walk();
+		}
+		else if(image.swapped()){
+			Objc2Parser<Layout32BE> parser(image);
+			Objc2MetadataWalker<Layout32BE,Visitor>(parser,visitor).Walk();
+		}
+		else{
+			Objc2Parser<Layout32> parser(image);
+			Objc2MetadataWalker<Layout32,Visitor>(parser,visitor).Walk();
+		}
+	}
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,169 @@
+#include "objc/objc2_parser.h"
+
+namespace objc{
+	namespace{
+		//method_list_t/ivar_list_t keep flag bits next to entsize
+		const uint32 kEntsizeMask = 0x0000FFFC;
+		//upper bound for a sane list,protects against garbage counts
+		const uint32 kMaxListCount = 0x100000;
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadPointer(uint64_t ea,uint64_t* value) const{
+		const uint8* p = image_.At(ea,Layout::kPtrSize);
+		if(p==NULL){
+			return false;
+		}
+		*value = LoadTarget<Layout>(image_,p);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadClass(uint64_t ea,Objc2Class* cls) const{
+		const uint8* p = image_.At(ea,Layout::kClassSize);
+		if(p==NULL){
+			return false;
+		}
+		cls->isa = LoadTarget<Layout>(image_,p+Layout::kClassIsa);
+		cls->superclass = LoadTarget<Layout>(image_,p+Layout::kClassSuperclass);
+		cls->cache = LoadTarget<Layout>(image_,p+Layout::kClassCache);
+		cls->vtable = LoadTarget<Layout>(image_,p+Layout::kClassVtable);
+		cls->data = LoadTarget<Layout>(image_,p+Layout::kClassData);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadClassRo(uint64_t ea,Objc2ClassRo* ro) const{
+		const uint8* p = image_.At(ea,Layout::kRoSize);
+		if(p==NULL){
+			return false;
+		}
+		ro->flags = Layout::Load32(p+Layout::kRoFlags);
+		ro->instance_start = Layout::Load32(p+Layout::kRoInstanceStart);
+		ro->instance_size = Layout::Load32(p+Layout::kRoInstanceSize);
+		ro->ivar_layout = LoadTarget<Layout>(image_,p+Layout::kRoIvarLayout);
+		ro->name = LoadTarget<Layout>(image_,p+Layout::kRoName);
+		ro->base_methods = LoadTarget<Layout>(image_,p+Layout::kRoBaseMethods);
+		ro->base_protocols = LoadTarget<Layout>(image_,p+Layout::kRoBaseProtocols);
+		ro->ivars = LoadTarget<Layout>(image_,p+Layout::kRoIvars);
+		ro->weak_ivar_layout = LoadTarget<Layout>(image_,p+Layout::kRoWeakIvarLayout);
+		ro->base_properties = LoadTarget<Layout>(image_,p+Layout::kRoBaseProperties);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadCategory(uint64_t ea,Objc2Category* category) const{
+		const uint8* p = image_.At(ea,Layout::kCategorySize);
+		if(p==NULL){
+			return false;
+		}
+		category->name = LoadTarget<Layout>(image_,p+Layout::kCategoryName);
+		category->cls = LoadTarget<Layout>(image_,p+Layout::kCategoryClass);
+		category->instance_methods = LoadTarget<Layout>(image_,p+Layout::kCategoryInstanceMethods);
+		category->class_methods = LoadTarget<Layout>(image_,p+Layout::kCategoryClassMethods);
+		category->protocols = LoadTarget<Layout>(image_,p+Layout::kCategoryProtocols);
+		category->instance_properties = LoadTarget<Layout>(image_,p+Layout::kCategoryInstanceProperties);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadProtocol(uint64_t ea,Objc2Protocol* protocol) const{
+		const uint8* p = image_.At(ea,Layout::kProtocolSize);
+		if(p==NULL){
+			return false;
+		}
+		protocol->isa = LoadTarget<Layout>(image_,p+Layout::kProtocolIsa);
+		protocol->name = LoadTarget<Layout>(image_,p+Layout::kProtocolName);
+		protocol->protocols = LoadTarget<Layout>(image_,p+Layout::kProtocolProtocols);
+		protocol->instance_methods = LoadTarget<Layout>(image_,p+Layout::kProtocolInstanceMethods);
+		protocol->class_methods = LoadTarget<Layout>(image_,p+Layout::kProtocolClassMethods);
+		protocol->optional_instance_methods = LoadTarget<Layout>(image_,p+Layout::kProtocolOptInstanceMethods);
+		protocol->optional_class_methods = LoadTarget<Layout>(image_,p+Layout::kProtocolOptClassMethods);
+		return true;
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadList(uint64_t ea,uint32 min_entsize,Objc2ListView* list) const{
+		const uint8* header = image_.At(ea,Layout::kListHeaderSize);
+		if(header==NULL){
+			return false;
+		}
+		uint32 flags = Layout::Load32(header);
+		uint32 entsize = flags&kEntsizeMask;
+		uint32 count = Layout::Load32(header+4);
+		if(entsize<min_entsize||count>kMaxListCount){
+			return false;
+		}
+		//entsize*count can wrap a 32-bit size_t,At would then accept a short
+		//range the entries are read past
+		uint64_t length = uint64_t(entsize)*count;
+		if(length>image_.slice_size()){
+			return false;
+		}
+		const uint8* base = image_.At(ea+Layout::kListHeaderSize,size_t(length));
+		if(base==NULL){
+			return false;
+		}
+		list->image_ = &image_;
+		list->base_ = base;
+		list->ea_ = ea+Layout::kListHeaderSize;
+		list->entsize_ = entsize;
+		list->count_ = count;
+		list->flags_ = flags&~kEntsizeMask;
+		return true;
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadMethodList(uint64_t ea,MethodList* list) const{
+		if(Layout::kRelativeMethods){
+			const uint8* header = image_.At(ea,Layout::kListHeaderSize);
+			if(header!=NULL&&(Layout::Load32(header)&MethodList::kRelativeFlag)!=0){
+				return ReadList(ea,Layout::kRelativeMethodSize,list);
+			}
+		}
+		return ReadList(ea,Layout::kMethodSize,list);
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadIvarList(uint64_t ea,IvarList* list) const{
+		return ReadList(ea,Layout::kIvarEntrySize,list);
+	}
+	template<typename Layout>
+	bool Objc2Parser<Layout>::ReadProtocolList(uint64_t ea,ProtocolList* list) const{
+		uint64_t count = 0;
+		if(!ReadPointer(ea,&count)||count>kMaxListCount){
+			return false;
+		}
+		uint64_t length = count*Layout::kPtrSize;
+		if(length>image_.slice_size()){
+			return false;
+		}
+		const uint8* base = image_.At(ea+Layout::kPtrSize,size_t(length));
+		if(base==NULL){
+			return false;
+		}
+		list->image_ = &image_;
+		list->base_ = base;
+		list->ea_ = ea+Layout::kPtrSize;
+		list->entsize_ = Layout::kPtrSize;
+		list->count_ = static_cast<uint32>(count);
+		list->flags_ = 0;
+		return true;
+	}
+	template<typename Layout>
+	void Objc2Parser<Layout>::ReadPointerList(const char* sectname,std::vector<uint64_t>* pointers) const{
+		const MachoSection* section = image_.FindSection(sectname);
+		if(section==NULL){
+			return;
+		}
+		uint64_t end = section->addr+section->size;
+		for(uint64_t ea = section->addr;ea+Layout::kPtrSize<=end;ea += Layout::kPtrSize){
+			uint64_t pointer = 0;
+			if(ReadPointer(ea,&pointer)&&pointer!=0){
+				pointers->push_back(pointer);
+			}
+		}
+	}
+	template<typename Layout>
+	const char* Objc2Parser<Layout>::ReadClassName(uint64_t ea,Objc2Class* cls,Objc2ClassRo* ro) const{
+		if(!ReadClass(ea,cls)||!ReadClassRo(ClassDataPointer(*cls),ro)){
+			return NULL;
+		}
+		return ReadString(ro->name);
+	}
+	template class Objc2Parser<Layout32>;
+	template class Objc2Parser<Layout32BE>;
+	template class Objc2Parser<Layout64>;
+}
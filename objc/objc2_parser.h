@@ -0,0 +1,240 @@
+#ifndef OBJC_OBJC2_PARSER_H_
+#define OBJC_OBJC2_PARSER_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+#include "objc/macho_image.h"
+#include "objc/objc_layout.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//decoded runtime structures,addresses are vm addresses of the image
+	struct Objc2Class
+	{
+		uint64_t isa;
+		uint64_t superclass;
+		uint64_t cache;
+		uint64_t vtable;
+		uint64_t data;
+	};
+	struct Objc2ClassRo
+	{
+		uint32 flags;
+		uint32 instance_start;
+		uint32 instance_size;
+		uint64_t ivar_layout;
+		uint64_t name;
+		uint64_t base_methods;
+		uint64_t base_protocols;
+		uint64_t ivars;
+		uint64_t weak_ivar_layout;
+		uint64_t base_properties;
+	};
+	struct Objc2Method
+	{
+		uint64_t name;
+		uint64_t types;
+		uint64_t imp;
+	};
+	struct Objc2Ivar
+	{
+		uint64_t offset;
+		uint64_t name;
+		uint64_t type;
+		uint32 alignment;
+		uint32 size;
+	};
+	struct Objc2Category
+	{
+		uint64_t name;
+		uint64_t cls;
+		uint64_t instance_methods;
+		uint64_t class_methods;
+		uint64_t protocols;
+		uint64_t instance_properties;
+	};
+	struct Objc2Protocol
+	{
+		uint64_t isa;
+		uint64_t name;
+		uint64_t protocols;
+		uint64_t instance_methods;
+		uint64_t class_methods;
+		uint64_t optional_instance_methods;
+		uint64_t optional_class_methods;
+	};
+	//entsize/count prefixed list,the entries are validated to lie in the image
+	//when the view is created so Get only decodes
+	class Objc2ListView
+	{
+	public:
+		Objc2ListView():image_(NULL),base_(NULL),ea_(0),entsize_(0),count_(0),flags_(0){}
+		uint32 count() const{
+			return count_;
+		}
+		uint32 entsize() const{
+			return entsize_;
+		}
+		uint32 flags() const{
+			return flags_;
+		}
+		//vm address of entry index
+		uint64_t EntryAddress(uint32 index) const{
+			return ea_+uint64_t(index)*entsize_;
+		}
+	protected:
+		template<typename Layout> friend class Objc2Parser;
+		const MachoImage* image_;
+		const uint8* base_;
+		uint64_t ea_;
+		uint32 entsize_;
+		uint32 count_;
+		uint32 flags_;
+	};
+	//a pointer field of the image.in a dyld cache the stored value carries
+	//the slide info rebase chain,whose formats only exist for 64-bit
+	template<typename Layout>
+	inline uint64_t LoadTarget(const MachoImage& image,const uint8* p){
+		uint64_t value = Layout::LoadPtr(p);
+		return (Layout::kPtrSize==8)?image.Target(value):value;
+	}
+	template<typename Layout>
+	class Objc2MethodList:public Objc2ListView
+	{
+	public:
+		enum{
+			kRelativeFlag = 0x80000000
+		};
+		bool relative() const{
+			return Layout::kRelativeMethods&&(flags_&kRelativeFlag)!=0;
+		}
+		//address of the imp field,the slot that gets patched
+		uint64_t ImpAddress(uint32 index) const{
+			return EntryAddress(index)+(relative()?8:Layout::kMethodImp);
+		}
+		bool Get(uint32 index,Objc2Method* method) const{
+			if(index>=count_){
+				return false;
+			}
+			const uint8* entry = base_+size_t(index)*entsize_;
+			if(relative()){
+				//name points at a selector reference,types and imp are direct
+				uint64_t field = EntryAddress(index);
+				const uint8* selref = image_->At(field+Layout::LoadRelative(entry),Layout::kPtrSize);
+				method->name = (selref!=NULL)?LoadTarget<Layout>(*image_,selref):0;
+				method->types = field+4+Layout::LoadRelative(entry+4);
+				method->imp = field+8+Layout::LoadRelative(entry+8);
+				return true;
+			}
+			method->name = LoadTarget<Layout>(*image_,entry+Layout::kMethodName);
+			method->types = LoadTarget<Layout>(*image_,entry+Layout::kMethodTypes);
+			method->imp = LoadTarget<Layout>(*image_,entry+Layout::kMethodImp);
+			return true;
+		}
+		//visitor(index,method) for every entry.the relative check is made
+		//once per list,Get makes it per entry and the selector reference
+		//lookup of the relative branch keeps the list fields out of registers
+		template<typename Visitor>
+		void ForEach(Visitor& visitor) const{
+			Objc2Method method;
+			if(relative()){
+				for(uint32 index=0;index<count_;index++){
+					Get(index,&method);
+					visitor(index,method);
+				}
+				return;
+			}
+			const MachoImage& image = *image_;
+			const uint8* entry = base_;
+			//plain pointers keep the loop free of the format check
+			if(Layout::kPtrSize!=8||image.pointer_format()==NULL){
+				for(uint32 index=0;index<count_;index++,entry += entsize_){
+					method.name = Layout::LoadPtr(entry+Layout::kMethodName);
+					method.types = Layout::LoadPtr(entry+Layout::kMethodTypes);
+					method.imp = Layout::LoadPtr(entry+Layout::kMethodImp);
+					visitor(index,method);
+				}
+				return;
+			}
+			for(uint32 index=0;index<count_;index++,entry += entsize_){
+				method.name = LoadTarget<Layout>(image,entry+Layout::kMethodName);
+				method.types = LoadTarget<Layout>(image,entry+Layout::kMethodTypes);
+				method.imp = LoadTarget<Layout>(image,entry+Layout::kMethodImp);
+				visitor(index,method);
+			}
+		}
+	};
+	template<typename Layout>
+	class Objc2IvarList:public Objc2ListView
+	{
+	public:
+		bool Get(uint32 index,Objc2Ivar* ivar) const{
+			if(index>=count_){
+				return false;
+			}
+			const uint8* entry = base_+size_t(index)*entsize_;
+			ivar->offset = LoadTarget<Layout>(*image_,entry+Layout::kIvarOffset);
+			ivar->name = LoadTarget<Layout>(*image_,entry+Layout::kIvarName);
+			ivar->type = LoadTarget<Layout>(*image_,entry+Layout::kIvarType);
+			ivar->alignment = Layout::Load32(entry+Layout::kIvarAlignment);
+			ivar->size = Layout::Load32(entry+Layout::kIvarSize);
+			return true;
+		}
+	};
+	//protocol_list_t has a pointer sized count followed by protocol pointers
+	template<typename Layout>
+	class Objc2ProtocolList:public Objc2ListView
+	{
+	public:
+		bool Get(uint32 index,uint64_t* protocol) const{
+			if(index>=count_){
+				return false;
+			}
+			*protocol = LoadTarget<Layout>(*image_,base_+size_t(index)*entsize_);
+			return true;
+		}
+	};
+	//one instantiation per target layout,see objc_layout.h.the members are
+	//defined in objc2_parser.cc and instantiated there for every layout
+	template<typename Layout>
+	class Objc2Parser
+	{
+	public:
+		typedef Objc2MethodList<Layout> MethodList;
+		typedef Objc2IvarList<Layout> IvarList;
+		typedef Objc2ProtocolList<Layout> ProtocolList;
+		explicit Objc2Parser(const MachoImage& image):image_(image){}
+		~Objc2Parser(void){}
+		bool ReadPointer(uint64_t ea,uint64_t* value) const;
+		bool ReadClass(uint64_t ea,Objc2Class* cls) const;
+		bool ReadClassRo(uint64_t ea,Objc2ClassRo* ro) const;
+		bool ReadCategory(uint64_t ea,Objc2Category* category) const;
+		bool ReadProtocol(uint64_t ea,Objc2Protocol* protocol) const;
+		bool ReadMethodList(uint64_t ea,MethodList* list) const;
+		bool ReadIvarList(uint64_t ea,IvarList* list) const;
+		bool ReadProtocolList(uint64_t ea,ProtocolList* list) const;
+		//non-null pointers stored in the first section called sectname,the
+		//__objc_*list sections
+		void ReadPointerList(const char* sectname,std::vector<uint64_t>* pointers) const;
+		//class_t at ea and its class_ro_t,returns the class name or NULL if the
+		//class is not in the image
+		const char* ReadClassName(uint64_t ea,Objc2Class* cls,Objc2ClassRo* ro) const;
+		//class_t::data with the runtime flag bits cleared
+		uint64_t ClassDataPointer(const Objc2Class& cls) const{
+			return cls.data&Layout::ClassDataMask();
+		}
+		const char* ReadString(uint64_t ea) const{
+			return image_.ReadCString(ea);
+		}
+		const MachoImage& image() const{
+			return image_;
+		}
+	private:
+		bool ReadList(uint64_t ea,uint32 min_entsize,Objc2ListView* list) const;
+		const MachoImage& image_;
+		DISALLOW_EVIL_CONSTRUCTORS(Objc2Parser);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,201 @@
+#include "objc/objc_background.h"
+
+namespace objc{
+	//one step of the run on the ui thread,or its end when finish is set
+	class BackgroundRestore::SliceRequest:public exec_request_t
+	{
+	public:
+		SliceRequest(BackgroundRestore* owner,bool finish):owner_(owner),result_(ObjcRestore::kRestoreMore),finish_(finish),done_(false){}
+		virtual int idaapi execute(void){
+			ObjcRestore* restore = owner_->restore_;
+			if(restore->restore_open()){
+				if(finish_){
+					restore->EndRestore(owner_->cancelled());
+					owner_->HideProgress();
+				}
+				else{
+					result_ = restore->StepRestore(kSliceMs);
+					owner_->Report();
+					if(result_==ObjcRestore::kRestoreDone){
+						restore->EndRestore(false);
+						owner_->HideProgress();
+					}
+				}
+			}
+			else{
+				result_ = ObjcRestore::kRestoreDone;
+			}
+			{
+				std::lock_guard<std::mutex> lock(owner_->mutex_);
+				done_ = true;
+			}
+			owner_->wake_.notify_all();
+			return 0;
+		}
+		uint32 result() const{
+			return result_;
+		}
+		bool done() const{
+			return done_;
+		}
+		bool finish() const{
+			return finish_;
+		}
+	private:
+		BackgroundRestore* owner_;
+		uint32 result_;
+		bool finish_;
+		bool done_;
+	};
+	BackgroundRestore::BackgroundRestore(ObjcRestore* restore):restore_(restore),thread_(NULL),reported_(0),shown_(0),wait_box_(false),cancelled_(false),stopping_(false),running_(false){
+	}
+	BackgroundRestore::~BackgroundRestore(void){
+		Stop();
+	}
+	bool BackgroundRestore::Start(bool changes_only){
+		if(running()){
+			return false;
+		}
+		Join();
+		if(!restore_->BeginRestore(changes_only)){
+			return false;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			cancelled_ = false;
+			stopping_ = false;
+			running_ = true;
+		}
+		reported_ = 0;
+		thread_ = qthread_create(ThreadMain,this);
+		if(thread_==NULL){
+			//no thread,finish the run here as before
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				running_ = false;
+			}
+			for(;;){
+				uint32 step = restore_->StepRestore(0);
+				if(step==ObjcRestore::kRestoreDecode){
+					restore_->DecodeRestore();
+				}
+				else if(step==ObjcRestore::kRestoreDone){
+					break;
+				}
+			}
+			restore_->EndRestore(false);
+			return true;
+		}
+		msg("objc: restoring in the background,cancel the wait box or run the plugin again to stop\n");
+		return true;
+	}
+	void BackgroundRestore::Cancel(){
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			cancelled_ = true;
+		}
+		wake_.notify_all();
+	}
+	void BackgroundRestore::Stop(){
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			cancelled_ = true;
+			stopping_ = true;
+		}
+		wake_.notify_all();
+		Join();
+		//the worker gave up before its last request ran
+		restore_->EndRestore(true);
+		HideProgress();
+	}
+	bool BackgroundRestore::running(){
+		std::lock_guard<std::mutex> lock(mutex_);
+		return running_;
+	}
+	bool BackgroundRestore::cancelled(){
+		std::lock_guard<std::mutex> lock(mutex_);
+		return cancelled_;
+	}
+	void BackgroundRestore::Report(){
+		uint32 progress = restore_->restore_progress();
+		//the wait box follows every percent,its cancel button ends the run
+		//after this slice
+		if(!wait_box_){
+			show_wait_box("objc: restoring,%u%% done",progress/10);
+			wait_box_ = true;
+			shown_ = progress/10;
+		}
+		else if(progress/10!=shown_){
+			shown_ = progress/10;
+			replace_wait_box("objc: restoring,%u%% done",shown_);
+		}
+		if(wasBreak()){
+			Cancel();
+		}
+		if(progress>=reported_+kProgressStep&&progress<1000){
+			reported_ = progress-progress%kProgressStep;
+			msg("objc: restore %u%% done\n",reported_/10);
+		}
+	}
+	void BackgroundRestore::HideProgress(){
+		if(wait_box_){
+			hide_wait_box();
+			wait_box_ = false;
+		}
+	}
+	int idaapi BackgroundRestore::ThreadMain(void* user_data){
+		static_cast<BackgroundRestore*>(user_data)->Work();
+		return 0;
+	}
+	void BackgroundRestore::Work(){
+		bool finished = false;
+		while(!finished&&!cancelled()){
+			SliceRequest step(this,false);
+			if(!Execute(&step)){
+				break;
+			}
+			if(step.result()==ObjcRestore::kRestoreDecode){
+				//the ui thread is free while the heads are decoded
+				restore_->DecodeRestore();
+			}
+			else if(step.result()==ObjcRestore::kRestoreDone){
+				finished = true;
+			}
+		}
+		if(!finished){
+			SliceRequest finish(this,true);
+			Execute(&finish);
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		running_ = false;
+	}
+	bool BackgroundRestore::Execute(SliceRequest* request){
+		//MFF_NOWAIT so the worker can withdraw the request,a cancelled step
+		//need not run and nothing can run while the ui thread waits in Stop
+		int id = execute_sync(*request,MFF_WRITE|MFF_NOWAIT);
+		std::unique_lock<std::mutex> lock(mutex_);
+		while(!request->done()){
+			if(stopping_||(cancelled_&&!request->finish())){
+				lock.unlock();
+				if(cancel_exec_request(id)){
+					return false;
+				}
+				lock.lock();
+				//already running on the ui thread,wait for it
+				while(!request->done()){
+					wake_.wait(lock);
+				}
+				return true;
+			}
+			wake_.wait(lock);
+		}
+		return true;
+	}
+	void BackgroundRestore::Join(){
+		if(thread_!=NULL){
+			qthread_join(thread_);
+			qthread_free(thread_);
+			thread_ = NULL;
+		}
+	}
+}
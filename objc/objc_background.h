@@ -0,0 +1,60 @@
+#ifndef OBJC_OBJC_BACKGROUND_H_
+#define OBJC_OBJC_BACKGROUND_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <mutex>
+#include <condition_variable>
+#include <ida.hpp>
+#include <kernwin.hpp>
+#include "objc/objc_restore.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//runs a restore from a worker thread so the ui stays responsive.the worker
+	//decodes,database work is sent to the ui thread through execute_sync in
+	//slices of kSliceMs and the run can be cancelled between two slices
+	class BackgroundRestore
+	{
+	public:
+		enum{
+			kSliceMs = 40,
+			//the log gets the progress every kProgressStep per mille,the
+			//wait box every percent
+			kProgressStep = 100
+		};
+		explicit BackgroundRestore(ObjcRestore* restore);
+		~BackgroundRestore(void);
+		//ui thread,false when a run is in progress or there is nothing to do
+		bool Start(bool changes_only);
+		//asks the worker to stop after the current slice
+		void Cancel();
+		//ui thread,cancels a run in progress and waits for the worker
+		void Stop();
+		bool running();
+	private:
+		class SliceRequest;
+		static int idaapi ThreadMain(void* user_data);
+		void Work();
+		//false if the request was withdrawn before the ui thread ran it
+		bool Execute(SliceRequest* request);
+		bool cancelled();
+		//ui thread,the wait box and the log lines of the progress
+		void Report();
+		void HideProgress();
+		void Join();
+		ObjcRestore* restore_;
+		qthread_t thread_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		uint32 reported_;
+		//percent in the wait box,while wait_box_ is set
+		uint32 shown_;
+		bool wait_box_;
+		bool cancelled_;
+		//set by Stop,the ui thread will not run requests any more
+		bool stopping_;
+		bool running_;
+		DISALLOW_EVIL_CONSTRUCTORS(BackgroundRestore);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
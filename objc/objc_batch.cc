@@ -0,0 +1,218 @@
+#include "objc/objc_batch.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <map>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "objc/macho_image.h"
+#include "objc/objc_pipeline.h"
+#include "objc/objc_thread_pool.h"
+#include "objc/objc_fat.h"
+
+namespace objc{
+	namespace{
+		const char* const kRecordKinds[] = {
+			"rename",
+			"pointee",
+			"imp",
+			"legacy"
+		};
+		double Now(){
+			timespec now;
+			clock_gettime(CLOCK_MONOTONIC,&now);
+			return now.tv_sec+now.tv_nsec/1e9;
+		}
+		void WriteWork(FILE* file,const MachoImage& image,const RestoreWork& work){
+			for(RestoreRecords::const_iterator it = work.records.begin();it!=work.records.end();++it){
+				//the plugin skips pointees outside the database,here outside the image
+				if(it->kind==RestoreRecord::kRenamePointee&&image.At(it->ea,1)==NULL){
+					continue;
+				}
+				fprintf(file,"%s\t%llx\t%s\n",kRecordKinds[it->kind],static_cast<unsigned long long>(it->ea),work.RecordName(*it));
+			}
+		}
+		//one row per class and method:"=" when every slice has it,"!" otherwise
+		int WriteFatModel(const std::string& path,const std::string& output,uint32 threads){
+			MappedFile file;
+			MachoImage image;
+			if(!file.Open(path)){
+				return kBatchOpenFailed;
+			}
+			if(!image.Parse(file.data(),file.size())){
+				return kBatchNotMacho;
+			}
+			uint32 slice_count = static_cast<uint32>(image.slices().size());
+			file.Close();
+			ThreadPool pool((threads>slice_count)?threads:slice_count);
+			FatModel model;
+			if(!model.Build(path,&pool)){
+				return kBatchNotMacho;
+			}
+			FILE* out = fopen(output.c_str(),"w");
+			if(out==NULL){
+				return kBatchWriteFailed;
+			}
+			const std::vector<SliceObjc>& slices = model.slices();
+			fprintf(out,"# %s\n# class\tselector",path.c_str());
+			for(std::vector<SliceObjc>::const_iterator it = slices.begin();it!=slices.end();++it){
+				fprintf(out,"\t%s%s",CpuName(it->cputype,it->cpusubtype).c_str(),it->parsed?"":"(unparsed)");
+			}
+			fprintf(out,"\n");
+			uint32 method_count = 0;
+			for(FatModel::ClassMap::const_iterator cls = model.classes().begin();cls!=model.classes().end();++cls){
+				fprintf(out,"%c\t%s\t",(cls->second.slices==model.parsed_slices())?'=':'!',cls->first.c_str());
+				for(size_t index=0;index<slices.size();index++){
+					fprintf(out,"\t%s",(cls->second.slices&(1u<<index))?"+":"-");
+				}
+				fprintf(out,"\n");
+				for(std::map<std::string,FatModel::Method>::const_iterator it = cls->second.methods.begin();it!=cls->second.methods.end();++it){
+					fprintf(out,"%c\t%s\t%s",(it->second.slices==model.parsed_slices())?'=':'!',cls->first.c_str(),it->first.c_str());
+					for(size_t index=0;index<slices.size();index++){
+						if(it->second.slices&(1u<<index)){
+							fprintf(out,"\t%llx",static_cast<unsigned long long>(it->second.imps[index]));
+						}
+						else{
+							fprintf(out,"\t-");
+						}
+					}
+					fprintf(out,"\n");
+					method_count++;
+				}
+			}
+			fprintf(out,"# %u slices,%u classes,%u methods,%u differences\n",static_cast<uint32>(slices.size()),
+				static_cast<uint32>(model.classes().size()),method_count,model.difference_count());
+			return (fclose(out)==0)?kBatchOk:kBatchWriteFailed;
+		}
+	}
+	BatchOptions::BatchOptions():jobs(1),threads(1),all_slices(false){
+	}
+	int ProcessBinary(const std::string& path,const std::string& output,const BatchOptions& options){
+		if(options.all_slices){
+			return WriteFatModel(path,output,options.threads);
+		}
+		MappedFile file;
+		if(!file.Open(path)){
+			return kBatchOpenFailed;
+		}
+		MachoImage image;
+		if(!image.Parse(file.data(),file.size())){
+			return kBatchNotMacho;
+		}
+		FILE* out = fopen(output.c_str(),"w");
+		if(out==NULL){
+			return kBatchWriteFailed;
+		}
+		fprintf(out,"# %s\n# cputype %x,%u slices\n",path.c_str(),image.cputype(),static_cast<uint32>(image.slices().size()));
+		HeadDecoder* decoder = CreateHeadDecoder(image);
+		ThreadPool pool(options.threads);
+		RestorePipeline pipeline(&pool);
+		//same order as the section walk:__module_info,__data,__objc_data,__objc_const
+		const uint32 kinds[] = {kObjc1ModuleHead,kObjc2ProtocolHead,kObjc2ClassHead,kObjc2ConstHead};
+		for(size_t index=0;index<sizeof(kinds)/sizeof(kinds[0]);index++){
+			decoder->CollectHeads(kinds[index],&pipeline);
+			pipeline.Decode(*decoder,kinds[index]);
+			const std::vector<RestoreWork>& work = pipeline.work();
+			for(std::vector<RestoreWork>::const_iterator it = work.begin();it!=work.end();++it){
+				WriteWork(out,image,*it);
+			}
+			pipeline.Clear();
+		}
+		fprintf(out,"# %u heads,%u records\n",pipeline.decoded_heads(),pipeline.decoded_records());
+		delete decoder;
+		return (fclose(out)==0)?kBatchOk:kBatchWriteFailed;
+	}
+	BatchRunner::BatchRunner(const BatchOptions& options):options_(options),wall_seconds_(0){
+		if(options_.jobs==0){
+			options_.jobs = 1;
+		}
+	}
+	BatchRunner::~BatchRunner(void){
+	}
+	std::string BatchRunner::OutputPath(const std::string& path) const{
+		//the whole path flattened,builds of one corpus share file names
+		std::string name(path);
+		for(std::string::iterator it = name.begin();it!=name.end();++it){
+			if(*it=='/'||*it=='\\'||*it==':'){
+				*it = '_';
+			}
+		}
+		return options_.output_dir+"/"+name+(options_.ida_path.empty()?".objc":".log");
+	}
+	void BatchRunner::RunWorker(const BatchResult& job) const{
+		if(options_.ida_path.empty()){
+			_exit(ProcessBinary(job.path,job.output,options_));
+		}
+		//the plugin runs synchronously with arg 1,its messages go to the log
+		std::string script = "-S"+options_.ida_script;
+		std::string log = "-L"+job.output;
+		execl(options_.ida_path.c_str(),options_.ida_path.c_str(),"-A",script.c_str(),log.c_str(),job.path.c_str(),static_cast<char*>(NULL));
+		_exit(kBatchCrashed);
+	}
+	void BatchRunner::Run(const std::vector<std::string>& paths){
+		results_.clear();
+		results_.resize(paths.size());
+		for(size_t index=0;index<paths.size();index++){
+			results_[index].path = paths[index];
+			results_[index].output = OutputPath(paths[index]);
+			results_[index].status = kBatchCrashed;
+			results_[index].seconds = 0;
+		}
+		double start = Now();
+		//pid to the index of the binary it is working on and its start time
+		std::map<pid_t,std::pair<size_t,double> > running;
+		size_t next = 0;
+		while(next<paths.size()||!running.empty()){
+			while(next<paths.size()&&running.size()<options_.jobs){
+				fflush(NULL);
+				pid_t pid = fork();
+				if(pid==0){
+					RunWorker(results_[next]);
+				}
+				if(pid<0){
+					//out of processes,wait for one to finish
+					if(running.empty()){
+						results_[next++].status = kBatchCrashed;
+					}
+					break;
+				}
+				running[pid] = std::make_pair(next++,Now());
+			}
+			int status = 0;
+			pid_t pid = waitpid(-1,&status,0);
+			if(pid<0){
+				break;
+			}
+			std::map<pid_t,std::pair<size_t,double> >::iterator it = running.find(pid);
+			if(it==running.end()){
+				continue;
+			}
+			BatchResult& result = results_[it->second.first];
+			result.seconds = Now()-it->second.second;
+			result.status = WIFEXITED(status)?WEXITSTATUS(status):kBatchCrashed;
+			running.erase(it);
+		}
+		wall_seconds_ = Now()-start;
+	}
+	bool BatchRunner::WriteSummary(const std::string& path) const{
+		FILE* out = fopen(path.c_str(),"w");
+		if(out==NULL){
+			return false;
+		}
+		uint32 failed = 0;
+		double busy = 0;
+		fprintf(out,"status\tseconds\tpath\n");
+		for(std::vector<BatchResult>::const_iterator it = results_.begin();it!=results_.end();++it){
+			fprintf(out,"%d\t%.3f\t%s\n",it->status,it->seconds,it->path.c_str());
+			busy += it->seconds;
+			if(it->status!=kBatchOk){
+				failed++;
+			}
+		}
+		fprintf(out,"# %u binaries,%u failed,%u jobs\n",static_cast<uint32>(results_.size()),failed,options_.jobs);
+		fprintf(out,"# %.3f s wall,%.3f s in workers,%.1f binaries/s\n",wall_seconds_,busy,
+			(wall_seconds_>0)?results_.size()/wall_seconds_:0.0);
+		return fclose(out)==0;
+	}
+}
@@ -0,0 +1,72 @@
+#ifndef OBJC_OBJC_BATCH_H_
+#define OBJC_OBJC_BATCH_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:the batch driver runs outside of ida and forks one
+//worker process per binary,posix only
+namespace objc{
+	enum BatchStatus{
+		kBatchOk = 0,
+		kBatchOpenFailed = 2,
+		kBatchNotMacho = 3,
+		kBatchWriteFailed = 4,
+		//worker killed by a signal or ida failed
+		kBatchCrashed = 5
+	};
+	struct BatchOptions
+	{
+		BatchOptions();
+		//worker processes running at once
+		uint32 jobs;
+		//decode threads inside each worker
+		uint32 threads;
+		//fat binaries:every slice into one cross-architecture model instead
+		//of the records of the first slice
+		bool all_slices;
+		//one result file per binary and summary.tsv
+		std::string output_dir;
+		//when set every binary goes through idal -A -S<ida_script> instead
+		std::string ida_path;
+		std::string ida_script;
+	};
+	struct BatchResult
+	{
+		std::string path;
+		std::string output;
+		int status;
+		double seconds;
+	};
+	//decodes the objc2 metadata of one binary from the file alone and writes
+	//the records a restore would apply to output,returns a BatchStatus
+	int ProcessBinary(const std::string& path,const std::string& output,const BatchOptions& options);
+	class BatchRunner
+	{
+	public:
+		explicit BatchRunner(const BatchOptions& options);
+		~BatchRunner(void);
+		//every path in a pool of worker processes,results are in input order
+		void Run(const std::vector<std::string>& paths);
+		const std::vector<BatchResult>& results() const{
+			return results_;
+		}
+		double wall_seconds() const{
+			return wall_seconds_;
+		}
+		//per binary status and time followed by the totals
+		bool WriteSummary(const std::string& path) const;
+	private:
+		//runs in the forked worker and never returns
+		void RunWorker(const BatchResult& job) const;
+		std::string OutputPath(const std::string& path) const;
+		BatchOptions options_;
+		std::vector<BatchResult> results_;
+		double wall_seconds_;
+		DISALLOW_EVIL_CONSTRUCTORS(BatchRunner);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <sys/stat.h>
+#include "objc/objc_batch.h"
+
+namespace{
+	void Usage(){
+		fprintf(stderr,
+			"usage: objc_batch [-a] [-j jobs] [-t threads] [-o dir] [-i idal -s script] [-l list] binary...\n"
+			"  -a  merge every slice of a fat binary into one model keyed by class and selector\n"
+			"  -j  worker processes,default one per core\n"
+			"  -t  decode threads per worker,default 1\n"
+			"  -o  output directory,default .\n"
+			"  -i  run every binary through idal -A -S<script> instead of decoding the file\n"
+			"  -l  file with one binary path per line\n");
+	}
+	bool ReadList(const char* path,std::vector<std::string>* paths){
+		FILE* file = fopen(path,"r");
+		if(file==NULL){
+			return false;
+		}
+		char line[4096];
+		while(fgets(line,sizeof(line),file)!=NULL){
+			size_t len = strcspn(line,"\r\n");
+			line[len] = '\0';
+			if(len!=0&&line[0]!='#'){
+				paths->push_back(line);
+			}
+		}
+		fclose(file);
+		return true;
+	}
+}
+
+int main(int argc,char* argv[]){
+	objc::BatchOptions options;
+	options.jobs = std::thread::hardware_concurrency();
+	options.output_dir = ".";
+	std::vector<std::string> paths;
+	for(int index=1;index<argc;index++){
+		const char* arg = argv[index];
+		const char* value = (index+1<argc)?argv[index+1]:NULL;
+		if(arg[0]!='-'){
+			paths.push_back(arg);
+			continue;
+		}
+		if(!strcmp(arg,"-a")){
+			options.all_slices = true;
+			continue;
+		}
+		if(value==NULL||arg[1]=='\0'||arg[2]!='\0'){
+			Usage();
+			return 1;
+		}
+		switch(arg[1]){
+		case 'j':
+			options.jobs = static_cast<uint32>(atoi(value));
+			break;
+		case 't':
+			options.threads = static_cast<uint32>(atoi(value));
+			break;
+		case 'o':
+			options.output_dir = value;
+			break;
+		case 'i':
+			options.ida_path = value;
+			break;
+		case 's':
+			options.ida_script = value;
+			break;
+		case 'l':
+			if(!ReadList(value,&paths)){
+				fprintf(stderr,"objc_batch: cannot read %s\n",value);
+				return 1;
+			}
+			break;
+		default:
+			Usage();
+			return 1;
+		}
+		index++;
+	}
+	if(paths.empty()||(!options.ida_path.empty()&&options.ida_script.empty())){
+		Usage();
+		return 1;
+	}
+	mkdir(options.output_dir.c_str(),0755);
+	objc::BatchRunner runner(options);
+	runner.Run(paths);
+	std::string summary = options.output_dir+"/summary.tsv";
+	if(!runner.WriteSummary(summary)){
+		fprintf(stderr,"objc_batch: cannot write %s\n",summary.c_str());
+		return 1;
+	}
+	uint32 failed = 0;
+	for(std::vector<objc::BatchResult>::const_iterator it = runner.results().begin();it!=runner.results().end();++it){
+		if(it->status!=objc::kBatchOk){
+			failed++;
+		}
+	}
+	printf("objc_batch: %u binaries,%u failed,%.3f s\n",static_cast<uint32>(paths.size()),failed,runner.wall_seconds());
+	return (failed==0)?0:2;
+}
@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <new>
+#include <algorithm>
+#include "objc/macho_image.h"
+#include "objc/objc2_parser.h"
+#include "objc/objc_string.h"
+#include "objc/objc_type_encoding.h"
+
+//timings of the standalone decoders on synthetic input,run from the shell:
+//objc_bench layout|names|encodings
+using namespace objc;
+namespace{
+	//operator new calls,the names benchmark reports them per name
+	size_t allocations = 0;
+}
+void* operator new(size_t size){
+	allocations++;
+	void* p = malloc((size!=0)?size:1);
+	if(p==NULL){
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void operator delete(void* p) throw(){
+	free(p);
+}
+void operator delete(void* p,size_t) throw(){
+	free(p);
+}
+namespace{
+	const uint32 kMethods = 4096;
+	const uint32 kRounds = 4000;
+	const uint32 kNames = 4096;
+	const uint32 kNameRounds = 200;
+	const uint32 kEncodings = 2000;
+	const uint32 kEncodingRounds = 2000;
+	const uint32 kMhMagic = 0xFEEDFACE;
+	const uint32 kMhMagic64 = 0xFEEDFACF;
+	const uint32 kLcSegment = 0x1;
+	const uint32 kLcSegment64 = 0x19;
+	double Seconds(const std::chrono::steady_clock::time_point& start){
+		return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+	}
+	//the image is written in the byte order of the target,a big endian one
+	//goes through the swapped path of MachoImage like a ppc slice would
+	void Put32(std::vector<uint8>* file,uint32 value,bool big_endian){
+		for(uint32 index=0;index<4;index++){
+			uint32 shift = big_endian?(24-index*8):(index*8);
+			file->push_back(static_cast<uint8>(value>>shift));
+		}
+	}
+	void PutPtr(std::vector<uint8>* file,uint64_t value,uint32 ptr_size,bool big_endian){
+		if(ptr_size==8){
+			Put32(file,static_cast<uint32>(big_endian?(value>>32):value),big_endian);
+			Put32(file,static_cast<uint32>(big_endian?value:(value>>32)),big_endian);
+		}
+		else{
+			Put32(file,static_cast<uint32>(value),big_endian);
+		}
+	}
+	void PutName(std::vector<uint8>* file,const char* name){
+		char field[16] = {0};
+		strncpy(field,name,sizeof(field));
+		file->insert(file->end(),field,field+sizeof(field));
+	}
+	//a thin image whose only segment maps the whole file and holds one method
+	//list of kMethods entries,relative ones point at a selector reference each
+	template<typename Layout>
+	void BuildImage(bool relative,std::vector<uint8>* file,uint64_t* list_ea){
+		const uint32 ptr_size = Layout::kPtrSize;
+		const bool big = Layout::kBigEndian;
+		const uint64_t base = (ptr_size==8)?0x100000000ULL:0x4000;
+		const uint32 header_size = (ptr_size==8)?32:28;
+		const uint32 command_size = (ptr_size==8)?72:56;
+		const uint32 list_offset = header_size+command_size;
+		const uint32 entry_size = relative?uint32(Layout::kRelativeMethodSize):uint32(Layout::kMethodSize);
+		const uint32 selrefs_offset = list_offset+Layout::kListHeaderSize+kMethods*entry_size;
+		const uint32 file_size = selrefs_offset+(relative?kMethods*ptr_size:0);
+		file->clear();
+		Put32(file,(ptr_size==8)?kMhMagic64:kMhMagic,big);
+		Put32(file,(ptr_size==8)?MachoImage::kCpuTypeArm64:MachoImage::kCpuTypeArm,big);
+		Put32(file,0,big);
+		//MH_DYLIB,one load command
+		Put32(file,6,big);
+		Put32(file,1,big);
+		Put32(file,command_size,big);
+		Put32(file,0,big);
+		if(ptr_size==8){
+			Put32(file,0,big);
+		}
+		Put32(file,(ptr_size==8)?kLcSegment64:kLcSegment,big);
+		Put32(file,command_size,big);
+		PutName(file,"__DATA");
+		PutPtr(file,base,ptr_size,big);
+		PutPtr(file,file_size,ptr_size,big);
+		PutPtr(file,0,ptr_size,big);
+		PutPtr(file,file_size,ptr_size,big);
+		//maxprot,initprot,nsects,flags
+		Put32(file,3,big);
+		Put32(file,3,big);
+		Put32(file,0,big);
+		Put32(file,0,big);
+		Put32(file,entry_size|(relative?0x80000000:0),big);
+		Put32(file,kMethods,big);
+		for(uint32 index=0;index<kMethods;index++){
+			if(relative){
+				uint64_t field = base+file->size();
+				uint64_t selref = base+selrefs_offset+index*ptr_size;
+				Put32(file,static_cast<uint32>(selref-field),big);
+				Put32(file,static_cast<uint32>(index*16),big);
+				Put32(file,static_cast<uint32>(index*32),big);
+			}
+			else{
+				PutPtr(file,base+0x100000+index*16,ptr_size,big);
+				PutPtr(file,base+0x200000+index*8,ptr_size,big);
+				PutPtr(file,base+0x300000+index*32,ptr_size,big);
+			}
+		}
+		if(relative){
+			for(uint32 index=0;index<kMethods;index++){
+				PutPtr(file,base+0x100000+index*16,ptr_size,big);
+			}
+		}
+		*list_ea = base+list_offset;
+	}
+	//keeps the loads from being dropped
+	struct MethodChecksum
+	{
+		MethodChecksum():sum(0){}
+		void operator()(uint32,const Objc2Method& method){
+			sum += method.name^method.types^method.imp;
+		}
+		uint64_t sum;
+	};
+	//ns per method of ReadMethodList and ForEach over every entry
+	template<typename Layout>
+	double BenchMethodList(const char* label,bool relative){
+		std::vector<uint8> file;
+		uint64_t list_ea = 0;
+		BuildImage<Layout>(relative,&file,&list_ea);
+		MachoImage image;
+		if(!image.Parse(&file[0],file.size())){
+			printf("%-18s image does not parse\n",label);
+			return 0;
+		}
+		Objc2Parser<Layout> parser(image);
+		typename Objc2Parser<Layout>::MethodList list;
+		MethodChecksum checksum;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(uint32 round=0;round<kRounds;round++){
+			if(!parser.ReadMethodList(list_ea,&list)){
+				printf("%-18s method list does not parse\n",label);
+				return 0;
+			}
+			list.ForEach(checksum);
+		}
+		double ns = Seconds(start)*1e9/(double(kRounds)*kMethods);
+		printf("%-18s %u methods x %u rounds %6.2f ns/method %6.2f bytes/ns (checksum %llx)\n",label,kMethods,kRounds,ns,
+			list.entsize()/ns,static_cast<unsigned long long>(checksum.sum));
+		return ns;
+	}
+	int BenchLayouts(){
+		double layout32 = BenchMethodList<Layout32>("layout32",false);
+		double layout32be = BenchMethodList<Layout32BE>("layout32be",false);
+		double layout64 = BenchMethodList<Layout64>("layout64",false);
+		BenchMethodList<Layout64>("layout64 relative",true);
+		if(layout32<=0||layout32be<=0||layout64<=0){
+			return 1;
+		}
+		printf("layout64/layout32 %.2f\n",layout64/layout32);
+		return 0;
+	}
+	//how method names were built before NameWriter:ReplaceAll restarted its
+	//search at 0 after each replacement and every step made a new string
+	std::string LegacyReplaceAll(const std::string& str,const std::string& old_value,const std::string& new_value){
+		std::string strs = str;
+		for(;;){
+			std::string::size_type pos(0);
+			if((pos=strs.find(old_value))!=std::string::npos){
+				strs.replace(pos,old_value.length(),new_value);
+			}
+			else{
+				break;
+			}
+		}
+		return strs;
+	}
+	std::string LegacyMethodName(const std::string& class_name,const std::string& selector){
+		const std::string new_class_name = LegacyReplaceAll(class_name,"_$_","::");
+		std::string func_name = selector;
+		std::replace(func_name.begin(),func_name.end(),':','_');
+		func_name = LegacyReplaceAll(func_name,"_$_","::");
+		return new_class_name+std::string("::")+func_name;
+	}
+	//class or Class_$_Category and selector pairs shaped like the ones of an
+	//app,a few with "_$_" in the selector
+	void BuildNames(std::vector<std::pair<std::string,std::string> >* names){
+		const char* const classes[] = {"NSObject","UIViewController","AppDelegate","MyTableViewCell"};
+		const char* const categories[] = {"","Additions","Private","UIAccessibility"};
+		const char* const selectors[] = {"init","dealloc","initWithFrame:","tableView:cellForRowAtIndexPath:",
+			"setValue:forKey:","observeValueForKeyPath:ofObject:change:context:","_$_private","load_$_swizzled:"};
+		char number[16] = {0};
+		for(uint32 index=0;index<kNames;index++){
+			std::string cls(classes[index%4]);
+			const char* category = categories[(index/4)%4];
+			if(*category!='\0'){
+				cls.append("_$_").append(category);
+			}
+			snprintf(number,sizeof(number),"%u",index);
+			std::string selector(selectors[(index/16)%8]);
+			selector.append(number);
+			names->push_back(std::make_pair(cls,selector));
+		}
+	}
+	int BenchNames(){
+		std::vector<std::pair<std::string,std::string> > names;
+		BuildNames(&names);
+		size_t total = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		size_t before = allocations;
+		for(uint32 round=0;round<kNameRounds;round++){
+			for(size_t index=0;index<names.size();index++){
+				total += LegacyMethodName(names[index].first,names[index].second).size();
+			}
+		}
+		double legacy_ns = Seconds(start)*1e9/(double(kNameRounds)*names.size());
+		double legacy_allocations = double(allocations-before)/(double(kNameRounds)*names.size());
+		//the buffer is kept across names like ObjcRestore::name_buffer_
+		std::string buffer;
+		start = std::chrono::steady_clock::now();
+		before = allocations;
+		for(uint32 round=0;round<kNameRounds;round++){
+			for(size_t index=0;index<names.size();index++){
+				buffer.clear();
+				NameWriter(&buffer).AppendCategoryName(names[index].first).Append("::").AppendSelector(names[index].second);
+				total += buffer.size();
+			}
+		}
+		double writer_ns = Seconds(start)*1e9/(double(kNameRounds)*names.size());
+		double writer_allocations = double(allocations-before)/(double(kNameRounds)*names.size());
+		size_t mismatches = 0;
+		for(size_t index=0;index<names.size();index++){
+			buffer.clear();
+			NameWriter(&buffer).AppendCategoryName(names[index].first).Append("::").AppendSelector(names[index].second);
+			mismatches += (buffer!=LegacyMethodName(names[index].first,names[index].second))?1:0;
+		}
+		printf("%-18s %u names x %u rounds %6.1f ns/name %5.2f allocations/name\n","legacy",kNames,kNameRounds,legacy_ns,legacy_allocations);
+		printf("%-18s %u names x %u rounds %6.1f ns/name %5.2f allocations/name\n","namewriter",kNames,kNameRounds,writer_ns,writer_allocations);
+		printf("legacy/namewriter %.2f,%u names differ (checksum %llu)\n",legacy_ns/writer_ns,static_cast<uint32>(mismatches),
+			static_cast<unsigned long long>(total));
+		return (mismatches==0)?0:1;
+	}
+	//method type encodings shaped like an sdk's:scalars,objects with and
+	//without class names,pointers,blocks and structs by value and by pointer
+	void BuildEncodings(std::vector<std::string>* encodings){
+		const char* const results[] = {"v","@","c","B","q","Q","d","{CGRect={CGPoint=dd}{CGSize=dd}}","^v","r*"};
+		const char* const arguments[] = {"@","@\"NSString\"","q","Q","d","B",":","@?","^{__CFString=}","{CGPoint=dd}",
+			"^@","r^{AudioStreamBasicDescription=dIIIIIIII}","[4i]","{_NSRange=QQ}","i","#"};
+		char number[16] = {0};
+		for(uint32 index=0;index<kEncodings;index++){
+			//the first three arguments spell index in base 16,so every
+			//encoding is distinct
+			uint32 count = 3+index%3;
+			std::string encoding(results[index%10]);
+			snprintf(number,sizeof(number),"%u",16+count*8);
+			encoding.append(number).append("@0:8");
+			for(uint32 argument=0;argument<count;argument++){
+				encoding.append(arguments[(index>>(argument*4))&0xF]);
+				snprintf(number,sizeof(number),"%u",16+argument*8);
+				encoding.append(number);
+			}
+			encodings->push_back(encoding);
+		}
+	}
+	//first parses of every encoding,then the cached ones a restore sees for
+	//every further method list
+	int BenchEncodings(){
+		std::vector<std::string> encodings;
+		BuildEncodings(&encodings);
+		std::vector<StringPiece> pieces;
+		for(size_t index=0;index<encodings.size();index++){
+			pieces.push_back(StringPiece(encodings[index]));
+		}
+		TypeEncodingParser parser;
+		uint32 malformed = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(size_t index=0;index<pieces.size();index++){
+			malformed += (parser.Parse(pieces[index])==TypeEncodingParser::kNoSignature)?1:0;
+		}
+		double first = Seconds(start);
+		uint64_t total = 0;
+		start = std::chrono::steady_clock::now();
+		for(uint32 round=0;round<kEncodingRounds;round++){
+			for(size_t index=0;index<pieces.size();index++){
+				total += parser.Parse(pieces[index]);
+			}
+		}
+		double cached = Seconds(start);
+		double parses = double(kEncodingRounds)*pieces.size();
+		std::string decl;
+		parser.Declaration(parser.Parse(pieces[pieces.size()/2]),StringPiece("method"),false,&decl);
+		printf("%-18s %u encodings,%u malformed,%u signatures %6.1f ns/parse %6.2fM parses/s\n","first",static_cast<uint32>(pieces.size()),
+			malformed,parser.signature_count(),first*1e9/pieces.size(),pieces.size()/first/1e6);
+		printf("%-18s %u encodings x %u rounds %6.1f ns/parse %6.2fM parses/s (checksum %llu)\n","cached",static_cast<uint32>(pieces.size()),
+			kEncodingRounds,cached*1e9/parses,parses/cached/1e6,static_cast<unsigned long long>(total));
+		printf("e.g. %s\n",decl.c_str());
+		return (malformed==0)?0:1;
+	}
+	void Usage(){
+		fprintf(stderr,
+			"usage: objc_bench layout|names|encodings\n"
+			"  layout     method_t decoding per compile time layout,32 and 64-bit\n"
+			"  names      Class::selector names,the old ReplaceAll chain against NameWriter\n"
+			"  encodings  TypeEncodingParser,first and cached parses of method type encodings\n");
+	}
+}
+
+int main(int argc,char* argv[]){
+	if(argc==2&&!strcmp(argv[1],"layout")){
+		return BenchLayouts();
+	}
+	if(argc==2&&!strcmp(argv[1],"names")){
+		return BenchNames();
+	}
+	if(argc==2&&!strcmp(argv[1],"encodings")){
+		return BenchEncodings();
+	}
+	Usage();
+	return 1;
+}
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "objc/dyld_cache.h"
+#include "objc/dyld_cache_index.h"
+#include "objc/dyld_objc_opt.h"
+#include "objc/objc_thread_pool.h"
+
+namespace{
+	double Now(){
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+		return now.tv_sec+now.tv_nsec/1e9;
+	}
+	void Usage(){
+		fprintf(stderr,
+			"usage: objc_cache [-t threads] dyld_shared_cache query...\n"
+			"  query is -[Class selector],+[Class selector],a selector or @Protocol,\n"
+			"  or class:Name,sel:name,proto:Name answered from the preoptimized tables\n");
+	}
+	void PrintImplementation(const objc::DyldCache& cache,const objc::DyldCacheIndex& index,const objc::DyldCacheIndex::Implementation& method,const char* selector){
+		printf("  %c[%s %s] %llx %s\n",method.class_method?'+':'-',index.classes().name(method.class_id),selector,
+			static_cast<unsigned long long>(method.imp),cache.images()[method.image].path);
+	}
+	bool IsOptQuery(const std::string& query){
+		return query.compare(0,6,"class:")==0||query.compare(0,4,"sel:")==0||query.compare(0,6,"proto:")==0;
+	}
+	//__objc_opt_ro lookups,no index needed
+	void OptQuery(const objc::DyldCache& cache,const objc::ObjcOptTables& opt,const std::string& query){
+		double start = Now();
+		if(query.compare(0,6,"class:")==0){
+			std::vector<objc::ObjcOptTables::OptClass> classes;
+			opt.FindClass(query.c_str()+6,&classes);
+			double elapsed = Now()-start;
+			printf("%s: %u definitions (%.2f us)\n",query.c_str(),static_cast<uint32>(classes.size()),elapsed*1e6);
+			for(std::vector<objc::ObjcOptTables::OptClass>::const_iterator it = classes.begin();it!=classes.end();++it){
+				printf("  %llx %s\n",static_cast<unsigned long long>(it->cls),
+					(it->image<cache.images().size())?cache.images()[it->image].path:"?");
+			}
+			return;
+		}
+		bool selector = query.compare(0,4,"sel:")==0;
+		uint64_t address = selector?opt.FindSelector(query.c_str()+4):opt.FindProtocol(query.c_str()+6);
+		double elapsed = Now()-start;
+		if(address!=0){
+			printf("%s: %llx (%.2f us)\n",query.c_str(),static_cast<unsigned long long>(address),elapsed*1e6);
+		}
+		else{
+			printf("%s: not found (%.2f us)\n",query.c_str(),elapsed*1e6);
+		}
+	}
+	void Query(const objc::DyldCache& cache,const objc::DyldCacheIndex& index,const std::string& query){
+		double start = Now();
+		if((query[0]=='-'||query[0]=='+')&&query.size()>3&&query[1]=='['&&query[query.size()-1]==']'){
+			size_t space = query.find(' ');
+			if(space==std::string::npos){
+				printf("%s: bad query\n",query.c_str());
+				return;
+			}
+			std::string class_name = query.substr(2,space-2);
+			std::string selector = query.substr(space+1,query.size()-space-2);
+			const objc::DyldCacheIndex::Implementation* method = index.Lookup(class_name.c_str(),selector.c_str(),query[0]=='+');
+			double elapsed = Now()-start;
+			printf("%s: %s (%.2f us)\n",query.c_str(),(method!=NULL)?"found":"not implemented",elapsed*1e6);
+			if(method!=NULL){
+				PrintImplementation(cache,index,*method,selector.c_str());
+			}
+		}
+		else if(query[0]=='@'){
+			std::vector<uint32> images;
+			index.ProtocolImages(query.c_str()+1,&images);
+			double elapsed = Now()-start;
+			printf("%s: %u images (%.2f us)\n",query.c_str(),static_cast<uint32>(images.size()),elapsed*1e6);
+			for(std::vector<uint32>::const_iterator it = images.begin();it!=images.end();++it){
+				printf("  %s\n",cache.images()[*it].path);
+			}
+		}
+		else{
+			const objc::DyldCacheIndex::Implementation* first = NULL;
+			size_t count = index.Implementers(query.c_str(),&first);
+			double elapsed = Now()-start;
+			printf("%s: %u implementations (%.2f us)\n",query.c_str(),static_cast<uint32>(count),elapsed*1e6);
+			for(size_t position=0;position<count;position++){
+				PrintImplementation(cache,index,first[position],query.c_str());
+			}
+		}
+	}
+}
+
+int main(int argc,char* argv[]){
+	uint32 threads = objc::ThreadPool::DefaultThreadCount();
+	int arg = 1;
+	if(arg+1<argc&&!strcmp(argv[arg],"-t")){
+		threads = static_cast<uint32>(atoi(argv[arg+1]));
+		arg += 2;
+	}
+	if(arg>=argc){
+		Usage();
+		return 1;
+	}
+	double start = Now();
+	objc::DyldCache cache;
+	if(!cache.Open(argv[arg])){
+		fprintf(stderr,"objc_cache: %s is not a dyld shared cache\n",argv[arg]);
+		return 1;
+	}
+	objc::ObjcOptTables opt;
+	if(opt.Open(cache)){
+		printf("objc_cache: %s,objc_opt_t version %u,%u selectors,%u classes,%u protocols preoptimized\n",cache.arch().c_str(),opt.version(),
+			opt.selectors().occupied(),opt.classes().occupied(),opt.protocols().occupied());
+	}
+	//the index is only built when a query needs the method lists
+	bool need_index = false;
+	for(int query=arg+1;query<argc;query++){
+		need_index = need_index||!IsOptQuery(argv[query])||opt.version()==0;
+	}
+	objc::ThreadPool pool(threads);
+	objc::DyldCacheIndex index;
+	if(need_index){
+		index.Build(cache,&pool);
+		printf("objc_cache: %s,%u images,%u walked,%u classes,%u selectors,%u methods,%u protocols\n",cache.arch().c_str(),
+			static_cast<uint32>(cache.images().size()),index.images_walked(),index.classes().size(),index.selectors().size(),
+			static_cast<uint32>(index.method_count()),index.protocol_count());
+		printf("objc_cache: built in %.3f s on %u threads,index uses %u KB\n",Now()-start,pool.thread_count(),static_cast<uint32>(index.memory()>>10));
+	}
+	for(arg++;arg<argc;arg++){
+		if(IsOptQuery(argv[arg])&&opt.version()!=0){
+			OptQuery(cache,opt,argv[arg]);
+		}
+		//without the tables the index answers the prefixed forms
+		else if(strncmp(argv[arg],"class:",6)==0){
+			uint32 image = index.ClassImage(argv[arg]+6);
+			printf("%s: %s\n",argv[arg],(image!=objc::DyldCacheIndex::kNotFound)?cache.images()[image].path:"not found");
+		}
+		else if(strncmp(argv[arg],"sel:",4)==0){
+			Query(cache,index,argv[arg]+4);
+		}
+		else if(strncmp(argv[arg],"proto:",6)==0){
+			Query(cache,index,std::string("@")+(argv[arg]+6));
+		}
+		else{
+			Query(cache,index,argv[arg]);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,44 @@
+#include "objc/objc_call_sites.h"
+#include <algorithm>
+
+namespace objc{
+	namespace{
+		bool CallSiteLess(const std::pair<uint64_t,uint32>& left,const std::pair<uint64_t,uint32>& right){
+			return left.first<right.first;
+		}
+		bool CallSiteEqual(const std::pair<uint64_t,uint32>& left,const std::pair<uint64_t,uint32>& right){
+			return left.first==right.first;
+		}
+	}
+	CallSiteCollector::CallSiteCollector(const CallReferenceSource& source):source_(source){
+	}
+	CallSiteCollector::~CallSiteCollector(void){
+	}
+	uint32 CallSiteCollector::Add(uint64_t target,uint32 flags){
+		if(std::find(targets_.begin(),targets_.end(),target)!=targets_.end()){
+			return 0;
+		}
+		targets_.push_back(target);
+		//one vector per level,the recursion refills it otherwise
+		std::vector<CallReferenceSource::Reference> references;
+		source_.ReferencesTo(target,&references);
+		uint32 added = 0;
+		for(std::vector<CallReferenceSource::Reference>::const_iterator it = references.begin();it!=references.end();++it){
+			if(it->kind==CallReferenceSource::kStub||it->kind==CallReferenceSource::kPointer){
+				added += Add(it->next,flags);
+			}
+			else if(it->kind==CallReferenceSource::kCall){
+				calls_.push_back(std::make_pair(it->from,flags));
+				added++;
+			}
+		}
+		return added;
+	}
+	void CallSiteCollector::Finish(std::vector<std::pair<uint64_t,uint32> >* calls){
+		std::sort(calls_.begin(),calls_.end(),CallSiteLess);
+		calls_.erase(std::unique(calls_.begin(),calls_.end(),CallSiteEqual),calls_.end());
+		calls->swap(calls_);
+		calls_.clear();
+		targets_.clear();
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef OBJC_OBJC_CALL_SITES_H_
+#define OBJC_OBJC_CALL_SITES_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <utility>
+#include <vector>
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:the plugin feeds the collector ida's xrefs,the
+//self-check a fixed table
+namespace objc{
+	//the references to an address,classified for CallSiteCollector
+	class CallReferenceSource
+	{
+	public:
+		enum{
+			//anything else,ignored
+			kOther = 0,
+			//a call,a tail call jump or an indirect call through a pointer
+			kCall = 1,
+			//a stub or thunk forwarding to the target,its callers are followed
+			kStub = 2,
+			//the lazy or non-lazy pointer bound to the import,its readers are
+			//followed
+			kPointer = 3
+		};
+		struct Reference
+		{
+			uint64_t from;
+			uint32 kind;
+			//kStub and kPointer:the head whose references are followed
+			uint64_t next;
+		};
+		virtual ~CallReferenceSource(){}
+		virtual void ReferencesTo(uint64_t target,std::vector<Reference>* references) const = 0;
+	};
+	//the call sites of a function,through its stubs and import pointers.each
+	//site keeps the flags of the function it was reached from
+	class CallSiteCollector
+	{
+	public:
+		explicit CallSiteCollector(const CallReferenceSource& source);
+		~CallSiteCollector(void);
+		//the sites added through target,0 when it was followed before
+		uint32 Add(uint64_t target,uint32 flags);
+		//sorted by address,a site reached through more than one name once
+		void Finish(std::vector<std::pair<uint64_t,uint32> >* calls);
+	private:
+		const CallReferenceSource& source_;
+		std::vector<uint64_t> targets_;
+		std::vector<std::pair<uint64_t,uint32> > calls_;
+		DISALLOW_EVIL_CONSTRUCTORS(CallSiteCollector);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
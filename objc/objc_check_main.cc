@@ -0,0 +1,582 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "objc/macho_image.h"
+#include "objc/objc2_parser.h"
+#include "objc/objc1_parser.h"
+#include "objc/objc_hash.h"
+#include "objc/objc_selector_index.h"
+#include "objc/objc_string_arena.h"
+#include "objc/objc_type_encoding.h"
+#include "objc/dyld_cache.h"
+#include "objc/dyld_cache_index.h"
+#include "objc/dyld_objc_opt.h"
+#include "objc/objc_call_sites.h"
+
+//the standalone decoders on fixed byte fixtures,run from the shell:
+//objc_check [scratch directory for the cache fixture]
+using namespace objc;
+namespace{
+	const uint32 kMhMagic = 0xFEEDFACE;
+	const uint32 kMhMagic64 = 0xFEEDFACF;
+	const uint32 kFatMagic = 0xCAFEBABE;
+	const uint32 kLcSegment = 0x1;
+	const uint32 kLcSegment64 = 0x19;
+	const uint32 kCpuTypePowerPC = 18;
+	uint32 checks = 0;
+	uint32 failures = 0;
+	void Expect(bool ok,const char* what){
+		checks++;
+		if(!ok){
+			failures++;
+			printf("FAIL %s\n",what);
+		}
+	}
+	bool SameString(const char* str,const char* expected){
+		return str!=NULL&&strcmp(str,expected)==0;
+	}
+	//fixtures are written at fixed offsets in the byte order of the target
+	void Put32(std::vector<uint8>* file,size_t offset,uint32 value,bool big_endian){
+		for(uint32 index=0;index<4;index++){
+			uint32 shift = big_endian?(24-index*8):(index*8);
+			(*file)[offset+index] = static_cast<uint8>(value>>shift);
+		}
+	}
+	void Put16(std::vector<uint8>* file,size_t offset,uint32 value,bool big_endian){
+		(*file)[offset] = static_cast<uint8>(big_endian?(value>>8):value);
+		(*file)[offset+1] = static_cast<uint8>(big_endian?value:(value>>8));
+	}
+	void Put64(std::vector<uint8>* file,size_t offset,uint64_t value,bool big_endian){
+		Put32(file,offset,static_cast<uint32>(big_endian?(value>>32):value),big_endian);
+		Put32(file,offset+4,static_cast<uint32>(big_endian?value:(value>>32)),big_endian);
+	}
+	void PutPtr(std::vector<uint8>* file,size_t offset,uint64_t value,uint32 ptr_size,bool big_endian){
+		if(ptr_size==8){
+			Put64(file,offset,value,big_endian);
+		}
+		else{
+			Put32(file,offset,static_cast<uint32>(value),big_endian);
+		}
+	}
+	void PutString(std::vector<uint8>* file,size_t offset,const char* str){
+		memcpy(&(*file)[offset],str,strlen(str)+1);
+	}
+	//16 byte name field,the file is zero filled
+	void PutName(std::vector<uint8>* file,size_t offset,const char* name){
+		size_t length = strlen(name);
+		memcpy(&(*file)[offset],name,(length<16)?length:16);
+	}
+	struct FixtureSection
+	{
+		const char* segname;
+		const char* sectname;
+		uint32 offset;
+		uint32 size;
+	};
+	//a thin MH_DYLIB of size bytes,its one segment maps all of it at base
+	//and holds the sections.content goes behind the load commands
+	void BuildImage(uint32 cputype,bool big,uint64_t base,uint32 size,const FixtureSection* sections,uint32 section_count,std::vector<uint8>* file){
+		const bool wide = (cputype&MachoImage::kCpuArch64)!=0;
+		const uint32 header_size = wide?32:28;
+		const uint32 segment_size = wide?72:56;
+		const uint32 section_size = wide?80:68;
+		const uint32 command_size = segment_size+section_count*section_size;
+		file->assign(size,0);
+		Put32(file,0,wide?kMhMagic64:kMhMagic,big);
+		Put32(file,4,cputype,big);
+		Put32(file,12,6,big);
+		Put32(file,16,1,big);
+		Put32(file,20,command_size,big);
+		size_t command = header_size;
+		Put32(file,command,wide?kLcSegment64:kLcSegment,big);
+		Put32(file,command+4,command_size,big);
+		PutName(file,command+8,"__DATA");
+		//vmaddr,vmsize,fileoff,filesize,then maxprot,initprot,nsects
+		size_t field = command+24;
+		const uint32 ptr_size = wide?8:4;
+		PutPtr(file,field,base,ptr_size,big);
+		PutPtr(file,field+ptr_size,size,ptr_size,big);
+		PutPtr(file,field+ptr_size*2,0,ptr_size,big);
+		PutPtr(file,field+ptr_size*3,size,ptr_size,big);
+		Put32(file,field+ptr_size*4,3,big);
+		Put32(file,field+ptr_size*4+4,3,big);
+		Put32(file,field+ptr_size*4+8,section_count,big);
+		for(uint32 index=0;index<section_count;index++){
+			size_t section = command+segment_size+index*section_size;
+			PutName(file,section,sections[index].sectname);
+			PutName(file,section+16,sections[index].segname);
+			PutPtr(file,section+32,base+sections[index].offset,ptr_size,big);
+			PutPtr(file,section+32+ptr_size,sections[index].size,ptr_size,big);
+			Put32(file,section+32+ptr_size*2,sections[index].offset,big);
+		}
+	}
+	struct MethodSum
+	{
+		MethodSum():count(0),sum(0){}
+		void operator()(uint32,const Objc2Method& method){
+			count++;
+			sum += method.name^method.types^method.imp;
+		}
+		uint32 count;
+		uint64_t sum;
+	};
+	//a class with two methods and an ivar,plus a relative method list for
+	//the layouts that have them
+	template<typename Layout>
+	void CheckObjc2(uint32 cputype){
+		const uint32 ptr_size = Layout::kPtrSize;
+		const bool big = Layout::kBigEndian;
+		const uint64_t base = (ptr_size==8)?0x100000000ULL:0x4000;
+		const FixtureSection sections[] = {{"__DATA","__objc_classlist",0x900,ptr_size}};
+		std::vector<uint8> file;
+		BuildImage(cputype,big,base,0x1000,sections,1,&file);
+		PutString(&file,0x400,"NSObject");
+		PutString(&file,0x410,"init");
+		PutString(&file,0x420,"v16@0:8");
+		PutString(&file,0x430,"dealloc");
+		PutString(&file,0x440,"_count");
+		PutString(&file,0x450,"i");
+		Put32(&file,0x500,Layout::kMethodSize,big);
+		Put32(&file,0x504,2,big);
+		for(uint32 index=0;index<2;index++){
+			size_t entry = 0x508+index*Layout::kMethodSize;
+			PutPtr(&file,entry+Layout::kMethodName,base+((index==0)?0x410:0x430),ptr_size,big);
+			PutPtr(&file,entry+Layout::kMethodTypes,base+0x420,ptr_size,big);
+			PutPtr(&file,entry+Layout::kMethodImp,base+0xF00+index*0x10,ptr_size,big);
+		}
+		Put32(&file,0x600,Layout::kIvarEntrySize,big);
+		Put32(&file,0x604,1,big);
+		PutPtr(&file,0x608+Layout::kIvarOffset,base+0x680,ptr_size,big);
+		PutPtr(&file,0x608+Layout::kIvarName,base+0x440,ptr_size,big);
+		PutPtr(&file,0x608+Layout::kIvarType,base+0x450,ptr_size,big);
+		Put32(&file,0x608+Layout::kIvarAlignment,2,big);
+		Put32(&file,0x608+Layout::kIvarSize,4,big);
+		Put32(&file,0x700+Layout::kRoInstanceSize,12,big);
+		PutPtr(&file,0x700+Layout::kRoName,base+0x400,ptr_size,big);
+		PutPtr(&file,0x700+Layout::kRoBaseMethods,base+0x500,ptr_size,big);
+		PutPtr(&file,0x700+Layout::kRoIvars,base+0x600,ptr_size,big);
+		//the runtime keeps flags in the low bits of data
+		PutPtr(&file,0x800+Layout::kClassData,base+0x701,ptr_size,big);
+		PutPtr(&file,0x900,base+0x800,ptr_size,big);
+		//entsize*count is past 4 GB and wraps a 32-bit size_t
+		Put32(&file,0x980,Layout::kMethodSize,big);
+		Put32(&file,0x984,0xFFFFFFFF/Layout::kMethodSize+2,big);
+		//relative method_t:selector reference,types and imp as offsets
+		Put32(&file,0xA00,Layout::kRelativeMethodSize|Objc2MethodList<Layout>::kRelativeFlag,big);
+		Put32(&file,0xA04,1,big);
+		Put32(&file,0xA08,0xA40-0xA08,big);
+		Put32(&file,0xA0C,static_cast<uint32>(0x420-0xA0C),big);
+		Put32(&file,0xA10,0xF20-0xA10,big);
+		PutPtr(&file,0xA40,base+0x410,ptr_size,big);
+		MachoImage image;
+		Expect(image.Parse(&file[0],file.size()),"objc2 image parses");
+		Expect(image.is64()==(ptr_size==8)&&image.swapped()==big,"objc2 image width and byte order");
+		Objc2Parser<Layout> parser(image);
+		std::vector<uint64_t> classes;
+		parser.ReadPointerList("__objc_classlist",&classes);
+		Expect(classes.size()==1&&classes[0]==base+0x800,"objc2 class list");
+		Objc2Class cls = Objc2Class();
+		Objc2ClassRo ro = Objc2ClassRo();
+		Expect(SameString(parser.ReadClassName(base+0x800,&cls,&ro),"NSObject"),"objc2 class name through masked data");
+		Expect(ro.instance_size==12&&ro.base_methods==base+0x500&&ro.ivars==base+0x600,"objc2 class_ro fields");
+		typename Objc2Parser<Layout>::MethodList methods;
+		Objc2Method method = Objc2Method();
+		Expect(parser.ReadMethodList(ro.base_methods,&methods)&&methods.count()==2,"objc2 method list");
+		Expect(methods.Get(1,&method)&&SameString(image.ReadCString(method.name),"dealloc")&&method.imp==base+0xF10,"objc2 method fields");
+		Expect(!methods.Get(2,&method),"objc2 method past the list");
+		MethodSum expected;
+		for(uint32 index=0;methods.Get(index,&method);index++){
+			expected(index,method);
+		}
+		MethodSum visited;
+		methods.ForEach(visited);
+		Expect(visited.count==2&&visited.sum==expected.sum,"objc2 ForEach matches Get");
+		typename Objc2Parser<Layout>::IvarList ivars;
+		Objc2Ivar ivar = Objc2Ivar();
+		Expect(parser.ReadIvarList(ro.ivars,&ivars)&&ivars.Get(0,&ivar),"objc2 ivar list");
+		Expect(SameString(image.ReadCString(ivar.name),"_count")&&ivar.offset==base+0x680&&ivar.alignment==2&&ivar.size==4,"objc2 ivar fields");
+		Expect(!parser.ReadMethodList(base+0x980,&methods),"objc2 list longer than the image");
+		if(Layout::kRelativeMethods){
+			Expect(parser.ReadMethodList(base+0xA00,&methods)&&methods.relative()&&methods.Get(0,&method),"objc2 relative method list");
+			Expect(method.name==base+0x410&&method.types==base+0x420&&method.imp==base+0xF20,"objc2 relative method fields");
+		}
+	}
+	//pointers of a cache image stored with slide info,decoded by every reader
+	void CheckSlideInfo(){
+		const uint64_t base = 0x180000000ULL;
+		const uint64_t delta = 0x0012000000000000ULL;
+		std::vector<uint8> file;
+		BuildImage(MachoImage::kCpuTypeArm64,false,base,0x1000,NULL,0,&file);
+		PutString(&file,0x400,"init");
+		Put32(&file,0x500,Layout64::kMethodSize,false);
+		Put32(&file,0x504,1,false);
+		//v2 keeps the distance to the next rebase in the delta bits and the
+		//address less value_add below them
+		Put64(&file,0x508+Layout64::kMethodName,delta|0x400,false);
+		Put64(&file,0x508+Layout64::kMethodTypes,0,false);
+		Put64(&file,0x508+Layout64::kMethodImp,delta|0xF00,false);
+		MachoPointerFormat v2 = {MachoPointerFormat::kSlideInfoV2,~0x00FFFF0000000000ULL,base};
+		MachoImage image;
+		Expect(image.Parse(&file[0],file.size()),"slide image parses");
+		image.set_pointer_format(&v2);
+		uint64_t value = 0;
+		Expect(image.ReadPtr(base+0x508,&value)&&value==base+0x400,"slide v2 ReadPtr");
+		Objc2Parser<Layout64> parser(image);
+		Objc2Parser<Layout64>::MethodList methods;
+		Objc2Method method = Objc2Method();
+		Expect(parser.ReadMethodList(base+0x500,&methods)&&methods.Get(0,&method),"slide v2 method list");
+		Expect(SameString(image.ReadCString(method.name),"init")&&method.types==0&&method.imp==base+0xF00,"slide v2 method fields,null stays null");
+		MethodSum visited;
+		methods.ForEach(visited);
+		Expect(visited.sum==((base+0x400)^(base+0xF00)),"slide v2 ForEach");
+		//v3 authenticated:offset from the cache base,plain:tag byte from bits 43..50
+		MachoPointerFormat v3 = {MachoPointerFormat::kSlideInfoV3,~0ULL,base};
+		image.set_pointer_format(&v3);
+		Expect(image.Target((1ULL<<63)|(0x5ULL<<49)|0x1234)==base+0x1234,"slide v3 authenticated");
+		Expect(image.Target((0x12ULL<<43)|(3ULL<<51)|0x180001000ULL)==((0x12ULL<<56)|0x180001000ULL),"slide v3 plain");
+		image.set_pointer_format(NULL);
+		Expect(image.Target(delta|0x400)==(delta|0x400),"no slide info stores plain pointers");
+	}
+	void CheckFat(){
+		std::vector<uint8> thin;
+		BuildImage(MachoImage::kCpuTypeX86_64,false,0x100000000ULL,0x100,NULL,0,&thin);
+		//fat_header and two fat_arch,big endian,the slices 4k aligned
+		std::vector<uint8> file(0x3000,0);
+		Put32(&file,0,kFatMagic,true);
+		Put32(&file,4,2,true);
+		const uint32 cputypes[] = {MachoImage::kCpuTypeX86_64,MachoImage::kCpuTypeArm64};
+		for(uint32 index=0;index<2;index++){
+			size_t arch = 8+index*20;
+			Put32(&file,arch,cputypes[index],true);
+			Put32(&file,arch+8,0x1000*(index+1),true);
+			Put32(&file,arch+12,0x100,true);
+			Put32(&file,arch+16,12,true);
+			memcpy(&file[0x1000*(index+1)],&thin[0],thin.size());
+			Put32(&file,0x1000*(index+1)+4,cputypes[index],false);
+		}
+		MachoImage image;
+		Expect(image.Parse(&file[0],file.size())&&image.slices().size()==2,"fat slices");
+		Expect(image.SelectCpu(MachoImage::kCpuTypeArm64)&&image.cputype()==MachoImage::kCpuTypeArm64&&image.is64(),"fat SelectCpu");
+		//nfat_arch whose records would run past the file
+		Put32(&file,4,0x20000000,true);
+		Expect(!image.Parse(&file[0],file.size()),"fat count past the file");
+	}
+	//module -> symtab -> class -> metaclass,one method
+	void CheckObjc1(){
+		const uint64_t base = 0x1000;
+		const FixtureSection sections[] = {{"__OBJC","__module_info",0x400,0x10}};
+		std::vector<uint8> file;
+		BuildImage(MachoImage::kCpuTypeX86,false,base,0x800,sections,1,&file);
+		Put32(&file,0x400,7,false);
+		Put32(&file,0x404,0x10,false);
+		Put32(&file,0x40C,base+0x500,false);
+		Put16(&file,0x500+Objc1Layout::kSymtabClassCount,1,false);
+		Put32(&file,0x500+Objc1Layout::kSymtabDefs,base+0x600,false);
+		Put32(&file,0x600+Objc1Layout::kClassIsa,base+0x640,false);
+		Put32(&file,0x600+Objc1Layout::kClassName,base+0x700,false);
+		Put32(&file,0x600+Objc1Layout::kClassMethods,base+0x6A0,false);
+		Put32(&file,0x6A0+Objc1Layout::kMethodListCount,1,false);
+		Put32(&file,0x6A0+Objc1Layout::kMethodListEntries+Objc1Layout::kMethodName,base+0x710,false);
+		Put32(&file,0x6A0+Objc1Layout::kMethodListEntries+Objc1Layout::kMethodTypes,base+0x720,false);
+		Put32(&file,0x6A0+Objc1Layout::kMethodListEntries+Objc1Layout::kMethodImp,0x2000,false);
+		PutString(&file,0x700,"Foo");
+		PutString(&file,0x710,"bar");
+		PutString(&file,0x720,"v8@0:4");
+		MachoImage image;
+		Expect(image.Parse(&file[0],file.size()),"objc1 image parses");
+		Objc1Parser<Layout32> parser(image);
+		Objc1Chain chain;
+		Expect(parser.ReadChain(&chain)&&chain.modules.size()==1&&chain.symtabs.size()==1,"objc1 module chain");
+		Expect(chain.classes.size()==1&&chain.classes[0]==base+0x600&&chain.metaclasses.size()==1&&chain.metaclasses[0]==base+0x640,"objc1 classes and metaclasses");
+		Objc1Class cls = Objc1Class();
+		std::vector<Objc1Method> methods;
+		Expect(parser.ReadClass(base+0x600,&cls)&&SameString(parser.ReadString(cls.name),"Foo"),"objc1 class name");
+		Expect(parser.ReadMethodList(cls.methods,&methods)&&methods.size()==1&&SameString(parser.ReadString(methods[0].name),"bar")&&methods[0].imp==0x2000,"objc1 method list");
+	}
+	uint64_t HashOf(const char* data,size_t size,uint64_t seed){
+		StreamHash hash(seed);
+		hash.Update(data,size);
+		return hash.Final();
+	}
+	void CheckStreamHash(){
+		//the reference values of XXH64
+		Expect(HashOf("",0,0)==0xEF46DB3751D8E999ULL,"xxhash64 of nothing");
+		Expect(HashOf("abc",3,0)==0x44BC2CF5AD770999ULL,"xxhash64 of abc");
+		//stripes,a tail and updates that split them anywhere
+		const char data[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef0123456789";
+		const size_t size = sizeof(data)-1;
+		uint64_t whole = HashOf(data,size,0);
+		bool same = true;
+		for(size_t split=1;split<size;split++){
+			StreamHash hash;
+			hash.Update(data,split);
+			hash.Update(data+split,size-split);
+			same = same&&hash.Final()==whole;
+		}
+		Expect(same,"xxhash64 does not depend on the split");
+		Expect(HashOf("abc",3,1)!=HashOf("abc",3,0),"xxhash64 seed");
+	}
+	void CheckStrings(){
+		StringInterner interner;
+		Expect(interner.Intern(StringPiece("alloc"))==0&&interner.Intern(StringPiece("init"))==1&&interner.Intern(StringPiece("alloc"))==0,"interner ids");
+		Expect(interner.size()==2&&SameString(interner.Get(1),"init"),"interner Get");
+		Expect(interner.Find(StringPiece("init"))==1&&interner.Find(StringPiece("copy"))==StringInterner::kNoId,"interner Find");
+		interner.Clear();
+		Expect(interner.size()==0&&interner.Find(StringPiece("alloc"))==StringInterner::kNoId,"interner Clear");
+		//names are interned by content,enough of them to grow the table
+		std::vector<std::string> names;
+		char name[32] = {0};
+		for(uint32 index=0;index<3000;index++){
+			snprintf(name,sizeof(name),"selector%u:",index);
+			names.push_back(name);
+		}
+		NameTable table;
+		bool ids = true;
+		for(uint32 index=0;index<names.size();index++){
+			ids = ids&&table.Intern(names[index].c_str())==index;
+		}
+		Expect(ids&&table.size()==names.size(),"name table ids");
+		bool found = true;
+		for(uint32 index=0;index<names.size();index++){
+			std::string copy(names[index]);
+			found = found&&table.Find(copy.c_str())==index&&table.Intern(copy.c_str())==index&&table.name(index)==names[index].c_str();
+		}
+		Expect(found,"name table finds by content");
+		Expect(table.Find("missing")==NameTable::kNotFound,"name table miss");
+		StringArena arena;
+		char* first = arena.Allocate(5);
+		char* second = arena.Allocate(7);
+		memcpy(first,"init",5);
+		memcpy(second,"dealloc",7);
+		Expect(second==first+5&&memcmp(first,"init",5)==0&&arena.allocated()==12,"arena bumps");
+		char* large = arena.Allocate(3<<20);
+		large[(3<<20)-1] = 'x';
+		Expect(large!=NULL&&memcmp(first,"init",5)==0&&arena.allocated()==12+(3<<20),"arena block of its own");
+		arena.Release();
+		Expect(arena.allocated()==0,"arena Release");
+	}
+	void CheckTypeEncodings(){
+		TypeEncodingParser parser;
+		std::string decl;
+		uint32 plain = parser.Parse(StringPiece("v16@0:8"));
+		parser.Declaration(plain,StringPiece("f"),false,&decl);
+		Expect(plain!=TypeEncodingParser::kNoSignature&&decl=="void f(id self, SEL _cmd)","encoding v16@0:8");
+		uint32 object = parser.Parse(StringPiece("@24@0:8@16"));
+		parser.Declaration(object,StringPiece("f"),false,&decl);
+		Expect(decl=="id f(id self, SEL _cmd, id arg2)"&&parser.signature(object).argument_count==3,"encoding @24@0:8@16");
+		uint32 aggregate = parser.Parse(StringPiece("{CGRect={CGPoint=dd}{CGSize=dd}}16@0:8"));
+		parser.Declaration(aggregate,StringPiece("f"),false,&decl);
+		Expect(decl=="struct CGRect f(id self, SEL _cmd)"&&parser.signature(aggregate).flags==TypeEncodingParser::kByValueAggregate,"encoding struct by value");
+		uint32 pointer = parser.Parse(StringPiece("c24@0:8^{__CFString=}16"));
+		parser.Declaration(pointer,StringPiece("f"),true,&decl);
+		Expect(decl=="char f(id self, SEL _cmd, void * arg2)"&&parser.signature(pointer).flags==TypeEncodingParser::kAggregatePointer,"encoding opaque struct pointer");
+		Expect(parser.Parse(StringPiece("{"))==TypeEncodingParser::kNoSignature,"encoding malformed");
+		Expect(parser.Parse(StringPiece("v16@0:8"))==plain&&parser.hits()==1&&parser.signature_count()==4,"encoding parsed once");
+	}
+	//references by target,a fixed call graph
+	class TableReferences:public CallReferenceSource
+	{
+	public:
+		void Add(uint64_t target,uint64_t from,uint32 kind,uint64_t next){
+			Reference reference = {from,kind,next};
+			table_.push_back(std::make_pair(target,reference));
+		}
+		virtual void ReferencesTo(uint64_t target,std::vector<Reference>* references) const{
+			references->clear();
+			for(size_t index=0;index<table_.size();index++){
+				if(table_[index].first==target){
+					references->push_back(table_[index].second);
+				}
+			}
+		}
+	private:
+		std::vector<std::pair<uint64_t,Reference> > table_;
+	};
+	//every site keeps the flags of the variant it was reached from,also
+	//through stubs and import pointers:sends to super that lost them were
+	//never resolved through the class graph
+	void CheckCallSites(){
+		const uint32 kSuper = 0x2;
+		const uint32 kStret = 0x1;
+		TableReferences references;
+		//objc_msgSend:a call and its import pointer read by an indirect call
+		references.Add(0x100,0x1000,CallReferenceSource::kCall,0);
+		references.Add(0x100,0x200,CallReferenceSource::kPointer,0x200);
+		references.Add(0x200,0x1010,CallReferenceSource::kCall,0);
+		//objc_msgSendSuper2:a stub called twice,whose pointer is read once
+		references.Add(0x300,0x400,CallReferenceSource::kStub,0x400);
+		references.Add(0x300,0x310,CallReferenceSource::kOther,0);
+		references.Add(0x400,0x1030,CallReferenceSource::kCall,0);
+		references.Add(0x400,0x1020,CallReferenceSource::kCall,0);
+		references.Add(0x400,0x500,CallReferenceSource::kPointer,0x500);
+		references.Add(0x500,0x1040,CallReferenceSource::kCall,0);
+		//objc_msgSendSuper2_stret,with a stub back into the one above
+		references.Add(0x600,0x1050,CallReferenceSource::kCall,0);
+		references.Add(0x600,0x400,CallReferenceSource::kStub,0x300);
+		CallSiteCollector collector(references);
+		Expect(collector.Add(0x100,0)==2,"call sites of a function and its pointer");
+		Expect(collector.Add(0x300,kSuper)==3,"call sites through a stub and its pointer");
+		Expect(collector.Add(0x600,kSuper|kStret)==1&&collector.Add(0x300,kSuper)==0,"call sites of a target followed once");
+		std::vector<std::pair<uint64_t,uint32> > calls;
+		collector.Finish(&calls);
+		const std::pair<uint64_t,uint32> expected[] = {
+			std::make_pair(uint64_t(0x1000),0u),
+			std::make_pair(uint64_t(0x1010),0u),
+			std::make_pair(uint64_t(0x1020),kSuper),
+			std::make_pair(uint64_t(0x1030),kSuper),
+			std::make_pair(uint64_t(0x1040),kSuper),
+			std::make_pair(uint64_t(0x1050),kSuper|kStret)
+		};
+		bool same = calls.size()==sizeof(expected)/sizeof(expected[0]);
+		for(size_t index=0;same&&index<calls.size();index++){
+			same = calls[index]==expected[index];
+		}
+		Expect(same,"call sites sorted with the flags of their variant");
+	}
+	//dyld_cache_header,one mapping over the whole file,one image,local
+	//symbols,slide info v2 and an objc_stringhash_t of selectors
+	const uint64_t kCacheBase = 0x180000000ULL;
+	const size_t kCacheSize = 0x3000;
+	const size_t kCacheImage = 0x1000;
+	const size_t kCacheHash = 0x1800;
+	const size_t kCacheStrings = 0x1E00;
+	const size_t kCacheSymbols = 0x2010;
+	const size_t kCacheSlideInfo = 0x2800;
+	//the selectors and the low byte of their lookup8 hash with salt 0x1234,
+	//their lengths cover every tail of the hash and its 24 byte loop
+	struct HashedKey
+	{
+		const char* key;
+		uint32 low_byte;
+	};
+	const HashedKey kHashedKeys[] = {
+		{"init",0x54},
+		{"dealloc",0xEC},
+		{"initWithFrame:",0x25},
+		{"setValue:forKey:",0x4A},
+		{"tableView:cellForRowAtIndexPath:",0x6B},
+		{"observeValueForKeyPath:ofObject:change:context:",0x50}
+	};
+	void BuildCache(std::vector<uint8>* file){
+		file->assign(kCacheSize,0);
+		memcpy(&(*file)[0],"dyld_v1   arm64",15);
+		Put32(file,16,0x58,false);
+		Put32(file,20,1,false);
+		Put32(file,24,0x78,false);
+		Put32(file,28,1,false);
+		Put64(file,56,kCacheSlideInfo,false);
+		Put64(file,64,40,false);
+		Put64(file,72,kCacheSymbols,false);
+		Put64(file,80,0x100,false);
+		Put64(file,0x58,kCacheBase,false);
+		Put64(file,0x60,kCacheSize,false);
+		Put32(file,0x78+24,0x98,false);
+		Put64(file,0x78,kCacheBase+kCacheImage,false);
+		PutString(file,0x98,"/usr/lib/libfixture.dylib");
+		Put32(file,kCacheImage,kMhMagic64,false);
+		Put32(file,kCacheImage+4,MachoImage::kCpuTypeArm64,false);
+		Put32(file,kCacheImage+12,6,false);
+		Put64(file,kCacheImage+0x100,0x0012000000001200ULL,false);
+		//shift 64 leaves the index to scramble[tab[hash&mask]]
+		Put32(file,kCacheHash,8,false);
+		Put32(file,kCacheHash+4,6,false);
+		Put32(file,kCacheHash+8,64,false);
+		Put32(file,kCacheHash+12,0xFF,false);
+		Put64(file,kCacheHash+24,0x1234,false);
+		size_t strings = kCacheStrings;
+		for(uint32 index=0;index<sizeof(kHashedKeys)/sizeof(kHashedKeys[0]);index++){
+			const char* key = kHashedKeys[index].key;
+			Put32(file,kCacheHash+32+(index+1)*4,index+1,false);
+			(*file)[kCacheHash+32+1024+kHashedKeys[index].low_byte] = static_cast<uint8>(index+1);
+			(*file)[kCacheHash+32+1024+256+index+1] = static_cast<uint8>(((key[0]&0x7)<<5)|(strlen(key)&0x1F));
+			Put32(file,kCacheHash+32+1024+256+8+(index+1)*4,static_cast<uint32>(strings-kCacheHash),false);
+			PutString(file,strings,key);
+			strings += strlen(key)+1;
+		}
+		//dyld_cache_local_symbols_info,two nlist_64 of the image
+		size_t info = kCacheSymbols;
+		Put32(file,info,24,false);
+		Put32(file,info+4,2,false);
+		Put32(file,info+8,56,false);
+		Put32(file,info+12,16,false);
+		Put32(file,info+16,72,false);
+		Put32(file,info+20,1,false);
+		Put32(file,info+24,1,false);
+		(*file)[info+28] = 0x0E;
+		Put64(file,info+32,kCacheBase+kCacheImage+0x200,false);
+		Put32(file,info+40,7,false);
+		(*file)[info+44] = 0x0E;
+		Put64(file,info+48,kCacheBase+kCacheImage+0x100,false);
+		PutString(file,info+57,"_beta");
+		PutString(file,info+63,"_alpha");
+		Put32(file,info+72,kCacheImage,false);
+		Put32(file,info+80,2,false);
+		//dyld_cache_slide_info2
+		Put32(file,kCacheSlideInfo,2,false);
+		Put32(file,kCacheSlideInfo+4,0x1000,false);
+		Put64(file,kCacheSlideInfo+24,0x00FFFF0000000000ULL,false);
+		Put64(file,kCacheSlideInfo+32,kCacheBase,false);
+	}
+	void CheckLocalSymbols(const DyldCache& cache,const char* mode){
+		std::vector<DyldLocalSymbol> symbols;
+		bool ok = cache.images().size()==1&&SameString(cache.images()[0].path,"/usr/lib/libfixture.dylib")&&
+			cache.LocalSymbols(0,&symbols)&&symbols.size()==2;
+		Expect(ok&&symbols[0].address==kCacheBase+kCacheImage+0x100&&SameString(symbols[0].name,"_alpha")&&
+			symbols[1].address==kCacheBase+kCacheImage+0x200&&SameString(symbols[1].name,"_beta"),mode);
+	}
+	void CheckDyldCache(const std::string& directory){
+		std::vector<uint8> file;
+		BuildCache(&file);
+		std::string path = directory+"/objc_check_cache.bin";
+		FILE* out = fopen(path.c_str(),"wb");
+		bool written = out!=NULL&&fwrite(&file[0],1,file.size(),out)==file.size();
+		if(out!=NULL){
+			fclose(out);
+		}
+		Expect(written,"cache fixture written");
+		if(!written){
+			return;
+		}
+		DyldCache cache;
+		Expect(cache.Open(path)&&cache.arch()=="arm64"&&cache.is64()&&cache.mappings().size()==1,"cache header");
+		Expect(cache.pointer_format().version==MachoPointerFormat::kSlideInfoV2&&cache.pointer_format().value_add==kCacheBase,"cache slide info v2");
+		MachoImage image;
+		uint64_t value = 0;
+		Expect(cache.OpenImage(0,&image)&&image.ReadPtr(kCacheBase+kCacheImage+0x100,&value)&&value==kCacheBase+0x1200,"cache image pointer through slide info");
+		CheckLocalSymbols(cache,"cache local symbols");
+		ObjcOptStringHash hash;
+		Expect(hash.Parse(cache,kCacheBase+kCacheHash)&&hash.capacity()==8,"lookup8 table parses");
+		bool found = true;
+		for(uint32 index=0;index<sizeof(kHashedKeys)/sizeof(kHashedKeys[0]);index++){
+			found = found&&hash.Find(kHashedKeys[index].key)==index+1;
+		}
+		Expect(found,"lookup8 finds every key in its slot");
+		Expect(hash.Find("alloc")==ObjcOptStringHash::kNotFound&&hash.Find("")==ObjcOptStringHash::kNotFound,"lookup8 miss");
+		cache.Close();
+		Expect(cache.OpenTables(path)&&cache.size()<kCacheImage,"cache tables only");
+		CheckLocalSymbols(cache,"cache local symbols from their own view");
+		cache.Close();
+		remove(path.c_str());
+	}
+}
+
+int main(int argc,char* argv[]){
+	if(argc>2){
+		fprintf(stderr,"usage: objc_check [scratch directory]\n");
+		return 1;
+	}
+	CheckObjc2<Layout64>(MachoImage::kCpuTypeArm64);
+	CheckObjc2<Layout32>(MachoImage::kCpuTypeArm);
+	CheckObjc2<Layout32BE>(kCpuTypePowerPC);
+	CheckSlideInfo();
+	CheckFat();
+	CheckObjc1();
+	CheckStreamHash();
+	CheckStrings();
+	CheckTypeEncodings();
+	CheckCallSites();
+	CheckDyldCache((argc==2)?argv[1]:".");
+	printf("objc_check: %u checks,%u failed\n",checks,failures);
+	return (failures==0)?0:1;
+}
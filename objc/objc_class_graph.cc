@@ -0,0 +1,284 @@
+#include "objc/objc_class_graph.h"
+#include <algorithm>
+
+namespace objc{
+	namespace{
+		bool SelectorLess(const ClassGraph::Method& method,uint32 selector){
+			return method.selector<selector;
+		}
+		uint32 SelectorKey(const ClassGraph::Method& method){
+			return method.selector;
+		}
+		uint32 NodeKey(const ClassGraph::Method& method){
+			return method.node;
+		}
+		//stable,rows gets the start of every bucket and one past the end
+		void CountingSort(const std::vector<ClassGraph::Method>& in,uint32 buckets,uint32 (*key)(const ClassGraph::Method&),
+			std::vector<uint32>* rows,std::vector<ClassGraph::Method>* out){
+			rows->assign(buckets+1,0);
+			for(std::vector<ClassGraph::Method>::const_iterator it = in.begin();it!=in.end();++it){
+				(*rows)[key(*it)+1]++;
+			}
+			for(uint32 index=1;index<=buckets;index++){
+				(*rows)[index] += (*rows)[index-1];
+			}
+			std::vector<uint32> fill(rows->begin(),rows->end()-1);
+			out->resize(in.size());
+			for(std::vector<ClassGraph::Method>::const_iterator it = in.begin();it!=in.end();++it){
+				(*out)[fill[key(*it)]++] = *it;
+			}
+		}
+	}
+	ClassGraph::ClassGraph(void):cache_hits_(0),cache_misses_(0),overridden_count_(0),max_depth_(0){
+	}
+	ClassGraph::~ClassGraph(void){
+	}
+	uint32 ClassGraph::AddClass(uint64_t ea,const StringPiece& name,uint32 flags){
+		std::unordered_map<uint64_t,uint32>::const_iterator it = by_ea_.find(ea);
+		if(it!=by_ea_.end()){
+			return it->second;
+		}
+		Node node = {ea,names_.Intern(name),flags,kNoNode,kNoNode,0,0,0};
+		uint32 index = static_cast<uint32>(nodes_.size());
+		nodes_.push_back(node);
+		Link link = {0,kNoName,0};
+		links_.push_back(link);
+		by_ea_[ea] = index;
+		//the first definition of a name wins
+		by_name_.insert(std::make_pair(NameKey(node.name,flags),index));
+		return index;
+	}
+	uint32 ClassGraph::AddImportedClass(const StringPiece& name,uint32 flags){
+		uint32 node = FindClassNamed(name,flags);
+		if(node!=kNoNode){
+			return node;
+		}
+		Node imported = {0,names_.Intern(name),(flags&kMetaClass)|kImported,kNoNode,kNoNode,0,0,0};
+		node = static_cast<uint32>(nodes_.size());
+		nodes_.push_back(imported);
+		Link link = {0,kNoName,0};
+		links_.push_back(link);
+		by_name_.insert(std::make_pair(NameKey(imported.name,flags),node));
+		return node;
+	}
+	void ClassGraph::SetSuperclass(uint32 node,uint64_t superclass){
+		links_[node].ea = superclass;
+	}
+	void ClassGraph::SetSuperclassName(uint32 node,const StringPiece& name,uint32 flags){
+		links_[node].name = names_.Intern(name);
+		links_[node].flags = flags;
+	}
+	void ClassGraph::SetMetaclass(uint32 node,uint32 metaclass){
+		nodes_[node].metaclass = metaclass;
+	}
+	void ClassGraph::AddMethod(uint32 node,const StringPiece& selector,uint64_t imp,const StringPiece& category){
+		Method method;
+		method.imp = imp;
+		method.selector = selectors_.Intern(selector);
+		method.node = node;
+		method.category = category.empty()?uint32(kNoName):names_.Intern(category);
+		method.flags = 0;
+		pending_.push_back(method);
+	}
+	void ClassGraph::Build(){
+		ResolveLinks();
+		Number();
+		MergeMethods();
+		cache_.clear();
+		cache_hits_ = 0;
+		cache_misses_ = 0;
+	}
+	void ClassGraph::Clear(){
+		names_.Clear();
+		selectors_.Clear();
+		nodes_.clear();
+		links_.clear();
+		by_ea_.clear();
+		by_name_.clear();
+		preorder_.clear();
+		pending_.clear();
+		method_rows_.clear();
+		methods_.clear();
+		imps_.clear();
+		cache_.clear();
+		cache_hits_ = 0;
+		cache_misses_ = 0;
+		overridden_count_ = 0;
+		max_depth_ = 0;
+	}
+	uint32 ClassGraph::FindClass(uint64_t ea) const{
+		std::unordered_map<uint64_t,uint32>::const_iterator it = by_ea_.find(ea);
+		return (it!=by_ea_.end())?it->second:uint32(kNoNode);
+	}
+	uint32 ClassGraph::FindClassNamed(const StringPiece& name,uint32 flags) const{
+		uint32 id = names_.Find(name);
+		if(id==kNoName){
+			return kNoNode;
+		}
+		std::unordered_map<uint64_t,uint32>::const_iterator it = by_name_.find(NameKey(id,flags));
+		return (it!=by_name_.end())?it->second:uint32(kNoNode);
+	}
+	void ClassGraph::ResolveLinks(){
+		for(size_t index=0;index<nodes_.size();index++){
+			const Link& link = links_[index];
+			uint32 superclass = kNoNode;
+			if(link.ea!=0){
+				superclass = FindClass(link.ea);
+			}
+			else if(link.name!=kNoName){
+				std::unordered_map<uint64_t,uint32>::const_iterator it = by_name_.find(NameKey(link.name,link.flags));
+				superclass = (it!=by_name_.end())?it->second:uint32(kNoNode);
+			}
+			//superclasses bound from other images leave a root behind
+			nodes_[index].superclass = (superclass!=index)?superclass:uint32(kNoNode);
+		}
+	}
+	void ClassGraph::Number(){
+		uint32 count = static_cast<uint32>(nodes_.size());
+		//children by parent,compressed like the methods
+		std::vector<uint32> rows(count+1,0);
+		for(uint32 index=0;index<count;index++){
+			if(nodes_[index].superclass!=kNoNode){
+				rows[nodes_[index].superclass+1]++;
+			}
+		}
+		for(uint32 index=1;index<=count;index++){
+			rows[index] += rows[index-1];
+		}
+		std::vector<uint32> children(rows[count]);
+		std::vector<uint32> fill(rows.begin(),rows.end()-1);
+		for(uint32 index=0;index<count;index++){
+			if(nodes_[index].superclass!=kNoNode){
+				children[fill[nodes_[index].superclass]++] = index;
+			}
+		}
+		preorder_.clear();
+		preorder_.reserve(count);
+		max_depth_ = 0;
+		std::vector<bool> visited(count,false);
+		//(node,next child) pairs,metadata can be deep enough to make
+		//recursion a bad idea
+		std::vector<std::pair<uint32,uint32> > stack;
+		//roots first,then whatever only a superclass cycle reaches,which is
+		//cut where it is entered
+		for(uint32 pass=0;pass<2;pass++){
+			for(uint32 root=0;root<count;root++){
+				if(visited[root]||(pass==0&&nodes_[root].superclass!=kNoNode)){
+					continue;
+				}
+				if(pass!=0){
+					nodes_[root].superclass = kNoNode;
+				}
+				visited[root] = true;
+				nodes_[root].depth = 0;
+				nodes_[root].enter = static_cast<uint32>(preorder_.size());
+				preorder_.push_back(root);
+				stack.push_back(std::make_pair(root,rows[root]));
+				while(!stack.empty()){
+					std::pair<uint32,uint32>& top = stack.back();
+					if(top.second==rows[top.first+1]){
+						nodes_[top.first].exit = static_cast<uint32>(preorder_.size());
+						stack.pop_back();
+						continue;
+					}
+					uint32 child = children[top.second++];
+					if(visited[child]){
+						continue;
+					}
+					uint32 depth = nodes_[top.first].depth+1;
+					visited[child] = true;
+					nodes_[child].depth = depth;
+					nodes_[child].enter = static_cast<uint32>(preorder_.size());
+					max_depth_ = std::max(max_depth_,depth);
+					preorder_.push_back(child);
+					stack.push_back(std::make_pair(child,rows[child]));
+				}
+			}
+		}
+	}
+	void ClassGraph::MergeMethods(){
+		//load order as the runtime ends up with it:each category attached
+		//goes in front,so the last one comes first and the class last
+		std::vector<Method> ordered;
+		ordered.reserve(pending_.size());
+		for(std::vector<Method>::const_reverse_iterator it = pending_.rbegin();it!=pending_.rend();++it){
+			if(it->category!=kNoName){
+				ordered.push_back(*it);
+			}
+		}
+		for(std::vector<Method>::const_iterator it = pending_.begin();it!=pending_.end();++it){
+			if(it->category==kNoName){
+				ordered.push_back(*it);
+			}
+		}
+		std::vector<Method>().swap(pending_);
+		//by selector,then by node keeps the selectors in order within a node
+		//and the load order within a selector
+		std::vector<uint32> selector_rows;
+		std::vector<Method> by_selector;
+		CountingSort(ordered,selectors_.size(),SelectorKey,&selector_rows,&by_selector);
+		CountingSort(by_selector,static_cast<uint32>(nodes_.size()),NodeKey,&method_rows_,&methods_);
+		overridden_count_ = 0;
+		for(size_t index=1;index<methods_.size();index++){
+			Method& method = methods_[index];
+			Method& previous = methods_[index-1];
+			if(method.node==previous.node&&method.selector==previous.selector){
+				method.flags |= kOverridden;
+				overridden_count_++;
+				//the first of the run is the one the runtime calls
+				if((previous.flags&kOverridden)==0&&previous.category!=kNoName){
+					previous.flags |= kOverrides;
+				}
+			}
+		}
+		imps_.clear();
+		imps_.reserve(methods_.size());
+		for(size_t index=0;index<methods_.size();index++){
+			imps_.push_back(std::make_pair(methods_[index].imp,static_cast<uint32>(index)));
+		}
+		std::sort(imps_.begin(),imps_.end());
+	}
+	uint32 ClassGraph::OwnMethod(uint32 node,uint32 selector) const{
+		std::vector<Method>::const_iterator first = methods_.begin()+method_rows_[node];
+		std::vector<Method>::const_iterator last = methods_.begin()+method_rows_[node+1];
+		std::vector<Method>::const_iterator it = std::lower_bound(first,last,selector,SelectorLess);
+		return (it!=last&&it->selector==selector)?static_cast<uint32>(it-methods_.begin()):uint32(kNoMethod);
+	}
+	const ClassGraph::Method* ClassGraph::Lookup(uint32 node,uint32 selector) const{
+		if(node+1>=method_rows_.size()||selector>=selectors_.size()){
+			return NULL;
+		}
+		std::unordered_map<uint64_t,uint32>::const_iterator it = cache_.find((uint64_t(node)<<32)|selector);
+		uint32 method = kNoMethod;
+		if(it!=cache_.end()){
+			cache_hits_++;
+			method = it->second;
+		}
+		else{
+			cache_misses_++;
+			uint32 found = node;
+			while(found!=kNoNode&&(method = OwnMethod(found,selector))==kNoMethod){
+				found = nodes_[found].superclass;
+			}
+			//every class on the way answers the same,misses included
+			for(uint32 walk=node;walk!=found;walk = nodes_[walk].superclass){
+				cache_[(uint64_t(walk)<<32)|selector] = method;
+			}
+			if(found!=kNoNode){
+				cache_[(uint64_t(found)<<32)|selector] = method;
+			}
+		}
+		return (method!=kNoMethod)?&methods_[method]:NULL;
+	}
+	void ClassGraph::AppendMethodName(const Method& method,std::string* name) const{
+		name->append(((nodes_[method.node].flags&kMetaClass)!=0)?"+[":"-[").append(class_name(method.node));
+		if(method.category!=kNoName){
+			name->append("(").append(category_name(method)).append(")");
+		}
+		name->append(" ").append(selector_name(method.selector)).append("]");
+	}
+	const ClassGraph::Method* ClassGraph::FindImplementation(uint64_t imp) const{
+		std::vector<std::pair<uint64_t,uint32> >::const_iterator it = std::lower_bound(imps_.begin(),imps_.end(),std::make_pair(imp,uint32(0)));
+		return (it!=imps_.end()&&it->first==imp)?&methods_[it->second]:NULL;
+	}
+}
@@ -0,0 +1,181 @@
+#ifndef OBJC_OBJC_CLASS_GRAPH_H_
+#define OBJC_OBJC_CLASS_GRAPH_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "objc/objc_selector_index.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//classes and metaclasses of the image as one superclass forest in flat
+	//arrays.a depth first walk numbers the nodes so the subclasses of a node
+	//are the run preorder[enter,exit),which makes IsSubclass two compares.
+	//Build merges the categories into the method tables of their classes in
+	//load order and flags what they override.Lookup resolves a selector the
+	//way the runtime does,categories before the class and the class before
+	//its superclasses,and caches the answer for the node.no ida headers here
+	class ClassGraph
+	{
+	public:
+		enum{
+			kNoNode = 0xFFFFFFFF,
+			kNoMethod = 0xFFFFFFFF,
+			kNoName = StringInterner::kNoId
+		};
+		enum{
+			kMetaClass = 0x1,
+			//a class of another image a bind points at,it has no ea and
+			//only the methods categories of this image add
+			kImported = 0x2
+		};
+		enum{
+			//a category method hiding other implementations of its selector
+			//on the same class
+			kOverrides = 0x1,
+			//hidden by the method in front of it
+			kOverridden = 0x2
+		};
+		struct Node
+		{
+			uint64_t ea;
+			uint32 name;
+			uint32 flags;
+			uint32 superclass;
+			//the metaclass of a class,kNoNode for metaclasses
+			uint32 metaclass;
+			uint32 depth;
+			//position in preorder,the subtree ends before exit
+			uint32 enter;
+			uint32 exit;
+		};
+		struct Method
+		{
+			uint64_t imp;
+			uint32 selector;
+			uint32 node;
+			//kNoName for the class's own methods
+			uint32 category;
+			uint32 flags;
+		};
+		ClassGraph(void);
+		~ClassGraph(void);
+		//the node of the class at ea,added once
+		uint32 AddClass(uint64_t ea,const StringPiece& name,uint32 flags);
+		//the node of a class outside the image,by name and kind
+		uint32 AddImportedClass(const StringPiece& name,uint32 flags);
+		//superclasses are resolved by Build,by address or,for objc1 where
+		//the image only names them,by name and kind
+		void SetSuperclass(uint32 node,uint64_t superclass);
+		void SetSuperclassName(uint32 node,const StringPiece& name,uint32 flags);
+		void SetMetaclass(uint32 node,uint32 metaclass);
+		//category is empty for the class's own methods.the categories of a
+		//class are expected in load order
+		void AddMethod(uint32 node,const StringPiece& selector,uint64_t imp,const StringPiece& category);
+		void Build();
+		void Clear();
+		uint32 FindClass(uint64_t ea) const;
+		uint32 FindClassNamed(const StringPiece& name,uint32 flags) const;
+		uint32 FindSelector(const StringPiece& selector) const{
+			return selectors_.Find(selector);
+		}
+		//the method a message to an instance of node runs,NULL when neither
+		//node nor its superclasses in the image implement it
+		const Method* Lookup(uint32 node,uint32 selector) const;
+		//the method that implements imp,NULL when imp is no method
+		const Method* FindImplementation(uint64_t imp) const;
+		//the methods of node,its table after the merge
+		const Method* methods_begin(uint32 index) const{
+			return methods_.empty()?NULL:&methods_[0]+method_rows_[index];
+		}
+		const Method* methods_end(uint32 index) const{
+			return methods_.empty()?NULL:&methods_[0]+method_rows_[index+1];
+		}
+		bool IsSubclass(uint32 node,uint32 ancestor) const{
+			return nodes_[ancestor].enter<=nodes_[node].enter&&nodes_[node].exit<=nodes_[ancestor].exit;
+		}
+		const Node& node(uint32 index) const{
+			return nodes_[index];
+		}
+		//node and its subclasses
+		const uint32* subtree_begin(uint32 index) const{
+			return &preorder_[0]+nodes_[index].enter;
+		}
+		const uint32* subtree_end(uint32 index) const{
+			return &preorder_[0]+nodes_[index].exit;
+		}
+		const char* class_name(uint32 index) const{
+			return names_.Get(nodes_[index].name);
+		}
+		const char* selector_name(uint32 selector) const{
+			return selectors_.Get(selector);
+		}
+		//-[Class(Category) selector] the way the runtime prints it
+		void AppendMethodName(const Method& method,std::string* name) const;
+		const char* category_name(const Method& method) const{
+			return (method.category!=kNoName)?names_.Get(method.category):"";
+		}
+		uint32 node_count() const{
+			return static_cast<uint32>(nodes_.size());
+		}
+		uint32 method_count() const{
+			return static_cast<uint32>(methods_.size());
+		}
+		//methods hidden by a category
+		uint32 overridden_count() const{
+			return overridden_count_;
+		}
+		uint32 max_depth() const{
+			return max_depth_;
+		}
+		uint32 cache_hits() const{
+			return cache_hits_;
+		}
+		uint32 cache_misses() const{
+			return cache_misses_;
+		}
+	private:
+		//what SetSuperclass and SetSuperclassName asked for,by node
+		struct Link
+		{
+			uint64_t ea;
+			uint32 name;
+			uint32 flags;
+		};
+		static uint64_t NameKey(uint32 name,uint32 flags){
+			return (uint64_t(name)<<1)|(flags&kMetaClass);
+		}
+		void ResolveLinks();
+		void Number();
+		//linear in the methods:counting sorts by selector id and node
+		void MergeMethods();
+		//the method of node itself,kNoMethod when it has none
+		uint32 OwnMethod(uint32 node,uint32 selector) const;
+		StringInterner names_;
+		StringInterner selectors_;
+		std::vector<Node> nodes_;
+		std::vector<Link> links_;
+		std::unordered_map<uint64_t,uint32> by_ea_;
+		std::unordered_map<uint64_t,uint32> by_name_;
+		std::vector<uint32> preorder_;
+		//methods in the order they were added
+		std::vector<Method> pending_;
+		//methods_[method_rows_[n]..method_rows_[n+1]) are the methods of node
+		//n by selector,the winner of a selector first
+		std::vector<uint32> method_rows_;
+		std::vector<Method> methods_;
+		//imps and their method,by imp
+		std::vector<std::pair<uint64_t,uint32> > imps_;
+		//(node<<32)|selector -> method or kNoMethod
+		mutable std::unordered_map<uint64_t,uint32> cache_;
+		mutable uint32 cache_hits_;
+		mutable uint32 cache_misses_;
+		uint32 overridden_count_;
+		uint32 max_depth_;
+		DISALLOW_EVIL_CONSTRUCTORS(ClassGraph);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
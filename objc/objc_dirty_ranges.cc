@@ -0,0 +1,68 @@
+#include "objc/objc_dirty_ranges.h"
+
+namespace objc{
+	DirtyRanges::DirtyRanges(void){
+	}
+	DirtyRanges::~DirtyRanges(void){
+	}
+	void DirtyRanges::Add(ea_t start,ea_t end){
+		if(start>=end){
+			return;
+		}
+		std::map<ea_t,ea_t>::iterator it = ranges_.upper_bound(start);
+		if(it!=ranges_.begin()){
+			std::map<ea_t,ea_t>::iterator prev = it;
+			--prev;
+			if(prev->second>=start){
+				if(prev->second>=end){
+					return;
+				}
+				start = prev->first;
+				it = prev;
+			}
+		}
+		while(it!=ranges_.end()&&it->first<=end){
+			if(it->second>end){
+				end = it->second;
+			}
+			ranges_.erase(it++);
+		}
+		ranges_[start] = end;
+	}
+	void DirtyRanges::Add(const DirtyRanges& other){
+		for(const_iterator it = other.begin();it!=other.end();++it){
+			Add(it->first,it->second);
+		}
+	}
+	bool DirtyRanges::Overlaps(ea_t start,ea_t end) const{
+		if(start>=end){
+			return false;
+		}
+		const_iterator it = ranges_.upper_bound(start);
+		if(it!=ranges_.begin()){
+			const_iterator prev = it;
+			--prev;
+			if(prev->second>start){
+				return true;
+			}
+		}
+		return it!=ranges_.end()&&it->first<end;
+	}
+	DependencyIndex::DependencyIndex(void){
+	}
+	DependencyIndex::~DependencyIndex(void){
+	}
+	void DependencyIndex::Add(ea_t target,ea_t head){
+		if(target!=BADADDR&&head!=BADADDR&&target!=head){
+			heads_by_target_.insert(std::make_pair(target,head));
+		}
+	}
+	void DependencyIndex::Collect(const DirtyRanges& dirty,DirtyRanges* heads) const{
+		for(DirtyRanges::const_iterator range = dirty.begin();range!=dirty.end();++range){
+			std::set<std::pair<ea_t,ea_t> >::const_iterator it = heads_by_target_.lower_bound(std::make_pair(range->first,ea_t(0)));
+			for(;it!=heads_by_target_.end()&&it->first<range->second;++it){
+				heads->Add(it->second,it->second+1);
+			}
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef OBJC_OBJC_DIRTY_RANGES_H_
+#define OBJC_OBJC_DIRTY_RANGES_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <map>
+#include <set>
+#include <utility>
+#include <ida.hpp>
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//set of half open [start,end) address ranges,overlapping and adjacent
+	//ranges are merged when added
+	class DirtyRanges
+	{
+	public:
+		typedef std::map<ea_t,ea_t>::const_iterator const_iterator;
+		DirtyRanges(void);
+		~DirtyRanges(void);
+		void Add(ea_t start,ea_t end);
+		void Add(const DirtyRanges& other);
+		bool Overlaps(ea_t start,ea_t end) const;
+		void Clear(){
+			ranges_.clear();
+		}
+		bool empty() const{
+			return ranges_.empty();
+		}
+		size_t size() const{
+			return ranges_.size();
+		}
+		const_iterator begin() const{
+			return ranges_.begin();
+		}
+		const_iterator end() const{
+			return ranges_.end();
+		}
+	private:
+		std::map<ea_t,ea_t> ranges_;
+		DISALLOW_EVIL_CONSTRUCTORS(DirtyRanges);
+	};
+	//which section head touched which address in earlier runs,so a change to
+	//e.g. a method implementation leads back to the method list naming it
+	class DependencyIndex
+	{
+	public:
+		//(target,head) pairs ordered by target
+		typedef std::set<std::pair<ea_t,ea_t> >::const_iterator const_iterator;
+		DependencyIndex(void);
+		~DependencyIndex(void);
+		void Add(ea_t target,ea_t head);
+		//adds the heads of every target inside dirty to heads
+		void Collect(const DirtyRanges& dirty,DirtyRanges* heads) const;
+		void Clear(){
+			heads_by_target_.clear();
+		}
+		size_t size() const{
+			return heads_by_target_.size();
+		}
+		const_iterator begin() const{
+			return heads_by_target_.begin();
+		}
+		const_iterator end() const{
+			return heads_by_target_.end();
+		}
+	private:
+		std::set<std::pair<ea_t,ea_t> > heads_by_target_;
+		DISALLOW_EVIL_CONSTRUCTORS(DependencyIndex);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,148 @@
+#include "objc/objc_fat.h"
+#include <stdio.h>
+#include "objc/macho_image.h"
+#include "objc/objc2_metadata.h"
+
+namespace objc{
+	namespace{
+		class SliceVisitor
+		{
+		public:
+			explicit SliceVisitor(SliceObjc* slice):slice_(slice){}
+			void VisitClass(uint64_t,const char* name){
+				slice_->classes.push_back(name);
+			}
+			void VisitMethod(const char* class_name,const char* selector,uint64_t imp,bool class_method){
+				SliceMethod method;
+				method.class_name = class_name;
+				method.selector = selector;
+				method.imp = imp;
+				method.class_method = class_method;
+				slice_->methods.push_back(method);
+			}
+			void VisitProtocol(uint64_t,const char*){
+			}
+		private:
+			SliceObjc* slice_;
+		};
+		class SliceTask:public ParallelTask
+		{
+		public:
+			SliceTask(const std::string& path,std::vector<SliceObjc>* slices):path_(path),slices_(slices){}
+			virtual void Run(size_t index) const{
+				//a view of its own per slice,nothing is shared between tasks
+				MappedFile file;
+				MachoImage image;
+				SliceObjc* slice = &(*slices_)[index];
+				if(!file.Open(path_)||!image.Parse(file.data(),file.size())||!image.SelectSlice(index)){
+					return;
+				}
+				SliceVisitor visitor(slice);
+				WalkObjc2Metadata(image,&visitor);
+				slice->parsed = true;
+			}
+		private:
+			const std::string& path_;
+			std::vector<SliceObjc>* slices_;
+		};
+	}
+	FatModel::FatModel(void):parsed_slices_(0){
+	}
+	FatModel::~FatModel(void){
+	}
+	bool FatModel::Build(const std::string& path,ThreadPool* pool){
+		slices_.clear();
+		classes_.clear();
+		parsed_slices_ = 0;
+		{
+			//only the fat header is read here
+			MappedFile file;
+			MachoImage image;
+			if(!file.Open(path)||!image.Parse(file.data(),file.size())){
+				return false;
+			}
+			const std::vector<MachoSlice>& slices = image.slices();
+			for(size_t index=0;index<slices.size()&&index<kMaxSlices;index++){
+				SliceObjc slice;
+				slice.cputype = slices[index].cputype;
+				slice.cpusubtype = slices[index].cpusubtype;
+				slice.parsed = false;
+				//thin files carry their cpu in the header
+				if(slices.size()==1&&slice.cputype==0){
+					slice.cputype = image.cputype();
+				}
+				slices_.push_back(slice);
+			}
+		}
+		pool->ParallelFor(slices_.size(),SliceTask(path,&slices_));
+		Merge();
+		return true;
+	}
+	void FatModel::Merge(){
+		for(size_t index=0;index<slices_.size();index++){
+			const SliceObjc& slice = slices_[index];
+			if(!slice.parsed){
+				continue;
+			}
+			uint32 bit = 1u<<index;
+			parsed_slices_ |= bit;
+			for(std::vector<std::string>::const_iterator it = slice.classes.begin();it!=slice.classes.end();++it){
+				Class& cls = classes_[*it];
+				cls.slices |= bit;
+			}
+			for(std::vector<SliceMethod>::const_iterator it = slice.methods.begin();it!=slice.methods.end();++it){
+				Class& cls = classes_[it->class_name];
+				cls.slices |= bit;
+				Method& method = cls.methods[(it->class_method?"+":"-")+it->selector];
+				if(method.imps.empty()){
+					method.imps.resize(slices_.size(),0);
+				}
+				method.slices |= bit;
+				method.imps[index] = it->imp;
+			}
+		}
+	}
+	uint32 FatModel::difference_count() const{
+		uint32 count = 0;
+		for(ClassMap::const_iterator cls = classes_.begin();cls!=classes_.end();++cls){
+			if(cls->second.slices!=parsed_slices_){
+				count++;
+			}
+			for(std::map<std::string,Method>::const_iterator it = cls->second.methods.begin();it!=cls->second.methods.end();++it){
+				if(it->second.slices!=parsed_slices_){
+					count++;
+				}
+			}
+		}
+		return count;
+	}
+	std::string CpuName(uint32 cputype,uint32 cpusubtype){
+		const uint32 kCpuTypePowerPC = 18;
+		const uint32 kCpuSubtypeMask = 0x00FFFFFF;
+		switch(cputype){
+		case MachoImage::kCpuTypeX86:
+			return "i386";
+		case MachoImage::kCpuTypeX86_64:
+			return "x86_64";
+		case MachoImage::kCpuTypeArm64:
+			return ((cpusubtype&kCpuSubtypeMask)==2)?"arm64e":"arm64";
+		case MachoImage::kCpuTypeArm:
+			switch(cpusubtype&kCpuSubtypeMask){
+			case 6:
+				return "armv6";
+			case 9:
+				return "armv7";
+			case 11:
+				return "armv7s";
+			case 12:
+				return "armv7k";
+			}
+			return "arm";
+		case kCpuTypePowerPC:
+			return "ppc";
+		}
+		char name[32] = {0};
+		sprintf(name,"cpu%x",cputype);
+		return name;
+	}
+}
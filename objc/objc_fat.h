@@ -0,0 +1,83 @@
+#ifndef OBJC_OBJC_FAT_H_
+#define OBJC_OBJC_FAT_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <map>
+#include "objc/objc_thread_pool.h"
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:ida loads one slice of a universal binary,this reads
+//all of them straight from the file
+namespace objc{
+	struct SliceMethod
+	{
+		std::string class_name;
+		std::string selector;
+		uint64_t imp;
+		bool class_method;
+	};
+	//classes and methods of one architecture slice
+	struct SliceObjc
+	{
+		uint32 cputype;
+		uint32 cpusubtype;
+		bool parsed;
+		std::vector<std::string> classes;
+		std::vector<SliceMethod> methods;
+	};
+	//every slice of a universal binary merged into one model keyed by class
+	//and selector,so what differs between architectures shows up in one pass
+	class FatModel
+	{
+	public:
+		enum{
+			//slice sets are bit masks
+			kMaxSlices = 32
+		};
+		struct Method
+		{
+			Method():slices(0){}
+			uint32 slices;
+			//indexed by slice,0 where the slice lacks the method
+			std::vector<uint64_t> imps;
+		};
+		struct Class
+		{
+			Class():slices(0){}
+			uint32 slices;
+			//"-selector" and "+selector"
+			std::map<std::string,Method> methods;
+		};
+		typedef std::map<std::string,Class> ClassMap;
+		FatModel(void);
+		~FatModel(void);
+		//every slice is parsed by its own task on pool,each task maps the file
+		//itself.false if the file is not mach-o
+		bool Build(const std::string& path,ThreadPool* pool);
+		const std::vector<SliceObjc>& slices() const{
+			return slices_;
+		}
+		const ClassMap& classes() const{
+			return classes_;
+		}
+		//mask of the slices that parsed
+		uint32 parsed_slices() const{
+			return parsed_slices_;
+		}
+		//classes or methods missing from some parsed slice
+		uint32 difference_count() const;
+	private:
+		void Merge();
+		std::vector<SliceObjc> slices_;
+		ClassMap classes_;
+		uint32 parsed_slices_;
+		DISALLOW_EVIL_CONSTRUCTORS(FatModel);
+	};
+	//armv7,arm64,x86_64...
+	std::string CpuName(uint32 cputype,uint32 cpusubtype);
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
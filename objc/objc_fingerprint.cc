@@ -0,0 +1,169 @@
+#include "objc/objc_fingerprint.h"
+#include <bytes.hpp>
+#include <netnode.hpp>
+#include <kernwin.hpp>
+#include "objc/objc_hash.h"
+
+namespace objc{
+	namespace{
+		const char kFingerprintNode[] = "$ objc restore fingerprint";
+		const size_t kReadChunk = 1<<20;
+		//supval tag of the blob holding the block hashes
+		const char kBlockTag = 'B';
+		//and of the one holding the (target,head) pairs of the dependency index
+		const char kDependencyTag = 'D';
+		struct FingerprintHeader{
+			uint32 version;
+			uint32 options;
+		};
+		template<typename T>
+		void Append(std::vector<uint8>* blob,const T* data,size_t count){
+			const uint8* bytes = reinterpret_cast<const uint8*>(data);
+			blob->insert(blob->end(),bytes,bytes+count*sizeof(T));
+		}
+		template<typename T>
+		bool Take(const std::vector<uint8>& blob,size_t* offset,T* data,size_t count){
+			if((blob.size()-*offset)/sizeof(T)<count){
+				return false;
+			}
+			memcpy(data,&blob[*offset],count*sizeof(T));
+			*offset += count*sizeof(T);
+			return true;
+		}
+	}
+	AnalysisFingerprint::AnalysisFingerprint(void){
+	}
+	AnalysisFingerprint::~AnalysisFingerprint(void){
+	}
+	void AnalysisFingerprint::HashSection(const segment_t* seg,BlockHashes* hashes){
+		hashes->clear();
+		if(buffer_.size()<kReadChunk){
+			buffer_.resize(kReadChunk);
+		}
+		for(ea_t ea = seg->startEA;ea<seg->endEA;){
+			size_t size = (seg->endEA-ea>kReadChunk)?kReadChunk:static_cast<size_t>(seg->endEA-ea);
+			//uninitialized bytes (zerofill sections) hash as zeros
+			if(!get_many_bytes(ea,&buffer_[0],size)){
+				memset(&buffer_[0],0,size);
+			}
+			//kReadChunk is a multiple of kBlockSize,blocks do not straddle reads
+			for(size_t offset=0;offset<size;offset+=kBlockSize){
+				StreamHash hash;
+				hash.Update(&buffer_[offset],(size-offset>kBlockSize)?size_t(kBlockSize):size-offset);
+				hashes->push_back(hash.Final());
+			}
+			ea += size;
+		}
+	}
+	void AnalysisFingerprint::Compute(const SectionDirectory& directory,const std::vector<std::string>& sections){
+		current_.clear();
+		for(std::vector<std::string>::const_iterator it = sections.begin();it!=sections.end();++it){
+			segment_t* seg = directory.Find(*it);
+			if(seg!=NULL){
+				HashSection(seg,&current_[*it]);
+			}
+		}
+	}
+	bool AnalysisFingerprint::Load(uint32 options,DependencyIndex* dependencies){
+		stored_.clear();
+		netnode node(kFingerprintNode);
+		if(node==BADNODE){
+			return false;
+		}
+		FingerprintHeader header = {0};
+		if(node.supval(0,&header,sizeof(header))!=sizeof(header)||header.version!=kVersion||header.options!=options){
+			return false;
+		}
+		//name size,name,block count and the hashes,section after section
+		std::vector<uint8> blob(node.blobsize(0,kBlockTag));
+		size_t size = blob.size();
+		if(blob.empty()||node.getblob(&blob[0],&size,0,kBlockTag)==NULL||size!=blob.size()){
+			return false;
+		}
+		std::string name;
+		for(size_t offset=0;offset<blob.size();){
+			uint32 name_size = 0;
+			uint32 count = 0;
+			if(!Take(blob,&offset,&name_size,1)||blob.size()-offset<name_size){
+				stored_.clear();
+				return false;
+			}
+			name.assign(reinterpret_cast<const char*>(&blob[offset]),name_size);
+			offset += name_size;
+			if(!Take(blob,&offset,&count,1)||(blob.size()-offset)/sizeof(uint64_t)<count){
+				stored_.clear();
+				return false;
+			}
+			BlockHashes& hashes = stored_[name];
+			hashes.resize(count);
+			if(count!=0){
+				Take(blob,&offset,&hashes[0],count);
+			}
+		}
+		//an empty index is stored as no blob
+		std::vector<uint64_t> pairs(node.blobsize(0,kDependencyTag)/sizeof(uint64_t));
+		size = pairs.size()*sizeof(uint64_t);
+		if((pairs.size()&1)!=0||(!pairs.empty()&&(node.getblob(&pairs[0],&size,0,kDependencyTag)==NULL||size!=pairs.size()*sizeof(uint64_t)))){
+			stored_.clear();
+			return false;
+		}
+		dependencies->Clear();
+		for(size_t index=0;index<pairs.size();index+=2){
+			dependencies->Add(static_cast<ea_t>(pairs[index]),static_cast<ea_t>(pairs[index+1]));
+		}
+		return true;
+	}
+	void AnalysisFingerprint::Store(uint32 options,const DependencyIndex& dependencies) const{
+		netnode node;
+		node.create(kFingerprintNode);
+		FingerprintHeader header = {kVersion,options};
+		node.supset(0,&header,sizeof(header));
+		//version 1 kept one hash per section in the hash values
+		node.hashdel_all();
+		std::vector<uint8> blob;
+		for(std::map<std::string,BlockHashes>::const_iterator it = current_.begin();it!=current_.end();++it){
+			uint32 name_size = static_cast<uint32>(it->first.size());
+			uint32 count = static_cast<uint32>(it->second.size());
+			Append(&blob,&name_size,1);
+			Append(&blob,it->first.data(),name_size);
+			Append(&blob,&count,1);
+			if(count!=0){
+				Append(&blob,&it->second[0],count);
+			}
+		}
+		node.delblob(0,kBlockTag);
+		if(!blob.empty()){
+			node.setblob(&blob[0],blob.size(),0,kBlockTag);
+		}
+		std::vector<uint64_t> pairs;
+		pairs.reserve(dependencies.size()*2);
+		for(DependencyIndex::const_iterator it = dependencies.begin();it!=dependencies.end();++it){
+			pairs.push_back(it->first);
+			pairs.push_back(it->second);
+		}
+		node.delblob(0,kDependencyTag);
+		if(!pairs.empty()){
+			node.setblob(&pairs[0],pairs.size()*sizeof(uint64_t),0,kDependencyTag);
+		}
+	}
+	void AnalysisFingerprint::ChangedSections(const SectionDirectory& directory,DirtyRanges* changed) const{
+		for(std::map<std::string,BlockHashes>::const_iterator it = current_.begin();it!=current_.end();++it){
+			segment_t* seg = directory.Find(it->first);
+			if(seg==NULL){
+				continue;
+			}
+			std::map<std::string,BlockHashes>::const_iterator stored = stored_.find(it->first);
+			if(stored==stored_.end()||stored->second.size()!=it->second.size()){
+				changed->Add(seg->startEA,seg->endEA);
+				continue;
+			}
+			for(size_t index=0;index<it->second.size();index++){
+				if(stored->second[index]!=it->second[index]){
+					ea_t start = seg->startEA+static_cast<ea_t>(index*kBlockSize);
+					ea_t end = (seg->endEA-start>kBlockSize)?start+kBlockSize:seg->endEA;
+					changed->Add(start,end);
+				}
+			}
+		}
+	}
+}
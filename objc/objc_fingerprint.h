@@ -0,0 +1,50 @@
+#ifndef OBJC_OBJC_FINGERPRINT_H_
+#define OBJC_OBJC_FINGERPRINT_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <ida.hpp>
+#include "objc/objc_section.h"
+#include "objc/objc_dirty_ranges.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//content hashes of every restored section in fixed size blocks,kept in
+	//the database so a reopened idb only reruns the heads of the blocks that
+	//changed since.the passes still have to be idempotent,a changed block
+	//reruns every head overlapping it.the dependency index is kept next to
+	//the hashes,a restricted run only sees the heads it reruns
+	class AnalysisFingerprint
+	{
+	public:
+		enum{
+			//bump when a pass starts producing different names
+			kVersion = 3,
+			//bytes per hash,a page
+			kBlockSize = 0x1000,
+			//options,a different set invalidates every stored hash
+			kOptionInputImage = 0x1
+		};
+		AnalysisFingerprint(void);
+		~AnalysisFingerprint(void);
+		//hashes the current bytes of the named sections
+		void Compute(const SectionDirectory& directory,const std::vector<std::string>& sections);
+		//false if nothing is stored or it was stored by another version or
+		//options,dependencies is only replaced when true is returned
+		bool Load(uint32 options,DependencyIndex* dependencies);
+		void Store(uint32 options,const DependencyIndex& dependencies) const;
+		//blocks of the computed sections whose hash differs from the loaded
+		//one,a whole section when its size changed or it was not stored
+		void ChangedSections(const SectionDirectory& directory,DirtyRanges* changed) const;
+	private:
+		typedef std::vector<uint64_t> BlockHashes;
+		void HashSection(const segment_t* seg,BlockHashes* hashes);
+		std::map<std::string,BlockHashes> current_;
+		std::map<std::string,BlockHashes> stored_;
+		std::vector<uint8> buffer_;
+		DISALLOW_EVIL_CONSTRUCTORS(AnalysisFingerprint);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,102 @@
+#include "objc/objc_hash.h"
+#include <string.h>
+
+namespace objc{
+	namespace{
+		const uint64_t kPrime1 = 11400714785074694791ULL;
+		const uint64_t kPrime2 = 14029467366897019727ULL;
+		const uint64_t kPrime3 = 1609587929392839161ULL;
+		const uint64_t kPrime4 = 9650029242287828579ULL;
+		const uint64_t kPrime5 = 2870177450012600261ULL;
+		inline uint64_t Rotl(uint64_t value,int bits){
+			return (value<<bits)|(value>>(64-bits));
+		}
+		//little endian host,see objc_layout.h
+		inline uint64_t Read64(const uint8* p){
+			uint64_t value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		inline uint32 Read32(const uint8* p){
+			uint32 value;
+			memcpy(&value,p,sizeof(value));
+			return value;
+		}
+		inline uint64_t Round(uint64_t acc,uint64_t input){
+			acc += input*kPrime2;
+			return Rotl(acc,31)*kPrime1;
+		}
+		inline uint64_t MergeRound(uint64_t acc,uint64_t lane){
+			acc ^= Round(0,lane);
+			return acc*kPrime1+kPrime4;
+		}
+	}
+	StreamHash::StreamHash(uint64_t seed):seed_(seed),tail_size_(0),total_(0){
+		lanes_[0] = seed+kPrime1+kPrime2;
+		lanes_[1] = seed+kPrime2;
+		lanes_[2] = seed;
+		lanes_[3] = seed-kPrime1;
+	}
+	void StreamHash::Stripe(const uint8* p){
+		lanes_[0] = Round(lanes_[0],Read64(p));
+		lanes_[1] = Round(lanes_[1],Read64(p+8));
+		lanes_[2] = Round(lanes_[2],Read64(p+16));
+		lanes_[3] = Round(lanes_[3],Read64(p+24));
+	}
+	void StreamHash::Update(const void* data,size_t size){
+		const uint8* p = static_cast<const uint8*>(data);
+		const uint8* end = p+size;
+		total_ += size;
+		if(tail_size_!=0){
+			size_t fill = sizeof(tail_)-tail_size_;
+			if(size<fill){
+				memcpy(tail_+tail_size_,p,size);
+				tail_size_ += size;
+				return;
+			}
+			memcpy(tail_+tail_size_,p,fill);
+			Stripe(tail_);
+			p += fill;
+			tail_size_ = 0;
+		}
+		for(;end-p>=32;p += 32){
+			Stripe(p);
+		}
+		tail_size_ = end-p;
+		memcpy(tail_,p,tail_size_);
+	}
+	uint64_t StreamHash::Final() const{
+		uint64_t hash;
+		if(total_>=32){
+			hash = Rotl(lanes_[0],1)+Rotl(lanes_[1],7)+Rotl(lanes_[2],12)+Rotl(lanes_[3],18);
+			for(int index=0;index<4;index++){
+				hash = MergeRound(hash,lanes_[index]);
+			}
+		}
+		else{
+			hash = seed_+kPrime5;
+		}
+		hash += total_;
+		const uint8* p = tail_;
+		const uint8* end = tail_+tail_size_;
+		for(;end-p>=8;p += 8){
+			hash ^= Round(0,Read64(p));
+			hash = Rotl(hash,27)*kPrime1+kPrime4;
+		}
+		if(end-p>=4){
+			hash ^= uint64_t(Read32(p))*kPrime1;
+			hash = Rotl(hash,23)*kPrime2+kPrime3;
+			p += 4;
+		}
+		for(;p<end;p++){
+			hash ^= (*p)*kPrime5;
+			hash = Rotl(hash,11)*kPrime1;
+		}
+		hash ^= hash>>33;
+		hash *= kPrime2;
+		hash ^= hash>>29;
+		hash *= kPrime3;
+		hash ^= hash>>32;
+		return hash;
+	}
+}
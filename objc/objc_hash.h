@@ -0,0 +1,28 @@
+#ifndef OBJC_OBJC_HASH_H_
+#define OBJC_OBJC_HASH_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//streaming xxhash64.input is consumed in 32 byte stripes by four
+	//independent lanes,so the loop runs at memory speed and the result does
+	//not depend on how the input is split across Update calls
+	class StreamHash
+	{
+	public:
+		explicit StreamHash(uint64_t seed = 0);
+		void Update(const void* data,size_t size);
+		uint64_t Final() const;
+	private:
+		void Stripe(const uint8* p);
+		uint64_t seed_;
+		uint64_t lanes_[4];
+		uint8 tail_[32];
+		size_t tail_size_;
+		uint64_t total_;
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,162 @@
+#ifndef OBJC_OBJC_LAYOUT_H_
+#define OBJC_OBJC_LAYOUT_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "thirdparty/glog/basictypes.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//field offsets of the objc2 runtime structures for one target,everything
+	//is a compile time constant so the decoders carry no width/endian branches.
+	//loads assume a little endian host,which is every platform ida runs on
+	template<typename PtrT,bool kBigEndianTarget,bool kRelativeMethodLists>
+	struct ObjcLayout
+	{
+		typedef PtrT ptr_t;
+		enum{
+			kPtrSize = sizeof(PtrT),
+			kBigEndian = kBigEndianTarget,
+			kRelativeMethods = kRelativeMethodLists,
+			//class_t
+			kClassIsa = 0,
+			kClassSuperclass = kPtrSize,
+			kClassCache = kPtrSize*2,
+			kClassVtable = kPtrSize*3,
+			kClassData = kPtrSize*4,
+			kClassSize = kPtrSize*5,
+			//class_ro_t,64-bit has a reserved word after instanceSize
+			kRoFlags = 0,
+			kRoInstanceStart = 4,
+			kRoInstanceSize = 8,
+			kRoHeaderSize = (kPtrSize==8)?16:12,
+			kRoIvarLayout = kRoHeaderSize,
+			kRoName = kRoHeaderSize+kPtrSize,
+			kRoBaseMethods = kRoHeaderSize+kPtrSize*2,
+			kRoBaseProtocols = kRoHeaderSize+kPtrSize*3,
+			kRoIvars = kRoHeaderSize+kPtrSize*4,
+			kRoWeakIvarLayout = kRoHeaderSize+kPtrSize*5,
+			kRoBaseProperties = kRoHeaderSize+kPtrSize*6,
+			kRoSize = kRoHeaderSize+kPtrSize*7,
+			//entsize/count header of method_list_t and ivar_list_t
+			kListHeaderSize = 8,
+			//method_t
+			kMethodName = 0,
+			kMethodTypes = kPtrSize,
+			kMethodImp = kPtrSize*2,
+			kMethodSize = kPtrSize*3,
+			//relative method_t,three int32 offsets from the field itself
+			kRelativeMethodSize = 12,
+			//ivar_t
+			kIvarOffset = 0,
+			kIvarName = kPtrSize,
+			kIvarType = kPtrSize*2,
+			kIvarAlignment = kPtrSize*3,
+			kIvarSize = kPtrSize*3+4,
+			kIvarEntrySize = kPtrSize*3+8,
+			//protocol_t
+			kProtocolIsa = 0,
+			kProtocolName = kPtrSize,
+			kProtocolProtocols = kPtrSize*2,
+			kProtocolInstanceMethods = kPtrSize*3,
+			kProtocolClassMethods = kPtrSize*4,
+			kProtocolOptInstanceMethods = kPtrSize*5,
+			kProtocolOptClassMethods = kPtrSize*6,
+			kProtocolSize = kPtrSize*7,
+			//category_t
+			kCategoryName = 0,
+			kCategoryClass = kPtrSize,
+			kCategoryInstanceMethods = kPtrSize*2,
+			kCategoryClassMethods = kPtrSize*3,
+			kCategoryProtocols = kPtrSize*4,
+			kCategoryInstanceProperties = kPtrSize*5,
+			kCategorySize = kPtrSize*6
+		};
+		//class_t::data keeps runtime flags in the low bits
+		static uint64_t ClassDataMask(){
+			return (kPtrSize==8)?~uint64_t(7):~uint64_t(3);
+		}
+		static uint32 Swap32(uint32 value){
+			return (value>>24)|((value>>8)&0xFF00)|((value<<8)&0xFF0000)|(value<<24);
+		}
+		static uint32 Load32(const uint8* p){
+			uint32 value;
+			memcpy(&value,p,sizeof(value));
+			if(kBigEndian){
+				value = Swap32(value);
+			}
+			return value;
+		}
+		static uint32 Load16(const uint8* p){
+			uint16 value;
+			memcpy(&value,p,sizeof(value));
+			if(kBigEndian){
+				value = static_cast<uint16>((value>>8)|(value<<8));
+			}
+			return value;
+		}
+		static int32_t LoadRelative(const uint8* p){
+			return static_cast<int32_t>(Load32(p));
+		}
+		static uint64_t LoadPtr(const uint8* p){
+			PtrT value;
+			memcpy(&value,p,sizeof(value));
+			if(kBigEndian){
+				//word swaps,the byte loop this replaced did not become a bswap
+				uint64_t wide = value;
+				if(kPtrSize==8){
+					return (uint64_t(Swap32(static_cast<uint32>(wide)))<<32)|Swap32(static_cast<uint32>(wide>>32));
+				}
+				return Swap32(static_cast<uint32>(wide));
+			}
+			return value;
+		}
+	};
+	typedef ObjcLayout<uint32,false,false> Layout32;
+	typedef ObjcLayout<uint32,true,false> Layout32BE;
+	typedef ObjcLayout<uint64_t,false,true> Layout64;
+	//objc1 only ever shipped for 32-bit targets
+	struct Objc1Layout
+	{
+		enum{
+			//objc_class
+			kClassIsa = 0x0,
+			kClassSuperclass = 0x4,
+			kClassName = 0x8,
+			kClassVersion = 0xC,
+			kClassInfo = 0x10,
+			kClassInstanceSize = 0x14,
+			kClassIvars = 0x18,
+			kClassMethods = 0x1C,
+			kClassCache = 0x20,
+			kClassProtocols = 0x24,
+			kClassSize = 0x28,
+			//objc_category
+			kCategoryName = 0x0,
+			kCategoryClassName = 0x4,
+			kCategoryInstanceMethods = 0x8,
+			kCategoryClassMethods = 0xC,
+			kCategoryProtocols = 0x10,
+			//objc_method_list:obsolete,method_count,objc_method[]
+			kMethodListCount = 0x4,
+			kMethodListEntries = 0x8,
+			kMethodName = 0x0,
+			kMethodTypes = 0x4,
+			kMethodImp = 0x8,
+			kMethodSize = 0xC,
+			//objc_module
+			kModuleVersion = 0x0,
+			kModuleSize = 0x4,
+			kModuleName = 0x8,
+			kModuleSymtab = 0xC,
+			//objc_symtab
+			kSymtabSelRefCount = 0x0,
+			kSymtabRefs = 0x4,
+			kSymtabClassCount = 0x8,
+			kSymtabCategoryCount = 0xA,
+			kSymtabDefs = 0xC
+		};
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,108 @@
+#include "objc/objc_local_symbols.h"
+#include <bytes.hpp>
+#include <name.hpp>
+#include <netnode.hpp>
+#include <kernwin.hpp>
+#include <segment.hpp>
+#include <stdio.h>
+
+namespace objc{
+	namespace{
+		//altval 0 is set once the names were restored,supstr 0 keeps the
+		//cache the user picked
+		const char kLocalSymbolsNode[] = "$ objc local symbols";
+	}
+	LocalSymbolRestore::LocalSymbolRestore(void){
+	}
+	LocalSymbolRestore::~LocalSymbolRestore(void){
+	}
+	uint32 LocalSymbolRestore::Restore(const MachoImage* input_image){
+		netnode node(kLocalSymbolsNode);
+		if(node!=BADNODE&&node.altval(0)!=0){
+			return 0;
+		}
+		if(!OpenCache(input_image)){
+			return 0;
+		}
+		uint64 start = 0;
+		get_nsec_stamp(&start);
+		uint32 applied = 0;
+		size_t image = FindDatabaseImage();
+		if(image<cache_.images().size()&&cache_.LocalSymbols(image,&symbols_)){
+			applied = Apply(symbols_);
+			uint64 end = 0;
+			get_nsec_stamp(&end);
+			double seconds = (end>start)?(end-start)/1e9:1e-9;
+			msg("objc: restored %u of %u local symbols of %s in %.1f ms,%.0f per second\n",applied,static_cast<uint32>(symbols_.size()),
+				cache_.images()[image].path,seconds*1e3,symbols_.size()/seconds);
+		}
+		else{
+			msg("objc: the dyld cache has no local symbols for this image\n");
+		}
+		std::vector<DyldLocalSymbol>().swap(symbols_);
+		cache_.Close();
+		node.create(kLocalSymbolsNode);
+		node.altset(0,1);
+		return applied;
+	}
+	bool LocalSymbolRestore::OpenCache(const MachoImage* input_image){
+		char path[QMAXPATH] = {0};
+		if(get_input_file_path(path,QMAXPATH)>0&&cache_.OpenTables(path)){
+			return true;
+		}
+		netnode node(kLocalSymbolsNode);
+		if(node!=BADNODE&&node.supstr(0,path,QMAXPATH)>0&&cache_.OpenTables(path)){
+			return true;
+		}
+		//an image extracted from a cache,only the user knows which one
+		if(batch||input_image==NULL||(input_image->flags()&MachoImage::kMhDylibInCache)==0){
+			return false;
+		}
+		const char* answer = askfile_c(0,"dyld_shared_cache_*","Select the dyld shared cache this image was extracted from");
+		if(answer==NULL){
+			//cancelled,not asked again for this database
+			node.create(kLocalSymbolsNode);
+			node.altset(0,1);
+			return false;
+		}
+		if(!cache_.OpenTables(answer)){
+			msg("objc: %s is not a dyld shared cache\n",answer);
+			return false;
+		}
+		node.create(kLocalSymbolsNode);
+		node.supset(0,answer);
+		return true;
+	}
+	size_t LocalSymbolRestore::FindDatabaseImage() const{
+		//the module keeps its cache addresses,so its mach header starts a segment
+		const std::vector<DyldCacheImage>& images = cache_.images();
+		for(size_t index=0;index<images.size();index++){
+			segment_t* seg = getseg(static_cast<ea_t>(images[index].address));
+			if(seg!=NULL&&seg->startEA==images[index].address){
+				return index;
+			}
+		}
+		return images.size();
+	}
+	uint32 LocalSymbolRestore::Apply(const std::vector<DyldLocalSymbol>& symbols){
+		//ascending addresses keep the name btree appends local
+		uint32 applied = 0;
+		for(std::vector<DyldLocalSymbol>::const_iterator it = symbols.begin();it!=symbols.end();++it){
+			ea_t ea = static_cast<ea_t>(it->address);
+			if(!isEnabled(ea)||has_name(getFlags(ea))){
+				continue;
+			}
+			if(set_name(ea,it->name,SN_NOWARN|SN_NOCHECK|SN_NON_PUBLIC)){
+				applied++;
+				continue;
+			}
+			//local names repeat across translation units
+			char name[MAXNAMELEN] = {0};
+			_snprintf(name,MAXNAMELEN-1,"%s_%llX",it->name,static_cast<unsigned long long>(it->address));
+			if(set_name(ea,name,SN_NOWARN|SN_NOCHECK|SN_NON_PUBLIC)){
+				applied++;
+			}
+		}
+		return applied;
+	}
+}
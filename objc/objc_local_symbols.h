@@ -0,0 +1,36 @@
+#ifndef OBJC_OBJC_LOCAL_SYMBOLS_H_
+#define OBJC_OBJC_LOCAL_SYMBOLS_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <ida.hpp>
+#include "objc/macho_image.h"
+#include "objc/dyld_cache.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//puts back the local symbols the cache builder moved out of a cached
+	//image into dyld_cache_local_symbols_info.the nlists are streamed from
+	//the mapped cache,sorted by address and named in one ascending pass,
+	//before the objc passes look for _OBJC_CLASS_$_ and friends
+	class LocalSymbolRestore
+	{
+	public:
+		LocalSymbolRestore(void);
+		~LocalSymbolRestore(void);
+		//once per database.the cache is the input file when ida loaded a
+		//module of it,otherwise the one the user picks for an image whose
+		//header says it came from a cache.returns the number of names set
+		uint32 Restore(const MachoImage* input_image);
+	private:
+		bool OpenCache(const MachoImage* input_image);
+		//index of the cache image mapped in the database,images().size() if none
+		size_t FindDatabaseImage() const;
+		uint32 Apply(const std::vector<DyldLocalSymbol>& symbols);
+		DyldCache cache_;
+		std::vector<DyldLocalSymbol> symbols_;
+		DISALLOW_EVIL_CONSTRUCTORS(LocalSymbolRestore);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
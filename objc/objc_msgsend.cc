@@ -0,0 +1,352 @@
+#include "objc/objc_msgsend.h"
+#include <ida.hpp>
+#include <idp.hpp>
+#include <ua.hpp>
+#include <bytes.hpp>
+#include <xref.hpp>
+#include <funcs.hpp>
+#include <name.hpp>
+#include <segment.hpp>
+#include <kernwin.hpp>
+#include <string.h>
+#include <algorithm>
+#include "objc/objc_section.h"
+#include "objc/objc_call_sites.h"
+
+namespace objc{
+	namespace{
+		struct SendFunction{
+			const char* name;
+			uint32 flags;
+		};
+		const SendFunction kSendFunctions[] = {
+			{"objc_msgSend",0},
+			{"objc_msgSendSuper",MessageSendResolver::kSendSuper},
+			{"objc_msgSendSuper2",MessageSendResolver::kSendSuper},
+			{"objc_msgSend_fpret",0},
+			{"objc_msgSend_fp2ret",0},
+			{"objc_msgSend_stret",MessageSendResolver::kSendStret},
+			{"objc_msgSendSuper_stret",MessageSendResolver::kSendStret|MessageSendResolver::kSendSuper},
+			{"objc_msgSendSuper2_stret",MessageSendResolver::kSendStret|MessageSendResolver::kSendSuper}
+		};
+		//how the mach-o loader names the import,its pointer and the stubs
+		const char* const kImportNames[] = {
+			"_%s",
+			"%s",
+			"_%s_ptr",
+			"j__%s",
+			"__imp__%s"
+		};
+		//R_dx,R_sp and R_si of intel.hpp,which needs the module headers
+		const int kX86Rdx = 2;
+		const int kX86Rsp = 4;
+		const int kX86Rsi = 6;
+		//x86_base of intel.hpp for 32-bit code:[esp+n] always has a sib byte
+		int X86Base(const op_t& op){
+			return (op.specflag1!=0)?(op.specflag2&7):op.phrase;
+		}
+		//stubs only forward,their callers are the call sites
+		bool IsStub(ea_t ea){
+			func_t* func = get_func(ea);
+			if(func!=NULL&&(func->flags&FUNC_THUNK)!=0){
+				return true;
+			}
+			char seg_name[1024] = {0};
+			segment_t* seg = getseg(ea);
+			return seg!=NULL&&get_true_segm_name(seg,seg_name,1024)>0&&strstr(seg_name,"stub")!=NULL;
+		}
+		//XREF_FAR leaves out the ordinary flow,what remains are the calls,the
+		//jumps of tail calls and stubs and the reads of import pointers
+		class XrefReferences:public CallReferenceSource
+		{
+		public:
+			virtual void ReferencesTo(uint64_t target,std::vector<Reference>* references) const{
+				references->clear();
+				xrefblk_t xb;
+				for(bool ok = xb.first_to(static_cast<ea_t>(target),XREF_FAR);ok;ok = xb.next_to()){
+					Reference reference = {xb.from,kOther,0};
+					flags_t item_flags = get_flags_novalue(xb.from);
+					if(!isCode(item_flags)){
+						if(isData(item_flags)){
+							reference.kind = kPointer;
+							reference.next = get_item_head(xb.from);
+						}
+					}
+					else if(IsStub(xb.from)){
+						func_t* func = get_func(xb.from);
+						reference.kind = kStub;
+						reference.next = (func!=NULL)?func->startEA:get_item_head(xb.from);
+					}
+					//data reads from real code count only when they are indirect calls
+					else if(xb.iscode||is_call_insn(xb.from)){
+						reference.kind = kCall;
+					}
+					references->push_back(reference);
+				}
+			}
+		};
+	}
+	MessageSendResolver::MessageSendResolver(const HeadDecoder& decoder):decoder_(decoder),resolved_(0),super_resolved_(0),xrefs_(0){
+		argument_.reg = -1;
+		argument_.stack_offset = 0;
+		stret_argument_ = argument_;
+	}
+	MessageSendResolver::~MessageSendResolver(void){
+	}
+	bool MessageSendResolver::Resolve(){
+		if(!SelectArguments()){
+			msg("objc: message sends are only resolved for x86 and arm\n");
+			return true;
+		}
+		uint64 start = 0;
+		get_nsec_stamp(&start);
+		decoder_.CollectImplementations(&implementations_);
+		decoder_.CollectClassGraph(&graph_);
+		graph_.Build();
+		CollectSelectorSections();
+		CollectCallSites();
+		bool cancelled = false;
+		show_wait_box("objc: tracing %u message sends",static_cast<uint32>(calls_.size()));
+		//reads only,nothing is committed before every site is traced
+		for(size_t index=0;index<calls_.size()&&!cancelled;index++){
+			const Argument& argument = ((calls_[index].second&kSendStret)!=0)?stret_argument_:argument_;
+			CallSite site = {calls_[index].first,TraceSelector(calls_[index].first,argument),calls_[index].second};
+			if(site.selector!=0){
+				sites_.push_back(site);
+			}
+			cancelled = ((index+1)%kCommitBatch==0&&wasBreak());
+		}
+		for(size_t index=0;index<sites_.size()&&!cancelled;index++){
+			Commit(sites_[index]);
+			if((index+1)%kCommitBatch==0){
+				replace_wait_box("objc: %u of %u message sends committed",static_cast<uint32>(index+1),static_cast<uint32>(sites_.size()));
+				cancelled = wasBreak();
+			}
+		}
+		hide_wait_box();
+		uint64 now = 0;
+		get_nsec_stamp(&now);
+		msg("objc: %u message sends,%u with a known selector,%u resolved,%u of them sends to super,%u call xrefs added in %u ms%s\n",
+			static_cast<uint32>(calls_.size()),static_cast<uint32>(sites_.size()),resolved_,super_resolved_,xrefs_,
+			static_cast<uint32>((now-start)/1000000),cancelled?",cancelled":"");
+		msg("objc: %u classes up to %u deep,%u method lookups,%u from cache\n",graph_.node_count(),graph_.max_depth(),
+			graph_.cache_hits()+graph_.cache_misses(),graph_.cache_hits());
+		return !cancelled;
+	}
+	bool MessageSendResolver::SelectArguments(){
+		if(ph.id==PLFM_386){
+			if(inf.is_64bit()){
+				argument_.reg = kX86Rsi;
+				stret_argument_.reg = kX86Rdx;
+			}
+			else{
+				//above the return address of the callee,the caller stores to [esp+n]
+				argument_.stack_offset = 4;
+				stret_argument_.stack_offset = 8;
+			}
+			return true;
+		}
+		if(ph.id==PLFM_ARM){
+			argument_.reg = str2reg(inf.is_64bit()?"X1":"R1");
+			stret_argument_.reg = str2reg(inf.is_64bit()?"X1":"R2");
+			return argument_.reg!=-1&&stret_argument_.reg!=-1;
+		}
+		return false;
+	}
+	void MessageSendResolver::CollectSelectorSections(){
+		SectionDirectory directory;
+		directory.Build();
+		uint32 ptr_size = inf.is_64bit()?8:4;
+		//objc2 and objc1 selector references hold the selector,a message_ref_t
+		//of __objc_msgrefs keeps the imp in front of it
+		const SelectorSection layouts[] = {
+			{0,0,0,ptr_size},
+			{0,0,0,ptr_size},
+			{0,0,ptr_size,ptr_size*2}
+		};
+		const char* const names[] = {"__objc_selrefs","__message_refs","__objc_msgrefs"};
+		for(size_t index=0;index<qnumber(names);index++){
+			segment_t* seg = directory.Find(names[index]);
+			if(seg!=NULL){
+				SelectorSection section = layouts[index];
+				section.start = seg->startEA;
+				section.end = seg->endEA;
+				sections_.push_back(section);
+			}
+		}
+	}
+	void MessageSendResolver::CollectCallSites(){
+		XrefReferences references;
+		CallSiteCollector collector(references);
+		char name[MAXSTR] = {0};
+		for(size_t index=0;index<qnumber(kSendFunctions);index++){
+			for(size_t format=0;format<qnumber(kImportNames);format++){
+				qsnprintf(name,sizeof(name),kImportNames[format],kSendFunctions[index].name);
+				ea_t ea = get_name_ea(BADADDR,name);
+				if(ea!=BADADDR){
+					collector.Add(ea,kSendFunctions[index].flags);
+				}
+			}
+		}
+		std::vector<std::pair<uint64_t,uint32> > calls;
+		collector.Finish(&calls);
+		calls_.reserve(calls.size());
+		for(std::vector<std::pair<uint64_t,uint32> >::const_iterator it = calls.begin();it!=calls.end();++it){
+			calls_.push_back(std::make_pair(static_cast<ea_t>(it->first),it->second));
+		}
+	}
+	uint64_t MessageSendResolver::TraceSelector(ea_t call,const Argument& argument){
+		int reg = argument.reg;
+		ea_t ea = call;
+		for(uint32 step=0;step<kMaxBacktrack;step++){
+			if(!isFlow(get_flags_novalue(ea))){
+				return 0;
+			}
+			ea = decode_prev_insn(ea);
+			if(ea==BADADDR){
+				return 0;
+			}
+			uint32 feature = cmd.get_canon_feature();
+			//the argument registers do not survive a call
+			if((feature&CF_CALL)!=0){
+				return 0;
+			}
+			if((feature&CF_CHG1)==0){
+				continue;
+			}
+			const op_t& dest = cmd.Op1;
+			bool writes = (reg<0)?((dest.type==o_displ||dest.type==o_phrase)&&X86Base(dest)==kX86Rsp&&dest.addr==argument.stack_offset):
+				(dest.type==o_reg&&dest.reg==reg);
+			if(!writes){
+				continue;
+			}
+			uint64_t selector = SelectorFromReferences(ea);
+			if(selector!=0){
+				return selector;
+			}
+			//follow the register the value came from,or the register holding
+			//the address of the slot it was loaded from
+			const op_t& source = cmd.Op2;
+			if(source.type==o_reg||source.type==o_phrase||source.type==o_displ){
+				reg = source.reg;
+				continue;
+			}
+			if(source.type==o_mem){
+				return SelectorFromSlot(source.addr);
+			}
+			return 0;
+		}
+		return 0;
+	}
+	uint64_t MessageSendResolver::SelectorFromReferences(ea_t ea){
+		xrefblk_t xb;
+		for(bool ok = xb.first_from(ea,XREF_DATA);ok;ok = xb.next_from()){
+			uint64_t selector = SelectorFromSlot(xb.to);
+			if(selector!=0){
+				return selector;
+			}
+			//arm literal pools hold the address of the slot
+			xrefblk_t pool;
+			for(bool found = pool.first_from(xb.to,XREF_DATA);found;found = pool.next_from()){
+				selector = SelectorFromSlot(pool.to);
+				if(selector!=0){
+					return selector;
+				}
+			}
+		}
+		return 0;
+	}
+	uint64_t MessageSendResolver::SelectorFromSlot(ea_t slot){
+		for(std::vector<SelectorSection>::const_iterator it = sections_.begin();it!=sections_.end();++it){
+			if(it->start<=slot&&slot<it->end){
+				uint64_t entry = it->start+((slot-it->start)/it->entry_size)*it->entry_size;
+				uint64_t selector = 0;
+				return decoder_.ReadPointer(entry+it->selector_offset,&selector)?selector:0;
+			}
+		}
+		return 0;
+	}
+	const ClassGraph::Method* MessageSendResolver::SuperImplementation(const CallSite& site,const char* selector_name) const{
+		func_t* func = get_func(site.ea);
+		if(func==NULL||selector_name==NULL){
+			return NULL;
+		}
+		//a thumb imp has the low bit set
+		const ClassGraph::Method* caller = graph_.FindImplementation(func->startEA);
+		if(caller==NULL){
+			caller = graph_.FindImplementation(func->startEA|1);
+		}
+		uint32 selector = graph_.FindSelector(selector_name);
+		if(caller==NULL||selector==ClassGraph::kNoName){
+			return NULL;
+		}
+		//objc_super holds the superclass for objc_msgSendSuper and the
+		//class itself for objc_msgSendSuper2,both start one class up
+		uint32 superclass = graph_.node(caller->node).superclass;
+		return (superclass!=ClassGraph::kNoNode)?graph_.Lookup(superclass,selector):NULL;
+	}
+	void MessageSendResolver::Commit(const CallSite& site){
+		const char* selector_name = decoder_.ReadString(site.selector);
+		if((site.flags&kSendSuper)!=0){
+			const ClassGraph::Method* method = SuperImplementation(site,selector_name);
+			if(method!=NULL&&CommitSuper(site,*method)){
+				return;
+			}
+		}
+		MethodImplementation key = {site.selector,0};
+		MethodImplementations::const_iterator first = std::lower_bound(implementations_.begin(),implementations_.end(),key);
+		MethodImplementations::const_iterator last = first;
+		while(last!=implementations_.end()&&last->selector==site.selector){
+			++last;
+		}
+		comment_.assign((selector_name!=NULL)?selector_name:"?");
+		uint32 candidates = static_cast<uint32>(last-first);
+		if(candidates!=0){
+			resolved_++;
+		}
+		char name[MAXSTR] = {0};
+		uint32 named = 0;
+		for(MethodImplementations::const_iterator it = first;it!=last&&candidates<=kMaxCandidates;++it){
+			//a thumb imp has the low bit set,the function starts below it
+			func_t* func = get_func(static_cast<ea_t>(it->imp));
+			if(func==NULL){
+				continue;
+			}
+			if(add_cref(site.ea,func->startEA,cref_t(fl_CN|XREF_USER))){
+				xrefs_++;
+			}
+			if(named<kCommentCandidates&&get_true_name(BADADDR,func->startEA,name,sizeof(name))!=NULL){
+				comment_.append(named==0?" -> ":",").append(name);
+				named++;
+			}
+		}
+		if(candidates>named){
+			char more[64] = {0};
+			qsnprintf(more,sizeof(more),"%s%u candidates",(named==0)?" -> ":" of ",candidates);
+			comment_.append(more);
+		}
+		Annotate(site.ea);
+	}
+	bool MessageSendResolver::CommitSuper(const CallSite& site,const ClassGraph::Method& method){
+		func_t* func = get_func(static_cast<ea_t>(method.imp));
+		if(func==NULL){
+			return false;
+		}
+		resolved_++;
+		super_resolved_++;
+		if(add_cref(site.ea,func->startEA,cref_t(fl_CN|XREF_USER))){
+			xrefs_++;
+		}
+		comment_.assign("super -> ");
+		graph_.AppendMethodName(method,&comment_);
+		Annotate(site.ea);
+		return true;
+	}
+	void MessageSendResolver::Annotate(ea_t ea){
+		char comment[MAXSTR] = {0};
+		//a comment the user wrote is kept
+		if(get_cmt(ea,false,comment,sizeof(comment))<=0){
+			set_cmt(ea,comment_.c_str(),false);
+		}
+	}
+}
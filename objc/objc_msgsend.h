@@ -0,0 +1,96 @@
+#ifndef OBJC_OBJC_MSGSEND_H_
+#define OBJC_OBJC_MSGSEND_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <ida.hpp>
+#include "objc/objc_pipeline.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//the call sites of objc_msgSend and its variants,found through the xrefs
+	//to the functions and their stubs rather than by scanning code.the
+	//selector argument is traced back to its __objc_selrefs,__message_refs
+	//or __objc_msgrefs slot and every implementation of that selector in the
+	//image gets a call xref and the call a comment.a send to super from a
+	//method goes to the one implementation the class graph resolves
+	class MessageSendResolver
+	{
+	public:
+		enum{
+			//call sites committed between two looks at the cancel button
+			kCommitBatch = 4096,
+			//instructions looked at before the selector is given up
+			kMaxBacktrack = 24,
+			//selectors like init have hundreds of implementations,a call to
+			//one of those says nothing about its target
+			kMaxCandidates = 32,
+			//implementations named in a comment
+			kCommentCandidates = 3
+		};
+		enum{
+			//a struct return moves the selector one argument further
+			kSendStret = 0x1,
+			//the lookup starts at the superclass of the calling method's class
+			kSendSuper = 0x2
+		};
+		explicit MessageSendResolver(const HeadDecoder& decoder);
+		~MessageSendResolver(void);
+		//false when cancelled,what was committed so far stays
+		bool Resolve();
+	private:
+		//where the selector argument of a variant is passed
+		struct Argument{
+			int reg;
+			//i386 passes it on the stack at [esp+offset],reg is then -1
+			uint32 stack_offset;
+		};
+		struct CallSite{
+			ea_t ea;
+			//address of the selector string
+			uint64_t selector;
+			uint32 flags;
+		};
+		//a selector reference section and the layout of its entries
+		struct SelectorSection{
+			ea_t start;
+			ea_t end;
+			//message_ref_t keeps the imp in front of the selector
+			uint32 selector_offset;
+			uint32 entry_size;
+		};
+		bool SelectArguments();
+		void CollectSelectorSections();
+		//calls to the variants,their stubs and import pointers
+		void CollectCallSites();
+		//the selector the argument holds at call,0 when it cannot be traced
+		uint64_t TraceSelector(ea_t call,const Argument& argument);
+		//selector behind the data references of the instruction at ea
+		uint64_t SelectorFromReferences(ea_t ea);
+		uint64_t SelectorFromSlot(ea_t slot);
+		//what a send to super from the method containing the site runs,
+		//NULL when the method or its class is unknown
+		const ClassGraph::Method* SuperImplementation(const CallSite& site,const char* selector_name) const;
+		void Commit(const CallSite& site);
+		//false when the implementation is in no function
+		bool CommitSuper(const CallSite& site,const ClassGraph::Method& method);
+		//sets comment_ unless the user commented the site
+		void Annotate(ea_t ea);
+		const HeadDecoder& decoder_;
+		MethodImplementations implementations_;
+		ClassGraph graph_;
+		std::vector<SelectorSection> sections_;
+		//call sites and the kSend flags of the variant they call
+		std::vector<std::pair<ea_t,uint32> > calls_;
+		std::vector<CallSite> sites_;
+		Argument argument_;
+		Argument stret_argument_;
+		std::string comment_;
+		uint32 resolved_;
+		uint32 super_resolved_;
+		uint32 xrefs_;
+		DISALLOW_EVIL_CONSTRUCTORS(MessageSendResolver);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
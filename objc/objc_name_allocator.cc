@@ -0,0 +1,117 @@
+#include "objc/objc_name_allocator.h"
+#include <ida.hpp>
+#include <name.hpp>
+#include <kernwin.hpp>
+#include <cstdio>
+
+namespace objc{
+	namespace{
+		//set_name gives up on a refused name after this many suffixes
+		const int kMaxAssignAttempts = 4;
+		//leave room for the _N suffix
+		const size_t kMaxBaseNameLength = MAXNAMELEN-16;
+	}
+	NameAllocator::NameAllocator(void):seeded_(false),set_name_calls_(0),collisions_(0){
+		memset(ident_chars_,0,sizeof(ident_chars_));
+	}
+	NameAllocator::~NameAllocator(void){
+	}
+	void NameAllocator::Seed(){
+		owners_.clear();
+		names_.clear();
+		next_suffix_.clear();
+		for(int c=0;c<256;c++){
+			ident_chars_[c] = (c!=0&&is_ident_char(static_cast<char>(c)));
+		}
+		size_t count = get_nlist_size();
+		owners_.reserve(count);
+		names_.reserve(count);
+		for(size_t index=0;index<count;index++){
+			const char* name = get_nlist_name(index);
+			if(name!=NULL){
+				Bind(get_nlist_ea(index),name);
+			}
+		}
+		seeded_ = true;
+	}
+	void NameAllocator::Sanitize(std::string* name) const{
+		for(std::string::iterator it = name->begin();it!=name->end();++it){
+			if(!ident_chars_[static_cast<uint8>(*it)]){
+				*it = '_';
+			}
+		}
+		if(!name->empty()&&(*name)[0]>='0'&&(*name)[0]<='9'){
+			name->insert(name->begin(),'_');
+		}
+		if(name->length()>kMaxBaseNameLength){
+			name->resize(kMaxBaseNameLength);
+		}
+	}
+	bool NameAllocator::IsFree(const std::string& name,ea_t ea) const{
+		std::unordered_map<std::string,ea_t>::const_iterator it = owners_.find(name);
+		return (it==owners_.end()||it->second==ea);
+	}
+	void NameAllocator::Bind(ea_t ea,const std::string& name){
+		std::unordered_map<ea_t,std::string>::iterator old = names_.find(ea);
+		if(old!=names_.end()){
+			owners_.erase(old->second);
+			old->second = name;
+		}
+		else{
+			names_[ea] = name;
+		}
+		owners_[name] = ea;
+	}
+	void NameAllocator::NoteRename(ea_t ea,const char* name){
+		if(!seeded_){
+			return;
+		}
+		if(name!=NULL&&*name!='\0'){
+			Bind(ea,name);
+			return;
+		}
+		std::unordered_map<ea_t,std::string>::iterator old = names_.find(ea);
+		if(old!=names_.end()){
+			owners_.erase(old->second);
+			names_.erase(old);
+		}
+	}
+	bool NameAllocator::Assign(ea_t ea,const char* name){
+		if(!seeded_){
+			Seed();
+		}
+		base_.assign(name);
+		Sanitize(&base_);
+		if(base_.empty()||ea==BADADDR){
+			return false;
+		}
+		const std::string& base = base_;
+		std::string& candidate = candidate_;
+		candidate = base;
+		bool suffixed = false;
+		for(int attempt=0;attempt<kMaxAssignAttempts;attempt++){
+			if(suffixed||!IsFree(candidate,ea)){
+				//the counter only moves forward so each base skips every
+				//taken suffix at most once over the whole run
+				uint32& next = next_suffix_[base];
+				do{
+					char buf[32] = {0};
+					_snprintf(buf,32,"_%u",next++);
+					candidate.assign(base).append(buf);
+				}while(!IsFree(candidate,ea));
+				if(!suffixed){
+					collisions_++;
+				}
+				suffixed = true;
+			}
+			set_name_calls_++;
+			if(set_name(ea,candidate.c_str(),SN_NOWARN|SN_CHECK)){
+				Bind(ea,candidate);
+				return true;
+			}
+			//the database knows a name we do not,e.g. a dummy prefix
+			suffixed = true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef OBJC_OBJC_NAME_ALLOCATOR_H_
+#define OBJC_OBJC_NAME_ALLOCATOR_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <unordered_map>
+#include <ida.hpp>
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//hands out database names without probing set_name in a loop.the name
+	//list is read once,afterwards every base name keeps its next free suffix
+	//so a collision costs one table lookup and the address one set_name
+	class NameAllocator
+	{
+	public:
+		NameAllocator(void);
+		~NameAllocator(void);
+		void Seed();
+		//names ea as name,or name_N with the first free N,when name is taken
+		//by another address.returns false if the database refused the name
+		bool Assign(ea_t ea,const char* name);
+		bool Assign(ea_t ea,const std::string& name){
+			return Assign(ea,name.c_str());
+		}
+		//keeps the tables in sync with a rename made outside the allocator,
+		//an empty name deletes the name of ea
+		void NoteRename(ea_t ea,const char* name);
+		//replaces characters set_name(SN_CHECK) would reject
+		void Sanitize(std::string* name) const;
+		uint32 set_name_calls() const{
+			return set_name_calls_;
+		}
+		uint32 collisions() const{
+			return collisions_;
+		}
+	private:
+		bool IsFree(const std::string& name,ea_t ea) const;
+		void Bind(ea_t ea,const std::string& name);
+		std::unordered_map<std::string,ea_t> owners_;
+		std::unordered_map<ea_t,std::string> names_;
+		std::unordered_map<std::string,uint32> next_suffix_;
+		//scratch names,kept so their capacity is reused between calls
+		std::string base_;
+		std::string candidate_;
+		bool ident_chars_[256];
+		bool seeded_;
+		uint32 set_name_calls_;
+		uint32 collisions_;
+		DISALLOW_EVIL_CONSTRUCTORS(NameAllocator);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,112 @@
+#include "objc/objc_original_bytes.h"
+#include <ida.hpp>
+#include <bytes.hpp>
+
+namespace objc{
+	namespace{
+		const uint64_t kNoPage = ~static_cast<uint64_t>(0);
+		struct PatchedPage{
+			ea_t start;
+			uint8* data;
+		};
+		//puts the value from before the patch back into the page copy
+		int idaapi RestoreOriginal(ea_t ea,int32 fpos,uint32 o,uint32 v,void* ud){
+			PatchedPage* page = reinterpret_cast<PatchedPage*>(ud);
+			page->data[ea-page->start] = static_cast<uint8>(o);
+			return 0;
+		}
+	}
+	OriginalBytes::OriginalBytes(void):reads_(0),hits_(0),kernel_calls_(0){
+	}
+	OriginalBytes::~OriginalBytes(void){
+	}
+	uint32 OriginalBytes::Read32(uint64_t ea){
+		return inf.mf?Read32BE(ea):Read32LE(ea);
+	}
+	uint32 OriginalBytes::Read32LE(uint64_t ea){
+		const uint8* p = Fetch(ea,4);
+		if(p==NULL){
+			return ReadKernel32(ea,false);
+		}
+		return uint32(p[0])|(uint32(p[1])<<8)|(uint32(p[2])<<16)|(uint32(p[3])<<24);
+	}
+	uint32 OriginalBytes::Read32BE(uint64_t ea){
+		const uint8* p = Fetch(ea,4);
+		if(p==NULL){
+			return ReadKernel32(ea,true);
+		}
+		return (uint32(p[0])<<24)|(uint32(p[1])<<16)|(uint32(p[2])<<8)|uint32(p[3]);
+	}
+	bool OriginalBytes::Patch32(uint64_t ea,uint32 value){
+		Invalidate(ea,ea+4);
+		return patch_long(static_cast<ea_t>(ea),value);
+	}
+	void OriginalBytes::Invalidate(uint64_t start,uint64_t end){
+		if(pages_.empty()||start>=end){
+			return;
+		}
+		for(uint64_t page = start>>kPageShift;page<=((end-1)>>kPageShift);page++){
+			uint32 slot = static_cast<uint32>(page%kPageSlots);
+			if(pages_[slot]==page){
+				pages_[slot] = kNoPage;
+			}
+		}
+	}
+	void OriginalBytes::Clear(){
+		if(!pages_.empty()){
+			pages_.assign(kPageSlots,kNoPage);
+		}
+		reads_ = 0;
+		hits_ = 0;
+		kernel_calls_ = 0;
+	}
+	const uint8* OriginalBytes::Fetch(uint64_t ea,uint32 size){
+		reads_++;
+		uint32 offset = static_cast<uint32>(ea&(kPageSize-1));
+		if(offset+size>kPageSize){
+			//straddles two pages,rare for aligned runtime structures
+			return NULL;
+		}
+		uint64_t page = ea>>kPageShift;
+		uint32 slot = static_cast<uint32>(page%kPageSlots);
+		if(!pages_.empty()&&pages_[slot]==page){
+			hits_++;
+		}
+		else if(!FillSlot(slot,page)){
+			return NULL;
+		}
+		const uint8* loaded = &loaded_[slot*(kPageSize/8)];
+		for(uint32 index = offset;index<offset+size;index++){
+			if((loaded[index/8]&(1<<(index%8)))==0){
+				//unloaded bytes read whatever the kernel says they are
+				return NULL;
+			}
+		}
+		return &data_[slot*kPageSize+offset];
+	}
+	bool OriginalBytes::FillSlot(uint32 slot,uint64_t page){
+		if(pages_.empty()){
+			data_.resize(kPageSlots*kPageSize);
+			loaded_.resize(kPageSlots*(kPageSize/8));
+			pages_.assign(kPageSlots,kNoPage);
+		}
+		pages_[slot] = kNoPage;
+		ea_t start = static_cast<ea_t>(page<<kPageShift);
+		uint8* data = &data_[slot*kPageSize];
+		kernel_calls_ += 2;
+		//0 is a partial read,the mask tells which bytes are there
+		if(get_many_bytes_ex(start,data,kPageSize,&loaded_[slot*(kPageSize/8)])<0){
+			return false;
+		}
+		PatchedPage patched = {start,data};
+		ea_t end = start+kPageSize;
+		visit_patched_bytes(start,(end>start)?end:BADADDR,RestoreOriginal,&patched);
+		pages_[slot] = page;
+		return true;
+	}
+	uint32 OriginalBytes::ReadKernel32(uint64_t ea,bool big_endian){
+		kernel_calls_++;
+		uint32 value = static_cast<uint32>(get_original_long(static_cast<ea_t>(ea)));
+		return (big_endian==inf.mf)?value:swap32(value);
+	}
+}
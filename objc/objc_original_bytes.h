@@ -0,0 +1,66 @@
+#ifndef OBJC_OBJC_ORIGINAL_BYTES_H_
+#define OBJC_OBJC_ORIGINAL_BYTES_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//pre-patch bytes of the database read a page at a time.filling a page
+	//costs two kernel calls,get_many_bytes_ex and visit_patched_bytes,and
+	//every field of the page is then served from memory where each one was
+	//a get_original_long of its own.no ida headers here,objc_string.h
+	//includes it
+	class OriginalBytes
+	{
+	public:
+		enum{
+			kPageShift = 12,
+			kPageSize = 1<<kPageShift,
+			//direct mapped,256KB once the first page is read
+			kPageSlots = 64
+		};
+		OriginalBytes(void);
+		~OriginalBytes(void);
+		//get_original_long,bytes in the order of inf.mf
+		uint32 Read32(uint64_t ea);
+		uint32 Read32LE(uint64_t ea);
+		uint32 Read32BE(uint64_t ea);
+		//patch_long.the original value survives a patch,the pages under it
+		//are still dropped so a fill never has to agree with a patch list
+		//it raced
+		bool Patch32(uint64_t ea,uint32 value);
+		void Invalidate(uint64_t start,uint64_t end);
+		//drops every page and the counters,the database may have changed
+		//since the last read
+		void Clear();
+		uint32 reads() const{
+			return reads_;
+		}
+		//reads served without filling a page
+		uint32 hits() const{
+			return hits_;
+		}
+		//get_original_long would have made one call per read
+		uint32 kernel_calls() const{
+			return kernel_calls_;
+		}
+	private:
+		//the size bytes at ea if they are loaded and on one page,NULL sends
+		//the read to the kernel
+		const uint8* Fetch(uint64_t ea,uint32 size);
+		bool FillSlot(uint32 slot,uint64_t page);
+		uint32 ReadKernel32(uint64_t ea,bool big_endian);
+		std::vector<uint8> data_;
+		//one bit per byte,set when the byte is loaded
+		std::vector<uint8> loaded_;
+		std::vector<uint64_t> pages_;
+		uint32 reads_;
+		uint32 hits_;
+		uint32 kernel_calls_;
+		DISALLOW_EVIL_CONSTRUCTORS(OriginalBytes);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,721 @@
+#include "objc/objc_pipeline.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace objc{
+	namespace{
+		const char kProtocolPrefix[] = "_OBJC_PROTOCOL_$_";
+		const char kMetaClassPrefix[] = "_OBJC_METACLASS_$_";
+		const char kClassPrefix[] = "_OBJC_CLASS_$_";
+		const char kInstanceMethodsPrefix[] = "_OBJC_INSTANCE_METHODS_";
+		const char kInstanceVariablesPrefix[] = "_OBJC_INSTANCE_VARIABLES_";
+		const char kClassMethodsPrefix[] = "_OBJC_CLASS_METHODS_";
+		const char kCategoryInstanceMethodsPrefix[] = "_OBJC_CATEGORY_INSTANCE_METHODS_";
+		const char kCategoryClassMethodsPrefix[] = "_OBJC_CATEGORY_CLASS_METHODS_";
+		//objc1 heads carry the compiler's local label names
+		const char kObjc1ModulePrefix[] = "L_OBJC_MODULES";
+		const char kObjc1SymtabPrefix[] = "L_OBJC_SYMBOLS";
+		const char kObjc1ClassPrefix[] = "L_OBJC_CLASS_";
+		const char kObjc1MetaClassPrefix[] = "L_OBJC_METACLASS_";
+		const char kObjc1CategoryPrefix[] = "L_OBJC_CATEGORY_";
+		//MethodList::ForEach visitor gathering the entries with a name and an imp
+		class ImplementationCollector
+		{
+		public:
+			explicit ImplementationCollector(MethodImplementations* methods):methods_(methods){}
+			void operator()(uint32,const Objc2Method& method){
+				if(method.name!=0&&method.imp!=0){
+					MethodImplementation implementation = {method.name,method.imp};
+					methods_->push_back(implementation);
+				}
+			}
+		private:
+			MethodImplementations* methods_;
+		};
+		bool BindLess(const MachoBind& left,const MachoBind& right){
+			return left.address<right.address;
+		}
+		//rest is the part of name after prefix
+		template<size_t N>
+		bool StripPrefix(const std::string& name,const char (&prefix)[N],StringPiece* rest){
+			if(name.compare(0,N-1,prefix)!=0){
+				return false;
+			}
+			*rest = StringPiece(name.data()+N-1,name.size()-(N-1));
+			return true;
+		}
+		//the class name a bind of field carries,NULL when field is not bound
+		//to a symbol starting with prefix
+		template<size_t N>
+		const char* BoundClassName(const std::vector<MachoBind>& binds,uint64_t field,const char (&prefix)[N]){
+			MachoBind key = {field,NULL};
+			std::vector<MachoBind>::const_iterator it = std::lower_bound(binds.begin(),binds.end(),key,BindLess);
+			if(it==binds.end()||it->address!=field||strncmp(it->symbol,prefix,N-1)!=0){
+				return NULL;
+			}
+			return it->symbol+N-1;
+		}
+		//adds a record whose name the caller writes next,EndRecord terminates it
+		NameWriter BeginRecord(uint32 kind,uint64_t ea,uint64_t slot,RestoreWork* work){
+			RestoreRecord record;
+			record.kind = kind;
+			record.ea = ea;
+			record.slot = slot;
+			record.name = static_cast<uint32>(work->names.size());
+			record.selector = RestoreRecord::kNoName;
+			record.owner = RestoreRecord::kNoName;
+			record.types = RestoreRecord::kNoName;
+			record.flags = 0;
+			work->records.push_back(record);
+			return NameWriter(&work->names);
+		}
+		void EndRecord(RestoreWork* work){
+			work->names.push_back('\0');
+		}
+		//a nul terminated string in names that is not the name of a record
+		uint32 AddString(const StringPiece& str,RestoreWork* work){
+			uint32 offset = static_cast<uint32>(work->names.size());
+			work->names.append(str.data(),str.size()).push_back('\0');
+			return offset;
+		}
+		//kMethodImp record of one method of the list owner names
+		void AddMethodImp(uint64_t imp,uint64_t slot,const StringPiece& owner,uint32 owner_offset,const char* selector,const char* types,uint32 flags,RestoreWork* work){
+			uint32 selector_offset = AddString(selector,work);
+			uint32 types_offset = (types!=NULL)?AddString(types,work):uint32(RestoreRecord::kNoName);
+			BeginRecord(RestoreRecord::kMethodImp,imp,slot,work).AppendCategoryName(owner).Append("::").AppendSelector(selector);
+			EndRecord(work);
+			RestoreRecord& record = work->records.back();
+			record.selector = selector_offset;
+			record.owner = owner_offset;
+			record.types = types_offset;
+			record.flags = flags;
+		}
+		void AddRename(uint64_t ea,const char* prefix,const StringPiece& name,RestoreWork* work){
+			BeginRecord(RestoreRecord::kRename,ea,RestoreRecord::kNoSlot,work).Append(prefix).Append(name);
+			EndRecord(work);
+		}
+		//names what an already decoded pointer points at,if anything
+		void AddPointeeRename(uint64_t target,const char* prefix,const StringPiece& name,RestoreWork* work){
+			if(target!=0){
+				BeginRecord(RestoreRecord::kRenamePointee,target,RestoreRecord::kNoSlot,work).Append(prefix).Append(name);
+				EndRecord(work);
+			}
+		}
+		class DecodeTask:public ParallelTask
+		{
+		public:
+			DecodeTask(const HeadDecoder& decoder,uint32 kind,std::vector<RestoreWork>* work):decoder_(decoder),kind_(kind),work_(work){}
+			virtual void Run(size_t index) const{
+				decoder_.Decode(kind_,&(*work_)[index]);
+			}
+		private:
+			const HeadDecoder& decoder_;
+			uint32 kind_;
+			std::vector<RestoreWork>* work_;
+		};
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::Decode(uint32 kind,RestoreWork* work) const{
+		switch(kind){
+		case kObjc2ProtocolHead:
+			DecodeProtocol(work);
+			break;
+		case kObjc2ClassHead:
+			DecodeClass(work);
+			break;
+		case kObjc2ConstHead:
+			DecodeConst(work);
+			break;
+		case kObjc1ModuleHead:
+			DecodeObjc1(work);
+			break;
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::AddPointerRename(uint64_t field,const char* prefix,const StringPiece& name,const char* suffix,RestoreWork* work) const{
+		uint64_t target = 0;
+		if(parser_.ReadPointer(field,&target)){
+			BeginRecord(RestoreRecord::kRenamePointee,target,RestoreRecord::kNoSlot,work).Append(prefix).Append(name).Append(suffix);
+			EndRecord(work);
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::DecodeProtocol(RestoreWork* work) const{
+		StringPiece protocol;
+		if(!StripPrefix(work->name,kProtocolPrefix,&protocol)){
+			return;
+		}
+		AddRename(work->ea,"",protocol,work);
+		AddPointerRename(work->ea+Layout::kProtocolProtocols,"",protocol,"_Protocol",work);
+		AddPointerRename(work->ea+Layout::kProtocolInstanceMethods,"",protocol,"_InstanceMethod",work);
+		AddPointerRename(work->ea+Layout::kProtocolClassMethods,"",protocol,"_ClassMethod",work);
+		AddPointerRename(work->ea+Layout::kProtocolOptInstanceMethods,"",protocol,"_OptInstanceMethod",work);
+		AddPointerRename(work->ea+Layout::kProtocolOptClassMethods,"",protocol,"_OptClassMethod",work);
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::DecodeClass(RestoreWork* work) const{
+		StringPiece class_name;
+		if(StripPrefix(work->name,kMetaClassPrefix,&class_name)){
+			AddRename(work->ea,"metaclass_",class_name,work);
+			AddClassDataRename("metadata_",class_name,work);
+		}
+		else if(StripPrefix(work->name,kClassPrefix,&class_name)){
+			AddRename(work->ea,"",class_name,work);
+			AddClassDataRename("classdata_",class_name,work);
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::AddClassDataRename(const char* prefix,const StringPiece& name,RestoreWork* work) const{
+		//swift and realized classes keep flags in the low bits of data
+		Objc2Class cls;
+		if(parser_.ReadClass(work->ea,&cls)){
+			BeginRecord(RestoreRecord::kRenamePointee,parser_.ClassDataPointer(cls),RestoreRecord::kNoSlot,work).Append(prefix).Append(name);
+			EndRecord(work);
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::DecodeConst(RestoreWork* work) const{
+		StringPiece class_name;
+		const char* list_prefix = NULL;
+		bool category = false;
+		uint32 flags = 0;
+		if(StripPrefix(work->name,kInstanceMethodsPrefix,&class_name)){
+			list_prefix = "instance_impl_";
+		}
+		else if(StripPrefix(work->name,kClassMethodsPrefix,&class_name)){
+			list_prefix = "class_impl_";
+			flags = RestoreRecord::kClassMethods;
+		}
+		else if(StripPrefix(work->name,kCategoryInstanceMethodsPrefix,&class_name)){
+			list_prefix = "category_impl_";
+			category = true;
+		}
+		else if(StripPrefix(work->name,kCategoryClassMethodsPrefix,&class_name)){
+			list_prefix = "category_impl_";
+			category = true;
+			flags = RestoreRecord::kClassMethods;
+		}
+		else if(StripPrefix(work->name,kInstanceVariablesPrefix,&class_name)){
+			AddRename(work->ea,"ivars_",class_name,work);
+			return;
+		}
+		else{
+			return;
+		}
+		if(!DecodeMethodList(work->ea,class_name,flags,work)){
+			BeginRecord(RestoreRecord::kLegacyMethodList,work->ea,RestoreRecord::kNoSlot,work).Append(class_name);
+			EndRecord(work);
+			work->records.back().flags = flags;
+		}
+		NameWriter writer = BeginRecord(RestoreRecord::kRename,work->ea,RestoreRecord::kNoSlot,work).Append(list_prefix);
+		if(category){
+			writer.AppendCategoryName(class_name);
+		}
+		else{
+			writer.Append(class_name);
+		}
+		EndRecord(work);
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::DecodeObjc1(RestoreWork* work) const{
+		//the names the section handlers of the database path give,the
+		//structures are found by the chain instead of by head type
+		StringPiece name;
+		Objc1Class cls;
+		Objc1Category category;
+		if(StripPrefix(work->name,kObjc1ClassPrefix,&name)&&objc1_.ReadClass(work->ea,&cls)){
+			AddRename(work->ea,"",name,work);
+			AddPointeeRename(cls.ivars,"ivars_",name,work);
+			AddPointeeRename(cls.methods,"methods_",name,work);
+			DecodeObjc1MethodList(cls.methods,name,0,work);
+		}
+		else if(StripPrefix(work->name,kObjc1MetaClassPrefix,&name)&&objc1_.ReadClass(work->ea,&cls)){
+			AddRename(work->ea,"MetaClass",name,work);
+			AddPointeeRename(cls.methods,"method_impl_",name,work);
+			DecodeObjc1MethodList(cls.methods,name,RestoreRecord::kClassMethods,work);
+		}
+		else if(StripPrefix(work->name,kObjc1CategoryPrefix,&name)&&objc1_.ReadCategory(work->ea,&category)){
+			AddRename(work->ea,"",name,work);
+			AddPointeeRename(category.instance_methods,"method_impl_",name,work);
+			AddPointeeRename(category.class_methods,"class_impl_",name,work);
+			DecodeObjc1MethodList(category.instance_methods,name,0,work);
+			DecodeObjc1MethodList(category.class_methods,name,RestoreRecord::kClassMethods,work);
+		}
+		else if(work->name==kObjc1ModulePrefix){
+			Objc1Module module;
+			if(objc1_.ReadModule(work->ea,&module)&&module.symtab!=0){
+				char buf[32] = {0};
+				sprintf(buf,"symtab_%x",module.symtab);
+				AddRename(work->ea,buf,"",work);
+			}
+		}
+		else if(work->name==kObjc1SymtabPrefix){
+			std::string definition;
+			if(Objc1DefinitionName(work->ea,&definition)){
+				AddRename(work->ea,"symtab_",definition,work);
+			}
+		}
+	}
+	template<typename Layout>
+	bool Objc2HeadDecoder<Layout>::Objc1DefinitionName(uint64_t symtab,std::string* name) const{
+		Objc1Symtab table;
+		uint64_t definition = 0;
+		if(!objc1_.ReadSymtab(symtab,&table)||!objc1_.ReadDefinition(symtab,0,&definition)){
+			return false;
+		}
+		const char* class_name = NULL;
+		const char* category_name = NULL;
+		if(table.class_count>0){
+			Objc1Class cls;
+			class_name = objc1_.ReadClass(definition,&cls)?objc1_.ReadString(cls.name):NULL;
+		}
+		else{
+			Objc1Category category;
+			if(objc1_.ReadCategory(definition,&category)){
+				class_name = objc1_.ReadString(category.class_name);
+				category_name = objc1_.ReadString(category.name);
+			}
+		}
+		if(class_name==NULL){
+			return false;
+		}
+		name->assign(class_name);
+		if(category_name!=NULL){
+			name->append("_").append(category_name);
+		}
+		return true;
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::DecodeObjc1MethodList(uint64_t ea,const StringPiece& owner,uint32 flags,RestoreWork* work) const{
+		std::vector<Objc1Method> methods;
+		if(ea==0){
+			return;
+		}
+		if(!objc1_.ReadMethodList(ea,&methods)){
+			BeginRecord(RestoreRecord::kLegacyMethodList,ea,RestoreRecord::kNoSlot,work).Append(owner);
+			EndRecord(work);
+			work->records.back().flags = flags;
+			return;
+		}
+		uint32 owner_offset = AddString(owner,work);
+		uint64_t slot = ea+Objc1Layout::kMethodListEntries+Objc1Layout::kMethodImp;
+		for(std::vector<Objc1Method>::const_iterator it = methods.begin();it!=methods.end();++it,slot += Objc1Layout::kMethodSize){
+			AddMethodImp(it->imp,slot,owner,owner_offset,objc1_.ReadString(it->name),objc1_.ReadString(it->types),flags,work);
+		}
+	}
+	template<typename Layout>
+	bool Objc2HeadDecoder<Layout>::DecodeMethodList(uint64_t ea,const StringPiece& class_name,uint32 flags,RestoreWork* work) const{
+		typename Objc2Parser<Layout>::MethodList methods;
+		if(!parser_.ReadMethodList(ea,&methods)){
+			return false;
+		}
+		uint32 owner_offset = AddString(class_name,work);
+		for(uint32 index=0;index<methods.count();index++){
+			Objc2Method method;
+			methods.Get(index,&method);
+			//only absolute 32-bit slots need the thumb bit stripped,relative
+			//slots are offsets and must not be overwritten
+			uint64_t imp_slot = (Layout::kPtrSize==4&&!methods.relative())?methods.ImpAddress(index):uint64_t(RestoreRecord::kNoSlot);
+			AddMethodImp(method.imp,imp_slot,class_name,owner_offset,parser_.ReadString(method.name),parser_.ReadString(method.types),flags,work);
+		}
+		return true;
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::CollectClassHeads(uint32 kind,NamedHeads* heads) const{
+		//non-lazy classes are listed a second time,CollectHeads drops the repeats
+		std::vector<uint64_t> classes;
+		parser_.ReadPointerList("__objc_classlist",&classes);
+		parser_.ReadPointerList("__objc_nlclslist",&classes);
+		for(std::vector<uint64_t>::const_iterator it = classes.begin();it!=classes.end();++it){
+			Objc2Class cls;
+			Objc2ClassRo ro;
+			const char* name = parser_.ReadClassName(*it,&cls,&ro);
+			if(name==NULL){
+				continue;
+			}
+			Objc2Class meta;
+			Objc2ClassRo meta_ro;
+			bool has_meta = (parser_.ReadClassName(cls.isa,&meta,&meta_ro)!=NULL);
+			if(kind==kObjc2ClassHead){
+				heads->push_back(std::make_pair(*it,std::string(kClassPrefix)+name));
+				if(has_meta){
+					heads->push_back(std::make_pair(cls.isa,std::string(kMetaClassPrefix)+name));
+				}
+				continue;
+			}
+			if(ro.base_methods!=0){
+				heads->push_back(std::make_pair(ro.base_methods,std::string(kInstanceMethodsPrefix)+name));
+			}
+			if(ro.ivars!=0){
+				heads->push_back(std::make_pair(ro.ivars,std::string(kInstanceVariablesPrefix)+name));
+			}
+			if(has_meta&&meta_ro.base_methods!=0){
+				heads->push_back(std::make_pair(meta_ro.base_methods,std::string(kClassMethodsPrefix)+name));
+			}
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::CollectCategoryHeads(NamedHeads* heads) const{
+		std::vector<uint64_t> categories;
+		parser_.ReadPointerList("__objc_catlist",&categories);
+		parser_.ReadPointerList("__objc_nlcatlist",&categories);
+		std::vector<MachoBind> binds;
+		if(!categories.empty()){
+			parser_.image().CollectBinds(&binds);
+		}
+		for(std::vector<uint64_t>::const_iterator it = categories.begin();it!=categories.end();++it){
+			Objc2Category category;
+			Objc2Class cls;
+			Objc2ClassRo ro;
+			if(!parser_.ReadCategory(*it,&category)){
+				continue;
+			}
+			const char* category_name = parser_.ReadString(category.name);
+			//a class bound from another image has no class_ro_t here,its
+			//bind names it like in CollectClassGraph
+			const char* class_name = parser_.ReadClassName(category.cls,&cls,&ro);
+			if(class_name==NULL){
+				class_name = BoundClassName(binds,*it+Layout::kCategoryClass,kClassPrefix);
+			}
+			if(category_name==NULL||class_name==NULL){
+				continue;
+			}
+			std::string name = std::string(class_name)+"_$_"+category_name;
+			if(category.instance_methods!=0){
+				heads->push_back(std::make_pair(category.instance_methods,kCategoryInstanceMethodsPrefix+name));
+			}
+			if(category.class_methods!=0){
+				heads->push_back(std::make_pair(category.class_methods,kCategoryClassMethodsPrefix+name));
+			}
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::CollectObjc1Heads(NamedHeads* heads) const{
+		Objc1Chain chain;
+		if(!objc1_.ReadChain(&chain)){
+			return;
+		}
+		for(std::vector<uint64_t>::const_iterator it = chain.modules.begin();it!=chain.modules.end();++it){
+			heads->push_back(std::make_pair(*it,std::string(kObjc1ModulePrefix)));
+		}
+		for(std::vector<uint64_t>::const_iterator it = chain.symtabs.begin();it!=chain.symtabs.end();++it){
+			heads->push_back(std::make_pair(*it,std::string(kObjc1SymtabPrefix)));
+		}
+		Objc1Class cls;
+		const char* name = NULL;
+		for(std::vector<uint64_t>::const_iterator it = chain.classes.begin();it!=chain.classes.end();++it){
+			if(objc1_.ReadClass(*it,&cls)&&(name = objc1_.ReadString(cls.name))!=NULL){
+				heads->push_back(std::make_pair(*it,std::string(kObjc1ClassPrefix)+name));
+			}
+		}
+		//a metaclass carries the name of its class
+		for(std::vector<uint64_t>::const_iterator it = chain.metaclasses.begin();it!=chain.metaclasses.end();++it){
+			if(objc1_.ReadClass(*it,&cls)&&(name = objc1_.ReadString(cls.name))!=NULL){
+				heads->push_back(std::make_pair(*it,std::string(kObjc1MetaClassPrefix)+name));
+			}
+		}
+		for(std::vector<uint64_t>::const_iterator it = chain.categories.begin();it!=chain.categories.end();++it){
+			Objc1Category category;
+			const char* category_name = NULL;
+			if(objc1_.ReadCategory(*it,&category)&&(name = objc1_.ReadString(category.class_name))!=NULL&&
+				(category_name = objc1_.ReadString(category.name))!=NULL){
+				heads->push_back(std::make_pair(*it,std::string(kObjc1CategoryPrefix)+name+"_"+category_name));
+			}
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::CollectHeads(uint32 kind,RestorePipeline* pipeline) const{
+		NamedHeads heads;
+		if(kind==kObjc2ProtocolHead){
+			std::vector<uint64_t> protocols;
+			parser_.ReadPointerList("__objc_protolist",&protocols);
+			for(std::vector<uint64_t>::const_iterator it = protocols.begin();it!=protocols.end();++it){
+				Objc2Protocol protocol;
+				const char* name = NULL;
+				if(parser_.ReadProtocol(*it,&protocol)&&(name = parser_.ReadString(protocol.name))!=NULL){
+					heads.push_back(std::make_pair(*it,std::string(kProtocolPrefix)+name));
+				}
+			}
+		}
+		else if(kind==kObjc1ModuleHead){
+			CollectObjc1Heads(&heads);
+		}
+		else{
+			CollectClassHeads(kind,&heads);
+			if(kind==kObjc2ConstHead){
+				CollectCategoryHeads(&heads);
+			}
+		}
+		//address order like a section walk,a head listed twice is added once
+		std::sort(heads.begin(),heads.end());
+		for(typename NamedHeads::const_iterator it = heads.begin();it!=heads.end();++it){
+			if(it==heads.begin()||it->first!=(it-1)->first){
+				pipeline->Add(it->first,it->second.c_str());
+			}
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::CollectImplementations(MethodImplementations* methods) const{
+		std::vector<uint64_t> lists;
+		std::vector<uint64_t> classes;
+		parser_.ReadPointerList("__objc_classlist",&classes);
+		parser_.ReadPointerList("__objc_nlclslist",&classes);
+		for(std::vector<uint64_t>::const_iterator it = classes.begin();it!=classes.end();++it){
+			Objc2Class cls;
+			Objc2ClassRo ro;
+			if(parser_.ReadClassName(*it,&cls,&ro)==NULL){
+				continue;
+			}
+			lists.push_back(ro.base_methods);
+			if(parser_.ReadClassName(cls.isa,&cls,&ro)!=NULL){
+				lists.push_back(ro.base_methods);
+			}
+		}
+		std::vector<uint64_t> categories;
+		parser_.ReadPointerList("__objc_catlist",&categories);
+		parser_.ReadPointerList("__objc_nlcatlist",&categories);
+		for(std::vector<uint64_t>::const_iterator it = categories.begin();it!=categories.end();++it){
+			Objc2Category category;
+			if(parser_.ReadCategory(*it,&category)){
+				lists.push_back(category.instance_methods);
+				lists.push_back(category.class_methods);
+			}
+		}
+		std::sort(lists.begin(),lists.end());
+		lists.erase(std::unique(lists.begin(),lists.end()),lists.end());
+		ImplementationCollector collector(methods);
+		for(std::vector<uint64_t>::const_iterator it = lists.begin();it!=lists.end();++it){
+			typename Objc2Parser<Layout>::MethodList list;
+			if(*it==0||!parser_.ReadMethodList(*it,&list)){
+				continue;
+			}
+			list.ForEach(collector);
+		}
+		Objc1Chain chain;
+		if(objc1_.ReadChain(&chain)){
+			std::vector<uint64_t> objc1_lists;
+			Objc1Class cls;
+			Objc1Category category;
+			for(std::vector<uint64_t>::const_iterator it = chain.classes.begin();it!=chain.classes.end();++it){
+				if(objc1_.ReadClass(*it,&cls)){
+					objc1_lists.push_back(cls.methods);
+				}
+			}
+			for(std::vector<uint64_t>::const_iterator it = chain.metaclasses.begin();it!=chain.metaclasses.end();++it){
+				if(objc1_.ReadClass(*it,&cls)){
+					objc1_lists.push_back(cls.methods);
+				}
+			}
+			for(std::vector<uint64_t>::const_iterator it = chain.categories.begin();it!=chain.categories.end();++it){
+				if(objc1_.ReadCategory(*it,&category)){
+					objc1_lists.push_back(category.instance_methods);
+					objc1_lists.push_back(category.class_methods);
+				}
+			}
+			std::vector<Objc1Method> objc1_methods;
+			for(std::vector<uint64_t>::const_iterator it = objc1_lists.begin();it!=objc1_lists.end();++it){
+				objc1_methods.clear();
+				if(*it==0||!objc1_.ReadMethodList(*it,&objc1_methods)){
+					continue;
+				}
+				for(std::vector<Objc1Method>::const_iterator method = objc1_methods.begin();method!=objc1_methods.end();++method){
+					if(method->name!=0&&method->imp!=0){
+						MethodImplementation implementation = {method->name,method->imp};
+						methods->push_back(implementation);
+					}
+				}
+			}
+		}
+		std::sort(methods->begin(),methods->end());
+		methods->erase(std::unique(methods->begin(),methods->end()),methods->end());
+	}
+	template<typename Layout>
+	uint32 Objc2HeadDecoder<Layout>::AddGraphClass(uint64_t ea,const std::vector<MachoBind>& binds,ClassGraph* graph) const{
+		Objc2Class cls;
+		Objc2ClassRo ro;
+		const char* name = parser_.ReadClassName(ea,&cls,&ro);
+		if(name==NULL){
+			return ClassGraph::kNoNode;
+		}
+		uint32 node = graph->AddClass(ea,name,0);
+		const char* imported = NULL;
+		graph->SetSuperclass(node,cls.superclass);
+		if(cls.superclass==0&&(imported = BoundClassName(binds,ea+Layout::kClassSuperclass,kClassPrefix))!=NULL){
+			graph->AddImportedClass(imported,0);
+			graph->SetSuperclassName(node,imported,0);
+		}
+		AddGraphMethods(node,ro.base_methods,StringPiece(),graph);
+		Objc2Class meta;
+		if(parser_.ReadClassName(cls.isa,&meta,&ro)!=NULL){
+			uint32 metaclass = graph->AddClass(cls.isa,name,ClassGraph::kMetaClass);
+			//the root metaclass points back at the root class
+			graph->SetSuperclass(metaclass,meta.superclass);
+			if(meta.superclass==0&&(imported = BoundClassName(binds,cls.isa+Layout::kClassSuperclass,kMetaClassPrefix))!=NULL){
+				graph->AddImportedClass(imported,ClassGraph::kMetaClass);
+				graph->SetSuperclassName(metaclass,imported,ClassGraph::kMetaClass);
+			}
+			graph->SetMetaclass(node,metaclass);
+			AddGraphMethods(metaclass,ro.base_methods,StringPiece(),graph);
+		}
+		return node;
+	}
+	template<typename Layout>
+	uint32 Objc2HeadDecoder<Layout>::AddGraphImportedClass(uint64_t field,const std::vector<MachoBind>& binds,ClassGraph* graph) const{
+		const char* name = BoundClassName(binds,field,kClassPrefix);
+		if(name==NULL){
+			return ClassGraph::kNoNode;
+		}
+		uint32 node = graph->AddImportedClass(name,0);
+		graph->SetMetaclass(node,graph->AddImportedClass(name,ClassGraph::kMetaClass));
+		return node;
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::AddGraphMethods(uint32 node,uint64_t list,const StringPiece& category,ClassGraph* graph) const{
+		typename Objc2Parser<Layout>::MethodList methods;
+		if(node==ClassGraph::kNoNode||list==0||!parser_.ReadMethodList(list,&methods)){
+			return;
+		}
+		const char* selector = NULL;
+		for(uint32 index=0;index<methods.count();index++){
+			Objc2Method method;
+			if(methods.Get(index,&method)&&method.imp!=0&&(selector = parser_.ReadString(method.name))!=NULL){
+				graph->AddMethod(node,selector,method.imp,category);
+			}
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::AddGraphObjc1Methods(uint32 node,uint64_t list,const StringPiece& category,ClassGraph* graph) const{
+		std::vector<Objc1Method> methods;
+		if(node==ClassGraph::kNoNode||list==0||!objc1_.ReadMethodList(list,&methods)){
+			return;
+		}
+		const char* selector = NULL;
+		for(std::vector<Objc1Method>::const_iterator it = methods.begin();it!=methods.end();++it){
+			if(it->imp!=0&&(selector = objc1_.ReadString(it->name))!=NULL){
+				graph->AddMethod(node,selector,it->imp,category);
+			}
+		}
+	}
+	template<typename Layout>
+	void Objc2HeadDecoder<Layout>::CollectClassGraph(ClassGraph* graph) const{
+		std::vector<uint64_t> classes;
+		parser_.ReadPointerList("__objc_classlist",&classes);
+		parser_.ReadPointerList("__objc_nlclslist",&classes);
+		//a non-lazy class is in both lists
+		std::sort(classes.begin(),classes.end());
+		classes.erase(std::unique(classes.begin(),classes.end()),classes.end());
+		std::vector<MachoBind> binds;
+		parser_.image().CollectBinds(&binds);
+		for(std::vector<uint64_t>::const_iterator it = classes.begin();it!=classes.end();++it){
+			AddGraphClass(*it,binds,graph);
+		}
+		//categories go on after every class is known,in list order so the
+		//last one wins like at runtime.one on a class of another image goes
+		//to the class its bind names
+		std::vector<uint64_t> categories;
+		std::vector<uint64_t> non_lazy;
+		parser_.ReadPointerList("__objc_catlist",&categories);
+		parser_.ReadPointerList("__objc_nlcatlist",&non_lazy);
+		std::vector<uint64_t> listed(categories);
+		std::sort(listed.begin(),listed.end());
+		for(std::vector<uint64_t>::const_iterator it = non_lazy.begin();it!=non_lazy.end();++it){
+			if(!std::binary_search(listed.begin(),listed.end(),*it)){
+				categories.push_back(*it);
+			}
+		}
+		for(std::vector<uint64_t>::const_iterator it = categories.begin();it!=categories.end();++it){
+			Objc2Category category;
+			const char* name = NULL;
+			if(!parser_.ReadCategory(*it,&category)||(name = parser_.ReadString(category.name))==NULL){
+				continue;
+			}
+			uint32 node = (category.cls!=0)?graph->FindClass(category.cls):AddGraphImportedClass(*it+Layout::kCategoryClass,binds,graph);
+			if(node!=ClassGraph::kNoNode){
+				AddGraphMethods(node,category.instance_methods,name,graph);
+				AddGraphMethods(graph->node(node).metaclass,category.class_methods,name,graph);
+			}
+		}
+		Objc1Chain chain;
+		if(!objc1_.ReadChain(&chain)){
+			return;
+		}
+		//objc1 names superclasses instead of pointing at them,a root
+		//metaclass names nothing and gets the root class like at runtime
+		for(std::vector<uint64_t>::const_iterator it = chain.classes.begin();it!=chain.classes.end();++it){
+			Objc1Class cls;
+			Objc1Class meta;
+			const char* name = NULL;
+			if(!objc1_.ReadClass(*it,&cls)||(name = objc1_.ReadString(cls.name))==NULL){
+				continue;
+			}
+			const char* superclass = (cls.superclass!=0)?objc1_.ReadString(cls.superclass):NULL;
+			uint32 node = graph->AddClass(*it,name,0);
+			if(superclass!=NULL){
+				graph->SetSuperclassName(node,superclass,0);
+			}
+			AddGraphObjc1Methods(node,cls.methods,StringPiece(),graph);
+			if(objc1_.ReadClass(cls.isa,&meta)){
+				uint32 metaclass = graph->AddClass(cls.isa,name,ClassGraph::kMetaClass);
+				if(superclass!=NULL){
+					graph->SetSuperclassName(metaclass,superclass,ClassGraph::kMetaClass);
+				}
+				else{
+					graph->SetSuperclassName(metaclass,name,0);
+				}
+				graph->SetMetaclass(node,metaclass);
+				AddGraphObjc1Methods(metaclass,meta.methods,StringPiece(),graph);
+			}
+		}
+		for(std::vector<uint64_t>::const_iterator it = chain.categories.begin();it!=chain.categories.end();++it){
+			Objc1Category category;
+			const char* class_name = NULL;
+			const char* name = NULL;
+			if(!objc1_.ReadCategory(*it,&category)||(class_name = objc1_.ReadString(category.class_name))==NULL||
+				(name = objc1_.ReadString(category.name))==NULL){
+				continue;
+			}
+			uint32 node = graph->FindClassNamed(class_name,0);
+			if(node!=ClassGraph::kNoNode){
+				AddGraphObjc1Methods(node,category.instance_methods,name,graph);
+				AddGraphObjc1Methods(graph->node(node).metaclass,category.class_methods,name,graph);
+			}
+		}
+	}
+	HeadDecoder* CreateHeadDecoder(const MachoImage& image){
+		if(image.is64()){
+			return new Objc2HeadDecoder<Layout64>(image);
+		}
+		else if(image.swapped()){
+			return new Objc2HeadDecoder<Layout32BE>(image);
+		}
+		return new Objc2HeadDecoder<Layout32>(image);
+	}
+	template class Objc2HeadDecoder<Layout32>;
+	template class Objc2HeadDecoder<Layout32BE>;
+	template class Objc2HeadDecoder<Layout64>;
+	RestorePipeline::RestorePipeline(ThreadPool* pool):pool_(pool),decoded_heads_(0),decoded_records_(0){
+	}
+	RestorePipeline::~RestorePipeline(void){
+	}
+	void RestorePipeline::Add(uint64_t ea,const char* name){
+		if(name==NULL){
+			return;
+		}
+		work_.push_back(RestoreWork());
+		work_.back().ea = ea;
+		work_.back().name = name;
+	}
+	void RestorePipeline::Decode(const HeadDecoder& decoder,uint32 kind){
+		//heads arrive in address order and every worker writes only its own
+		//entry,so the result does not depend on the thread count
+		pool_->ParallelFor(work_.size(),DecodeTask(decoder,kind,&work_));
+		decoded_heads_ += static_cast<uint32>(work_.size());
+		for(std::vector<RestoreWork>::const_iterator it = work_.begin();it!=work_.end();++it){
+			decoded_records_ += static_cast<uint32>(it->records.size());
+		}
+	}
+	void RestorePipeline::Clear(){
+		work_.clear();
+	}
+}
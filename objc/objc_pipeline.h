@@ -0,0 +1,203 @@
+#ifndef OBJC_OBJC_PIPELINE_H_
+#define OBJC_OBJC_PIPELINE_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "objc/macho_image.h"
+#include "objc/objc2_parser.h"
+#include "objc/objc1_parser.h"
+#include "objc/objc_thread_pool.h"
+#include "objc/objc_string.h"
+#include "objc/objc_class_graph.h"
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:decoding runs on worker threads and turns the mapped
+//image into records,the records are applied to the database by the caller
+namespace objc{
+	//one database change,in the order the serial handlers used to make it
+	struct RestoreRecord
+	{
+		enum Kind{
+			//name ea
+			kRename,
+			//name ea,skipped when ea is not inside the database
+			kRenamePointee,
+			//name the function containing ea and patch slot with its start
+			kMethodImp,
+			//list is not in the image,walk it through the database as objc1
+			kLegacyMethodList
+		};
+		enum{
+			kNoSlot = 0xFFFFFFFF,
+			kNoName = 0xFFFFFFFF
+		};
+		enum{
+			//kMethodImp and kLegacyMethodList,the list holds class methods
+			kClassMethods = 0x1
+		};
+		uint32 kind;
+		uint64_t ea;
+		uint64_t slot;
+		//offset of the nul terminated name in RestoreWork::names
+		uint32 name;
+		//kMethodImp:the selector as it is in the image and the class or
+		//category owning the list,offsets in names like name or kNoName
+		uint32 selector;
+		uint32 owner;
+		//kMethodImp:the type encoding of the method,kNoName if it has none
+		uint32 types;
+		uint32 flags;
+	};
+	typedef std::vector<RestoreRecord> RestoreRecords;
+	//one named head of an objc2 section and what decoding it produced.record
+	//names are written back to back into names,not allocated one by one
+	struct RestoreWork
+	{
+		uint64_t ea;
+		std::string name;
+		RestoreRecords records;
+		std::string names;
+		const char* RecordName(const RestoreRecord& record) const{
+			return names.c_str()+record.name;
+		}
+		void Clear(){
+			records.clear();
+			names.clear();
+		}
+	};
+	//one method of a class,metaclass or category.selector is the address of
+	//the name string,the same address the selector references hold
+	struct MethodImplementation
+	{
+		uint64_t selector;
+		uint64_t imp;
+		bool operator<(const MethodImplementation& other) const{
+			return (selector!=other.selector)?selector<other.selector:imp<other.imp;
+		}
+		bool operator==(const MethodImplementation& other) const{
+			return selector==other.selector&&imp==other.imp;
+		}
+	};
+	typedef std::vector<MethodImplementation> MethodImplementations;
+	enum RestoreHeadKind{
+		kObjc2ProtocolHead,	//__data
+		kObjc2ClassHead,	//__objc_data
+		kObjc2ConstHead,	//__objc_const
+		kObjc1ModuleHead	//__module_info chain
+	};
+	class RestorePipeline;
+	class HeadDecoder
+	{
+	public:
+		virtual ~HeadDecoder(){}
+		virtual void Decode(uint32 kind,RestoreWork* work) const = 0;
+		//false if the list is not inside the image.flags are the
+		//RestoreRecord flags of the list
+		virtual bool DecodeMethodList(uint64_t ea,const StringPiece& class_name,uint32 flags,RestoreWork* work) const = 0;
+		//adds the heads of kind reachable from __objc_protolist,__objc_classlist,
+		//__objc_nlclslist,__objc_catlist and __objc_nlcatlist in address order,
+		//named the way the linker names their symbols.only the metadata is
+		//read,so this costs O(classes) and works on stripped images.
+		//kObjc1ModuleHead follows __module_info to the symtabs,classes,
+		//metaclasses and categories instead
+		virtual void CollectHeads(uint32 kind,RestorePipeline* pipeline) const = 0;
+		//every method the class,category and objc1 lists lead to,sorted by
+		//selector and each pair once
+		virtual void CollectImplementations(MethodImplementations* methods) const = 0;
+		//the classes,metaclasses and categories of the lists and the objc1
+		//chain with their methods,graph is left for the caller to Build
+		virtual void CollectClassGraph(ClassGraph* graph) const = 0;
+		virtual bool ReadPointer(uint64_t ea,uint64_t* value) const = 0;
+		virtual const char* ReadString(uint64_t ea) const = 0;
+	};
+	//decoder for the layout of the selected slice of image
+	HeadDecoder* CreateHeadDecoder(const MachoImage& image);
+	template<typename Layout>
+	class Objc2HeadDecoder:public HeadDecoder
+	{
+	public:
+		explicit Objc2HeadDecoder(const MachoImage& image):parser_(image),objc1_(image){}
+		virtual void Decode(uint32 kind,RestoreWork* work) const;
+		virtual bool DecodeMethodList(uint64_t ea,const StringPiece& class_name,uint32 flags,RestoreWork* work) const;
+		virtual void CollectHeads(uint32 kind,RestorePipeline* pipeline) const;
+		virtual void CollectImplementations(MethodImplementations* methods) const;
+		virtual void CollectClassGraph(ClassGraph* graph) const;
+		virtual bool ReadPointer(uint64_t ea,uint64_t* value) const{
+			return parser_.ReadPointer(ea,value);
+		}
+		virtual const char* ReadString(uint64_t ea) const{
+			return parser_.ReadString(ea);
+		}
+	private:
+		typedef std::vector<std::pair<uint64_t,std::string> > NamedHeads;
+		void CollectClassHeads(uint32 kind,NamedHeads* heads) const;
+		void CollectCategoryHeads(NamedHeads* heads) const;
+		void CollectObjc1Heads(NamedHeads* heads) const;
+		void DecodeProtocol(RestoreWork* work) const;
+		void DecodeClass(RestoreWork* work) const;
+		void DecodeConst(RestoreWork* work) const;
+		void DecodeObjc1(RestoreWork* work) const;
+		//the name a symtab is known by,from its first definition
+		bool Objc1DefinitionName(uint64_t symtab,std::string* name) const;
+		void DecodeObjc1MethodList(uint64_t ea,const StringPiece& owner,uint32 flags,RestoreWork* work) const;
+		//node for the objc2 class at ea and its metaclass,kNoNode if it is not
+		//in the image.a superclass of another image is found through binds
+		uint32 AddGraphClass(uint64_t ea,const std::vector<MachoBind>& binds,ClassGraph* graph) const;
+		//the class of another image a category extends,kNoNode if none is bound
+		uint32 AddGraphImportedClass(uint64_t field,const std::vector<MachoBind>& binds,ClassGraph* graph) const;
+		void AddGraphMethods(uint32 node,uint64_t list,const StringPiece& category,ClassGraph* graph) const;
+		void AddGraphObjc1Methods(uint32 node,uint64_t list,const StringPiece& category,ClassGraph* graph) const;
+		void AddPointerRename(uint64_t field,const char* prefix,const StringPiece& name,const char* suffix,RestoreWork* work) const;
+		//names the class_ro_t of the class_t at work->ea
+		void AddClassDataRename(const char* prefix,const StringPiece& name,RestoreWork* work) const;
+		Objc2Parser<Layout> parser_;
+		//objc1 metadata of the same image,only 32-bit images have any
+		Objc1Parser<Layout> objc1_;
+		DISALLOW_EVIL_CONSTRUCTORS(Objc2HeadDecoder);
+	};
+	//collects the named heads of one section,decodes them on the pool and
+	//keeps the results in address order so applying them matches a serial run
+	class RestorePipeline
+	{
+	public:
+		explicit RestorePipeline(ThreadPool* pool);
+		~RestorePipeline(void);
+		void Add(uint64_t ea,const char* name);
+		void Decode(const HeadDecoder& decoder,uint32 kind);
+		const std::vector<RestoreWork>& work() const{
+			return work_;
+		}
+		//drops the heads keep(ea) rejects,the rest stay in order
+		template<typename Predicate>
+		void Filter(Predicate keep){
+			size_t kept = 0;
+			for(size_t index=0;index<work_.size();index++){
+				if(keep(work_[index].ea)){
+					if(kept!=index){
+						std::swap(work_[kept],work_[index]);
+					}
+					kept++;
+				}
+			}
+			work_.resize(kept);
+		}
+		void Clear();
+		uint32 decoded_heads() const{
+			return decoded_heads_;
+		}
+		uint32 decoded_records() const{
+			return decoded_records_;
+		}
+	private:
+		ThreadPool* pool_;
+		std::vector<RestoreWork> work_;
+		uint32 decoded_heads_;
+		uint32 decoded_records_;
+		DISALLOW_EVIL_CONSTRUCTORS(RestorePipeline);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,101 @@
+#include "objc/objc_prototypes.h"
+#include <ida.hpp>
+#include <kernwin.hpp>
+#include <funcs.hpp>
+#include <nalt.hpp>
+#include <typeinf.hpp>
+#include <algorithm>
+
+namespace objc{
+	PrototypeApplier::PrototypeApplier(void):malformed_(0),commit_index_(0),state_(kUndeclared),applied_(0),kept_(0),
+		undeclarable_(0),declared_(0),elapsed_(0){
+	}
+	PrototypeApplier::~PrototypeApplier(void){
+	}
+	void PrototypeApplier::Add(ea_t imp,const StringPiece& encoding){
+		uint32 signature = parser_.Parse(encoding);
+		if(signature==TypeEncodingParser::kNoSignature){
+			malformed_++;
+			return;
+		}
+		Pending pending = {imp,signature};
+		pending_.push_back(pending);
+	}
+	void PrototypeApplier::Clear(){
+		parser_.Clear();
+		std::vector<Pending>().swap(pending_);
+		malformed_ = 0;
+		commit_index_ = 0;
+		type_.clear();
+		state_ = kUndeclared;
+		applied_ = 0;
+		kept_ = 0;
+		undeclarable_ = 0;
+		declared_ = 0;
+		elapsed_ = 0;
+	}
+	bool PrototypeApplier::Declare(uint32 signature,tinfo_t* type){
+		qstring name;
+		parser_.Declaration(signature,"objc_method",false,&decl_);
+		decl_.append(";");
+		if(parse_decl2(idati,decl_.c_str(),&name,type,PT_SIL)){
+			return true;
+		}
+		//a struct the til does not know is fine behind a pointer
+		if((parser_.signature(signature).flags&TypeEncodingParser::kAggregatePointer)==0){
+			return false;
+		}
+		parser_.Declaration(signature,"objc_method",true,&decl_);
+		decl_.append(";");
+		return parse_decl2(idati,decl_.c_str(),&name,type,PT_SIL);
+	}
+	bool PrototypeApplier::Commit(uint64 deadline){
+		if(pending_.empty()){
+			return true;
+		}
+		uint64 start = 0;
+		get_nsec_stamp(&start);
+		if(commit_index_==0){
+			std::sort(pending_.begin(),pending_.end());
+		}
+		while(commit_index_<pending_.size()){
+			size_t index = commit_index_++;
+			const Pending& pending = pending_[index];
+			if(index==0||pending.signature!=pending_[index-1].signature){
+				state_ = Declare(pending.signature,&type_)?kDeclared:kUndeclarable;
+				declared_ += (state_==kDeclared)?1:0;
+			}
+			//an imp listed twice is typed once
+			if(index!=0&&pending.ea==pending_[index-1].ea&&pending.signature==pending_[index-1].signature){
+				continue;
+			}
+			if(state_!=kDeclared){
+				undeclarable_++;
+			}
+			else{
+				func_t* func = get_func(pending.ea);
+				if(func==NULL||is_userti(func->startEA)){
+					kept_++;
+				}
+				else if(apply_tinfo2(func->startEA,type_,TINFO_DEFINITE)){
+					applied_++;
+				}
+			}
+			if(deadline!=0){
+				uint64 now = 0;
+				get_nsec_stamp(&now);
+				if(now>=deadline&&commit_index_<pending_.size()){
+					elapsed_ += now-start;
+					return false;
+				}
+			}
+		}
+		uint64 now = 0;
+		get_nsec_stamp(&now);
+		elapsed_ += now-start;
+		msg("objc: %u prototypes applied from %u encodings (%u parsed,%u lookups from cache),%u kept,%u not declarable,%u malformed in %u ms\n",
+			applied_,declared_,parser_.signature_count(),parser_.hits(),kept_,undeclarable_,malformed_,static_cast<uint32>(elapsed_/1000000));
+		Clear();
+		return true;
+	}
+}
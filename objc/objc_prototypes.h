@@ -0,0 +1,60 @@
+#ifndef OBJC_OBJC_PROTOTYPES_H_
+#define OBJC_OBJC_PROTOTYPES_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <ida.hpp>
+#include <typeinf.hpp>
+#include "objc/objc_type_encoding.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//prototypes of the method implementations from their type encodings.
+	//they are collected while the method lists are renamed and applied
+	//by Commit once the run is walked,grouped by encoding so each declaration is parsed
+	//by ida once.types the user set are left alone
+	class PrototypeApplier
+	{
+	public:
+		PrototypeApplier(void);
+		~PrototypeApplier(void);
+		void Add(ea_t imp,const StringPiece& encoding);
+		//applies in address order within each encoding until get_nsec_stamp
+		//passes deadline and resumes there next time,a deadline of 0 applies
+		//everything.true once every prototype is applied
+		bool Commit(uint64 deadline);
+		void Clear();
+	private:
+		enum DeclarationState{
+			kUndeclared,
+			kDeclared,
+			//neither spelling parses,the til lacks a struct passed by value
+			kUndeclarable
+		};
+		struct Pending
+		{
+			ea_t ea;
+			uint32 signature;
+			bool operator<(const Pending& other) const{
+				return (signature!=other.signature)?signature<other.signature:ea<other.ea;
+			}
+		};
+		bool Declare(uint32 signature,tinfo_t* type);
+		TypeEncodingParser parser_;
+		std::vector<Pending> pending_;
+		std::string decl_;
+		uint32 malformed_;
+		//where Commit resumes,with the declaration of the signature there
+		size_t commit_index_;
+		tinfo_t type_;
+		DeclarationState state_;
+		uint32 applied_;
+		uint32 kept_;
+		uint32 undeclarable_;
+		uint32 declared_;
+		uint64 elapsed_;
+		DISALLOW_EVIL_CONSTRUCTORS(PrototypeApplier);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -4,415 +4,825 @@
 #include <auto.hpp>
 #include <struct.hpp>
 #include <algorithm>
+#include <funcs.hpp>
+#include <nalt.hpp>
+#include <bytes.hpp>
+#include <kernwin.hpp>
+#include <idp.hpp>
+#include "objc/objc_section.h"
+#include "objc/objc_msgsend.h"
 
 namespace objc{
-	ObjcRestore::ObjcRestore(void){
+	namespace{
+		//heads of an incremental run,the item at ea overlaps a changed range
+		class HeadInRanges
+		{
+		public:
+			explicit HeadInRanges(const DirtyRanges& ranges):ranges_(&ranges){}
+			bool operator()(uint64_t ea) const{
+				ea_t head = static_cast<ea_t>(ea);
+				return ranges_->Overlaps(head,get_item_end(head));
+			}
+		private:
+			const DirtyRanges* ranges_;
+		};
+		//overrides printed to the output window,the rest are only counted
+		const uint32 kReportedOverrides = 20;
+		//bytes compared to tell the slices of one cpu type apart,a whole
+		//mach_header_64
+		const size_t kComparedBytes = 32;
+		//whether the selected slice is the one that was loaded:its mach header
+		//is at the image base,or when the loader left the header out the
+		//first bytes of __text are the original bytes there
+		bool SliceIsLoaded(const MachoImage& image){
+			const MachoSegment* text = image.FindSegment("__TEXT");
+			const MachoSection* code = image.FindSection("__TEXT","__text");
+			const uint8* bytes = NULL;
+			ea_t ea = BADADDR;
+			size_t size = kComparedBytes;
+			if(text!=NULL&&text->fileoff==0&&isLoaded(static_cast<ea_t>(text->vmaddr))){
+				ea = static_cast<ea_t>(text->vmaddr);
+				bytes = image.AtOffset(0,size);
+			}
+			else if(code!=NULL){
+				size = (code->size<size)?static_cast<size_t>(code->size):size;
+				ea = static_cast<ea_t>(code->addr);
+				bytes = image.At(code->addr,size);
+			}
+			if(bytes==NULL||size==0){
+				return false;
+			}
+			for(size_t index=0;index<size;index++){
+				if(!isLoaded(ea+index)||get_original_byte(ea+index)!=bytes[index]){
+					return false;
+				}
+			}
+			return true;
+		}
+		//sets a flag for the length of a scope and puts the old value back
+		class ScopedFlag
+		{
+		public:
+			explicit ScopedFlag(bool* flag):flag_(flag),saved_(*flag){
+				*flag = true;
+			}
+			~ScopedFlag(void){
+				*flag_ = saved_;
+			}
+		private:
+			bool* flag_;
+			bool saved_;
+			DISALLOW_EVIL_CONSTRUCTORS(ScopedFlag);
+		};
+	}
+	ObjcRestore::ObjcRestore(void):run_(NULL),decoder_(NULL),pipeline_(NULL),walker_(NULL),restore_ranges_(NULL),commit_head_(BADADDR),applying_(false),restored_(false){
 	}
 	ObjcRestore::~ObjcRestore(void){
+		EndRestore(true);
+		delete decoder_;
 	}
-	void ObjcRestore::ClassSeg(){
-		segment_t* ea = get_segm_by_name("__class");
-		if(!ea){
-			return;
+	void ObjcRestore::RestoreSegments(){
+		if(BeginRestore(false)){
+			RunRestore();
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char name[1024] = {0};
-			if(get_name(BADADDR,start,name,1024)!=NULL){
-				const char ocn[] = "_objc_class_name_";
-				if(!strncmp(name,ocn,strlen(ocn))){
-					std::string new_rename(name+sizeof(ocn)-1);
-					set_name(start,new_rename.c_str());
-					std::string new_instance_vars_name = std::string("ivars_")+new_rename;
-					set_name(get_original_long(start+0x18),new_instance_vars_name.c_str());
-					std::string new_methods_name = std::string("methods_")+new_rename;
-					set_name(get_original_long(start+0x1C),new_methods_name.c_str());
-					RenameMethodMemberName(get_original_long(start+0x1C),new_rename);
-				}
+	}
+	void ObjcRestore::RestoreChanges(){
+		if(BeginRestore(true)){
+			RunRestore();
+		}
+	}
+	void ObjcRestore::RunRestore(){
+		for(;;){
+			uint32 step = StepRestore(0);
+			if(step==kRestoreDecode){
+				DecodeRestore();
+			}
+			else if(step==kRestoreDone){
+				break;
 			}
 		}
+		EndRestore(false);
 	}
-	void ObjcRestore::MetaClassSeg(){
-		segment_t* ea = get_segm_by_name("__meta_class");
-		if(!ea){
-			return;
+	void ObjcRestore::NoteChange(ea_t start,ea_t end){
+		//a first run that is still open counts as restored,its later slices
+		//may have overwritten what changed
+		if((restored_||run_!=NULL)&&!applying_){
+			dirty_.Add(start,end);
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char next_test[1024] = {0};
-			if(get_name(BADADDR,start,next_test,1024)!=NULL){
-				ea_t str = get_original_long(start+0x8);
-				std::string name = ObjcString::GetString(str,get_str_type(str));
-				std::string meta_class_name = std::string("MetaClass")+name;
-				if(!set_name(start,meta_class_name.c_str())){
-					RenameIncEA(start,"",meta_class_name);
-				}
-				std::string method_name = std::string("method_impl_")+name;
-				if(!set_name(get_original_long(start+0x1C),method_name.c_str())){
-					RenameIncEA(start,"",method_name);
-				}
-				RenameMethodMemberName(get_original_long(start+0x1C),name);
-			}
+	}
+	void ObjcRestore::NoteRename(ea_t ea,const char* name){
+		if((restored_||run_!=NULL)&&!applying_){
+			names_.NoteRename(ea,name);
+			dirty_.Add(ea,ea+1);
 		}
 	}
-	void ObjcRestore::NlSymbolPtrSeg(){
-		segment_t* ea = get_segm_by_name("__nl_symbol_ptr");
-		if(!ea){
-			return;
+	//everything one run owns,kept off the stack so a run can span many slices
+	struct ObjcRestore::RestoreRun
+	{
+		explicit RestoreRun(uint32 threads):walker(directory),pool(threads),pipeline(&pool),only(NULL),options(0),
+			commit_kind(0),commit_index(0),merge_node(0),merge_imported(0),merge_reported(0),decode_pending(false),
+			committing(false),walked(false),typing(false),merging(false),changes_only(false){}
+		SectionDirectory directory;
+		SectionWalker walker;
+		ThreadPool pool;
+		RestorePipeline pipeline;
+		//changed ranges of an incremental run or section blocks whose fingerprint changed
+		DirtyRanges ranges;
+		const DirtyRanges* only;
+		uint32 options;
+		uint32 commit_kind;
+		size_t commit_index;
+		//MergeCategories resumes at merge_node in the next slice
+		uint32 merge_node;
+		uint32 merge_imported;
+		uint32 merge_reported;
+		bool decode_pending;
+		bool committing;
+		//every section is walked,what is left works on the whole image
+		bool walked;
+		bool typing;
+		bool merging;
+		bool changes_only;
+	};
+	bool ObjcRestore::BeginRestore(bool changes_only){
+		if(run_!=NULL){
+			return false;
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char name[1024] = {0};
-			get_name(BADADDR,start,name,1024);
-			std::string message_refs_name = std::string("ptr_")+std::string(name);
-			if(set_name(start,message_refs_name.c_str())){
-				continue;
+		ScopedFlag applying(&applying_);
+		DirtyRanges ranges;
+		bool input_image = false;
+		if(changes_only){
+			if(dirty_.empty()){
+				msg("objc: nothing changed since the last run\n");
+				return false;
 			}
-			for(int i=0;i<100;i++){
-				char buf[1024] = {0};
-				_snprintf(buf,1024,"ptr_%s_%d",name,i);
-				message_refs_name.resize(0);
-				message_refs_name.append(buf);
-				if(set_name(start,message_refs_name.c_str())){
-					break;
-				}
+			//the changed ranges themselves plus every head that named or patched
+			//something inside them last time
+			ranges.Add(dirty_);
+			dependencies_.Collect(dirty_,&ranges);
+			dirty_.Clear();
+			msg("objc: reprocessing %u changed ranges\n",static_cast<uint32>(ranges.size()));
+			input_image = OpenInputImage();
+		}
+		else{
+			//cached images get their stripped names back before anything
+			//matches on them
+			input_image = OpenInputImage();
+			local_symbols_.Restore(input_image?&input_image_:NULL);
+			names_.Seed();
+			dirty_.Clear();
+		}
+		RestoreRun* run = new RestoreRun((decoder_!=NULL)?ThreadPool::DefaultThreadCount():1);
+		run->changes_only = changes_only;
+		run->directory.Build();
+		typedef MemberHeadVisitor<ObjcRestore> Visitor;
+		//objc1 images read from the input file are decoded by following
+		//__module_info -> symtab -> definitions,the sections holding them are
+		//only finished so they keep their fingerprints
+		bool objc1_chain = (decoder_!=NULL&&input_image_.FindSection("__OBJC","__module_info")!=NULL);
+		if(objc1_chain){
+			run->walker.RegisterFinish("__class",new Visitor(this,NULL));
+			run->walker.RegisterFinish("__meta_class",new Visitor(this,NULL));
+		}
+		else{
+			run->walker.Register("__class",new Visitor(this,&ObjcRestore::ClassSegHead));
+			run->walker.Register("__meta_class",new Visitor(this,&ObjcRestore::MetaClassSegHead));
+		}
+		run->walker.Register("__nl_symbol_ptr",new Visitor(this,&ObjcRestore::NlSymbolPtrSegHead));
+		run->walker.Register("__cls_refs",new Visitor(this,&ObjcRestore::ClsRefsSegHead));
+		if(objc1_chain){
+			run->walker.RegisterFinish("__category",new Visitor(this,NULL));
+		}
+		else{
+			run->walker.Register("__category",new Visitor(this,&ObjcRestore::CategorySegHead));
+		}
+		run->walker.Register("__message_refs",new Visitor(this,&ObjcRestore::MessageRefsSegHead));
+		run->walker.Register("__cfstring",new Visitor(this,&ObjcRestore::CFStringSegHead,&ObjcRestore::CFStringSegFinish));
+		if(objc1_chain){
+			run->walker.RegisterFinish("__module_info",new Visitor(this,NULL,&ObjcRestore::ModuleInfoSegObjc1Finish));
+			run->walker.RegisterFinish("__symbols",new Visitor(this,NULL));
+		}
+		else{
+			run->walker.Register("__module_info",new Visitor(this,&ObjcRestore::ModuleInfoSegHead));
+			run->walker.Register("__symbols",new Visitor(this,&ObjcRestore::SymbolsSegHead));
+		}
+		//the objc2 record layout is picked once here,the handlers are
+		//instantiated per layout.with the input image the heads are found
+		//from the objc lists,the data sections are only finished,not walked
+		if(decoder_!=NULL){
+			pipeline_ = &run->pipeline;
+			run->walker.RegisterFinish("__data",new Visitor(this,NULL,&ObjcRestore::DataSegObjc2Finish));
+			run->walker.RegisterFinish("__objc_data",new Visitor(this,NULL,&ObjcRestore::ObjcDataSegObjc2Finish));
+			run->walker.RegisterFinish("__objc_const",new Visitor(this,NULL,&ObjcRestore::ObjcConstSegObjc2Finish));
+		}
+		else{
+			if(inf.is_64bit()){
+				run->walker.Register("__data",new Visitor(this,&ObjcRestore::DataSegObjc2Head<Layout64>));
+				run->walker.Register("__objc_data",new Visitor(this,&ObjcRestore::ObjcDataSegObjc2Head<Layout64>));
+			}
+			else if(inf.mf){
+				run->walker.Register("__data",new Visitor(this,&ObjcRestore::DataSegObjc2Head<Layout32BE>));
+				run->walker.Register("__objc_data",new Visitor(this,&ObjcRestore::ObjcDataSegObjc2Head<Layout32BE>));
 			}
+			else{
+				run->walker.Register("__data",new Visitor(this,&ObjcRestore::DataSegObjc2Head<Layout32>));
+				run->walker.Register("__objc_data",new Visitor(this,&ObjcRestore::ObjcDataSegObjc2Head<Layout32>));
+			}
+			run->walker.Register("__objc_const",new Visitor(this,&ObjcRestore::ObjcConstSegObjc2Head));
+		}
+		run->options = (decoder_!=NULL)?AnalysisFingerprint::kOptionInputImage:0;
+		if(changes_only){
+			run->ranges.Add(ranges);
+			run->only = &run->ranges;
+		}
+		else if(fingerprint_.Load(run->options,&dependencies_)){
+			fingerprint_.Compute(run->directory,run->walker.section_names());
+			fingerprint_.ChangedSections(run->directory,&run->ranges);
+			if(run->ranges.empty()){
+				msg("objc: sections unchanged since they were restored\n");
+				delete run;
+				pipeline_ = NULL;
+				restored_ = true;
+				return false;
+			}
+			run->only = &run->ranges;
+		}
+		//a walk over everything sees every method list and every dependency
+		//again,a restricted one merges into what the indexes hold
+		if(run->only==NULL){
+			selector_index_.Clear();
+			dependencies_.Clear();
 		}
+		string_table_.Build(run->directory);
+		ObjcValidEA::BuildSegmentIntervals();
+		original_bytes_.Clear();
+		walker_ = &run->walker;
+		restore_ranges_ = run->only;
+		run->walker.Begin(run->only);
+		run_ = run;
+		return true;
 	}
-	void ObjcRestore::ClsRefsSeg(){
-		segment_t* ea = get_segm_by_name("__cls_refs");
-		if(!ea){
-			return;
+	uint32 ObjcRestore::StepRestore(uint32 budget_ms){
+		ScopedFlag applying(&applying_);
+		uint64 deadline = SectionWalker::kNoDeadline;
+		if(budget_ms!=0){
+			get_nsec_stamp(&deadline);
+			deadline += static_cast<uint64>(budget_ms)*1000000;
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char name[1024] = {0};
-			get_name(BADADDR,start,name,1024);
-			std::string message_refs_name = std::string("cls_")+std::string(name);
-			if(set_name(start,message_refs_name.c_str())){
+		for(;;){
+			if(run_->decode_pending){
+				return kRestoreDecode;
+			}
+			if(run_->committing){
+				if(!CommitPipeline(deadline)){
+					return kRestoreMore;
+				}
 				continue;
 			}
-			for(int i=0;i<100;i++){
-				char buf[1024] = {0};
-				_snprintf(buf,1024,"cls_%s_%d",name,i);
-				message_refs_name.resize(0);
-				message_refs_name.append(buf);
-				if(set_name(start,message_refs_name.c_str())){
-					break;
+			if(run_->typing){
+				if(!prototypes_.Commit(deadline)){
+					return kRestoreMore;
+				}
+				run_->typing = false;
+				if(decoder_!=NULL){
+					BeginMergeCategories();
 				}
+				continue;
 			}
-		}
-	}
-	void ObjcRestore::CategorySeg(){
-		segment_t* ea = get_segm_by_name("__category");
-		if(!ea){
-			return;
-		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char next_test[1024] = {0};
-			if(get_name(BADADDR,start,next_test,1024)!=NULL){
-				std::string category_name = ObjcString::GetString(get_original_long(start),get_str_type(get_original_long(start)));
-				std::string class_name = ObjcString::GetString(get_original_long(start+4),get_str_type(get_original_long(start+4)));
-				std::string cur_name = std::string(class_name)+std::string("_")+std::string(category_name);
-				if(!set_name(start,cur_name.c_str())){
-					RenameIncEA(start,"",cur_name.c_str());
+			if(run_->merging){
+				if(!MergeCategories(deadline)){
+					return kRestoreMore;
 				}
-				ea_t str = get_original_long(start+0x8);
-				std::string class_impl_name = std::string("method_impl_")+cur_name;
-				if(!set_name(str,class_impl_name.c_str())){
-					RenameIncEA(str,"",class_impl_name);
+				continue;
+			}
+			if(run_->walked){
+				return kRestoreDone;
+			}
+			if(run_->walker.Step(deadline)){
+				run_->walked = true;
+				run_->typing = true;
+				continue;
+			}
+			if(deadline!=SectionWalker::kNoDeadline){
+				uint64 now = 0;
+				get_nsec_stamp(&now);
+				if(now>=deadline){
+					return kRestoreMore;
 				}
-				RenameMethodMemberName(get_original_long(start+0x8),cur_name);
 			}
 		}
 	}
-	void ObjcRestore::MessageRefsSeg(){
-		segment_t* ea = get_segm_by_name("__message_refs");
-		if(!ea){
+	void ObjcRestore::DecodeRestore(){
+		//pure,reads the mapped input file only
+		run_->pipeline.Decode(*decoder_,run_->commit_kind);
+		run_->decode_pending = false;
+		run_->committing = true;
+		run_->commit_index = 0;
+	}
+	void ObjcRestore::EndRestore(bool cancelled){
+		RestoreRun* run = run_;
+		if(run==NULL){
 			return;
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char name[1024] = {0};
-			get_name(BADADDR,start,name,1024);
-			std::string message_refs_name = std::string("msg_")+std::string(name);
-			if(set_name(start,message_refs_name.c_str())){
-				continue;
+		ScopedFlag applying(&applying_);
+		run_ = NULL;
+		walker_ = NULL;
+		restore_ranges_ = NULL;
+		pipeline_ = NULL;
+		commit_head_ = BADADDR;
+		string_table_.Release();
+		ObjcValidEA::ReleaseSegmentIntervals();
+		if(cancelled){
+			//stored fingerprints are left alone so the next run redoes the
+			//sections,an incremental run gives its ranges back
+			if(run->changes_only){
+				dirty_.Add(run->ranges);
 			}
-			for(int i=0;i<100;i++){
-				char buf[1024] = {0};
-				_snprintf(buf,1024,"msg_%s_%d",name,i);
-				message_refs_name.resize(0);
-				message_refs_name.append(buf);
-				if(set_name(start,message_refs_name.c_str())){
-					break;
-				}
+			prototypes_.Clear();
+			msg("objc: restore cancelled\n");
+		}
+		else{
+			//hash what the passes left behind,their own patches included
+			fingerprint_.Compute(run->directory,run->walker.section_names());
+			fingerprint_.Store(run->options,dependencies_);
+			if(!run->changes_only){
+				restored_ = true;
 			}
 		}
+		selector_index_.Build();
+		msg("objc: %u selectors,%u implementations indexed\n",selector_index_.selector_count(),selector_index_.method_count());
+		msg("objc: %u type lookups served from cache,%u distinct types,%u printed\n",types_.hits(),types_.signatures(),types_.printed());
+		types_.Clear();
+		if(decoder_!=NULL){
+			msg("objc: decoded %u heads into %u records on %u threads\n",run->pipeline.decoded_heads(),run->pipeline.decoded_records(),run->pool.thread_count());
+		}
+		msg("objc: %u set_name calls,%u name collisions\n",names_.set_name_calls(),names_.collisions());
+		if(original_bytes_.reads()!=0){
+			msg("objc: %u original reads,%u from cached pages,%u kernel calls instead of %u\n",original_bytes_.reads(),
+				original_bytes_.hits(),original_bytes_.kernel_calls(),original_bytes_.reads());
+		}
+		original_bytes_.Clear();
+		delete run;
 	}
-	void ObjcRestore::CFStringSeg(){
-		segment_t* ea = get_segm_by_name("__cfstring");
-		if(!ea){
+	void ObjcRestore::ResolveMessageSends(){
+		if(!OpenInputImage()){
 			return;
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			std::string cfstring = GuessType(start);
-			if(!cfstring.find("__CFString")!=std::string::npos||!cfstring.find("__cfstring_struct")!=std::string::npos){
-				char name[1024] = {0};
-				if(get_name(BADADDR,start,name,1024)==NULL){
+		MessageSendResolver resolver(*decoder_);
+		resolver.Resolve();
+	}
+	void ObjcRestore::BeginMergeCategories(){
+		class_graph_.Clear();
+		decoder_->CollectClassGraph(&class_graph_);
+		class_graph_.Build();
+		run_->merge_node = 0;
+		run_->merge_imported = 0;
+		run_->merge_reported = 0;
+		run_->merging = true;
+	}
+	bool ObjcRestore::MergeCategories(uint64 deadline){
+		char existing[MAXSTR] = {0};
+		while(run_->merge_node<class_graph_.node_count()){
+			uint32 node = run_->merge_node++;
+			if((class_graph_.node(node).flags&ClassGraph::kImported)!=0){
+				run_->merge_imported++;
+			}
+			//a run of one selector starts with the method the runtime calls
+			const ClassGraph::Method* winner = NULL;
+			for(const ClassGraph::Method* it = class_graph_.methods_begin(node);it!=class_graph_.methods_end(node);++it){
+				if((it->flags&ClassGraph::kOverridden)==0){
+					winner = it;
 					continue;
 				}
-				std::string message_refs_name = std::string("cfs_")+std::string(name);
-				if(set_name(start,message_refs_name.c_str())){
-					continue;
+				string_buffer_.assign("overridden by ");
+				class_graph_.AppendMethodName(*winner,&string_buffer_);
+				func_t* func = get_func(static_cast<ea_t>(it->imp));
+				//a comment the user wrote is kept
+				if(func!=NULL&&get_cmt(func->startEA,false,existing,sizeof(existing))<=0){
+					set_cmt(func->startEA,string_buffer_.c_str(),false);
 				}
-				for(int i=0;i<100;i++){
-					char buf[1024] = {0};
-					_snprintf(buf,1024,"cfs_%s_%d",name,i);
-					message_refs_name.resize(0);
-					message_refs_name.append(buf);
-					if(set_name(start,message_refs_name.c_str())){
-						break;
-					}
+				if(run_->merge_reported++<kReportedOverrides){
+					name_buffer_.clear();
+					class_graph_.AppendMethodName(*winner,&name_buffer_);
+					name_buffer_.append(" overrides ");
+					class_graph_.AppendMethodName(*it,&name_buffer_);
+					msg("objc: %s\n",name_buffer_.c_str());
+				}
+			}
+			if(deadline!=SectionWalker::kNoDeadline){
+				uint64 now = 0;
+				get_nsec_stamp(&now);
+				if(now>=deadline&&run_->merge_node<class_graph_.node_count()){
+					return false;
 				}
 			}
 		}
-		analyze_area(ea->startEA,ea->endEA);
+		msg("objc: %u classes,%u of them from other images,%u methods merged,%u overridden by categories\n",
+			class_graph_.node_count(),run_->merge_imported,class_graph_.method_count(),class_graph_.overridden_count());
+		run_->merging = false;
+		return true;
 	}
-	void ObjcRestore::ModuleInfoSeg(){
-		segment_t* ea = get_segm_by_name("__module_info");
-		if(!ea){
-			return;
+	uint32 ObjcRestore::restore_progress() const{
+		return (run_!=NULL)?run_->walker.progress():1000;
+	}
+	bool ObjcRestore::AssignName(ea_t ea,const char* name){
+		Track(ea);
+		return names_.Assign(ea,name);
+	}
+	bool ObjcRestore::AssignPrefixedName(ea_t ea,const char* prefix,const char* name){
+		const char* current = (name!=NULL)?name:"";
+		//the head was named by an earlier run,prefixing it again would give
+		//msg_msg_ and the like
+		if(!strncmp(current,prefix,strlen(prefix))){
+			Track(ea);
+			return true;
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			std::string cfstring = GuessType(start);
-			if(!cfstring.find("__objc_module_info_struct")!=std::string::npos||!cfstring.find("__module_info_struct")!=std::string::npos){
-				uint32 orig = get_original_long(start+0xC);
-				char buf[1024] = {0};
-				_snprintf(buf,1024,"symtab_%x",orig);
-				if(orig!=0&&set_name(start,buf)){
-					continue;
-				}
+		name_buffer_.assign(prefix).append(current);
+		return AssignName(ea,name_buffer_);
+	}
+	void ObjcRestore::Track(ea_t target){
+		ea_t head = (commit_head_!=BADADDR)?commit_head_:((walker_!=NULL)?walker_->current_head():BADADDR);
+		dependencies_.Add(target,head);
+	}
+	void ObjcRestore::ClassSegHead(ea_t start,const char* name){
+		if(name!=NULL){
+			const char ocn[] = "_objc_class_name_";
+			if(!strncmp(name,ocn,strlen(ocn))){
+				std::string new_rename(name+sizeof(ocn)-1);
+				AssignName(start,new_rename);
+				std::string new_instance_vars_name = std::string("ivars_")+new_rename;
+				AssignName(original_bytes_.Read32(start+Objc1Layout::kClassIvars),new_instance_vars_name);
+				std::string new_methods_name = std::string("methods_")+new_rename;
+				AssignName(original_bytes_.Read32(start+Objc1Layout::kClassMethods),new_methods_name);
+				RenameMethodMemberName(original_bytes_.Read32(start+Objc1Layout::kClassMethods),new_rename,0);
 			}
 		}
 	}
-	void ObjcRestore::SymbolsSeg(){
-		segment_t* ea = get_segm_by_name("__symbols");
-		if(!ea){
-			return;
+	void ObjcRestore::MetaClassSegHead(ea_t start,const char* head_name){
+		if(head_name!=NULL){
+			ea_t str = original_bytes_.Read32(start+Objc1Layout::kClassName);
+			std::string name = ObjcString::GetString(str,get_str_type(str));
+			std::string meta_class_name = std::string("MetaClass")+name;
+			AssignName(start,meta_class_name);
+			std::string method_name = std::string("method_impl_")+name;
+			AssignName(original_bytes_.Read32(start+Objc1Layout::kClassMethods),method_name);
+			RenameMethodMemberName(original_bytes_.Read32(start+Objc1Layout::kClassMethods),name,RestoreRecord::kClassMethods);
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			std::string cfstring = GuessType(start);
-			if(!cfstring.find("__objc_symtab_struct")!=std::string::npos||!cfstring.find("__symtab_struct")!=std::string::npos){
-				ea_t symbols_addr = get_original_long(start+0xC);
-				char name[1024] = {0};
-				if(get_name(BADADDR,symbols_addr,name,1024)!=NULL){
-					char buf[1024] = {0};
-					_snprintf(buf,1024,"symtab_%s",name);
-					if(set_name(start,buf)){
-						continue;
-					}
-				}
-
+	}
+	void ObjcRestore::NlSymbolPtrSegHead(ea_t start,const char* head_name){
+		AssignPrefixedName(start,"ptr_",head_name);
+	}
+	void ObjcRestore::ClsRefsSegHead(ea_t start,const char* head_name){
+		AssignPrefixedName(start,"cls_",head_name);
+	}
+	void ObjcRestore::CategorySegHead(ea_t start,const char* name){
+		if(name!=NULL){
+			std::string category_name = ObjcString::GetString(original_bytes_.Read32(start+Objc1Layout::kCategoryName),get_str_type(original_bytes_.Read32(start+Objc1Layout::kCategoryName)));
+			std::string class_name = ObjcString::GetString(original_bytes_.Read32(start+Objc1Layout::kCategoryClassName),get_str_type(original_bytes_.Read32(start+Objc1Layout::kCategoryClassName)));
+			std::string cur_name = std::string(class_name)+std::string("_")+std::string(category_name);
+			AssignName(start,cur_name);
+			ea_t str = original_bytes_.Read32(start+Objc1Layout::kCategoryInstanceMethods);
+			std::string class_impl_name = std::string("method_impl_")+cur_name;
+			AssignName(str,class_impl_name);
+			RenameMethodMemberName(original_bytes_.Read32(start+Objc1Layout::kCategoryInstanceMethods),cur_name,0);
+		}
+	}
+	void ObjcRestore::MessageRefsSegHead(ea_t start,const char* head_name){
+		AssignPrefixedName(start,"msg_",head_name);
+	}
+	void ObjcRestore::CFStringSegHead(ea_t start,const char* name){
+		if(HeadHasType(start,kObjcTypeCFString)){
+			if(name==NULL){
+				return;
 			}
+			AssignPrefixedName(start,"cfs_",name);
 		}
 	}
-	void ObjcRestore::DataSegObjc2(){
-		segment_t* ea = get_segm_by_name("__data");
-		if(!ea){
+	void ObjcRestore::CFStringSegFinish(const segment_t* seg){
+		if(restore_ranges_==NULL){
+			analyze_area(seg->startEA,seg->endEA);
 			return;
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char name[1024] = {0};
-			if(get_name(BADADDR,start,name,1024)!=NULL){//__objc2_prot
-				const char prot_name[] = "_OBJC_PROTOCOL_$_";
-				if(!strncmp(name,prot_name,sizeof(prot_name)-1)){
-					std::string new_name(name+sizeof(prot_name)-1);
-					set_name(start,new_name.c_str());
-					if(ObjcValidEA::IsValidAddress(get_original_long(start+0x8))){
-						std::string inst_meths = new_name+std::string("_Protocol");
-						set_name(get_original_long(start+0x8),inst_meths.c_str());
-					}
-					if(ObjcValidEA::IsValidAddress(get_original_long(start+0xC))){
-						std::string inst_meths = new_name+std::string("_InstanceMethod");
-						set_name(get_original_long(start+0xC),inst_meths.c_str());
-					}
-					if(ObjcValidEA::IsValidAddress(get_original_long(start+0x10))){
-						std::string inst_meths = new_name+std::string("_ClassMethod");
-						set_name(get_original_long(start+0x10),inst_meths.c_str());
-					}
-					if(ObjcValidEA::IsValidAddress(get_original_long(start+0x14))){
-						std::string opt_inst_meths = new_name+std::string("_OptInstanceMethod");
-						set_name(get_original_long(start+0x14),opt_inst_meths.c_str());
-					}
-					if(ObjcValidEA::IsValidAddress(get_original_long(start+0x18))){
-						std::string opt_inst_meths = new_name+std::string("_OptClassMethod");
-						set_name(get_original_long(start+0x18),opt_inst_meths.c_str());
-					}
-				}
+		for(DirtyRanges::const_iterator it = restore_ranges_->begin();it!=restore_ranges_->end();++it){
+			ea_t start = (it->first>seg->startEA)?it->first:seg->startEA;
+			ea_t end = (it->second<seg->endEA)?it->second:seg->endEA;
+			if(start<end){
+				analyze_area(start,end);
 			}
 		}
 	}
-	void ObjcRestore::ObjcDataSegObjc2(){
-		segment_t* ea = get_segm_by_name("__objc_data");
-		if(!ea){
-			return;
+	void ObjcRestore::ModuleInfoSegHead(ea_t start,const char* name){
+		if(HeadHasType(start,kObjcTypeModuleInfo)){
+			uint32 orig = original_bytes_.Read32(start+Objc1Layout::kModuleSymtab);
+			char buf[1024] = {0};
+			_snprintf(buf,1024,"symtab_%x",orig);
+			if(orig!=0){
+				AssignName(start,buf);
+			}
 		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
+	}
+	void ObjcRestore::SymbolsSegHead(ea_t start,const char* head_name){
+		if(HeadHasType(start,kObjcTypeSymtab)){
+			ea_t symbols_addr = original_bytes_.Read32(start+Objc1Layout::kSymtabDefs);
+			Track(symbols_addr);
 			char name[1024] = {0};
-			if(get_name(BADADDR,start,name,1024)!=NULL){//__objc2_prot
-				const char meta_class[] = "_OBJC_METACLASS_$_";
-				const char objc_class[] = "_OBJC_CLASS_$_";
-				if(!strncmp(name,meta_class,sizeof(meta_class)-1)){
-					std::string meta_class_name(std::string("metaclass_")+std::string(name+sizeof(meta_class)-1));
-					if(!set_name(start,meta_class_name.c_str(),SN_NOWARN|SN_CHECK)){
-						RenameIncEA(start,"",meta_class_name);
-					}
-					if(ObjcValidEA::IsValidAddress(get_original_long(start+0x10))){
-						std::string meta_data_name(std::string("metadata_")+std::string(name+sizeof(meta_class)-1));
-						if(!set_name(get_original_long(start+0x10),meta_data_name.c_str(),SN_NOWARN|SN_CHECK)){
-							RenameIncEA(get_original_long(start+0x10),"",meta_data_name);
-						}
-					}
+			if(get_name(BADADDR,symbols_addr,name,1024)!=NULL){
+				char buf[1024] = {0};
+				_snprintf(buf,1024,"symtab_%s",name);
+				AssignName(start,buf);
+			}
+		}
+	}
+	template<typename Layout>
+	void ObjcRestore::DataSegObjc2Head(ea_t start,const char* name){
+		if(name!=NULL){//__objc2_prot
+			const char prot_name[] = "_OBJC_PROTOCOL_$_";
+			if(!strncmp(name,prot_name,sizeof(prot_name)-1)){
+				std::string new_name(name+sizeof(prot_name)-1);
+				AssignName(start,new_name);
+				ea_t protocols = GetOriginalPointer<Layout>(start+Layout::kProtocolProtocols);
+				if(ObjcValidEA::IsValidAddress(protocols)){
+					std::string inst_meths = new_name+std::string("_Protocol");
+					AssignName(protocols,inst_meths);
 				}
-				else if(!strncmp(name,objc_class,sizeof(objc_class)-1)){
-					std::string class_name(std::string(name+sizeof(objc_class)-1));
-					if(!set_name(start,class_name.c_str(),SN_NOWARN|SN_CHECK)){
-						RenameIncEA(start,"",class_name);
-					}
-					if(ObjcValidEA::IsValidAddress(get_original_long(start+0x10))){
-						std::string meta_data_name(std::string("classdata_")+std::string(name+sizeof(meta_class)-1));
-						if(!set_name(get_original_long(start+0x10),meta_data_name.c_str(),SN_NOWARN|SN_CHECK)){
-							RenameIncEA(get_original_long(start+0x10),"",meta_data_name);
-						}
-					}
+				ea_t instance_methods = GetOriginalPointer<Layout>(start+Layout::kProtocolInstanceMethods);
+				if(ObjcValidEA::IsValidAddress(instance_methods)){
+					std::string inst_meths = new_name+std::string("_InstanceMethod");
+					AssignName(instance_methods,inst_meths);
+				}
+				ea_t class_methods = GetOriginalPointer<Layout>(start+Layout::kProtocolClassMethods);
+				if(ObjcValidEA::IsValidAddress(class_methods)){
+					std::string inst_meths = new_name+std::string("_ClassMethod");
+					AssignName(class_methods,inst_meths);
+				}
+				ea_t opt_instance_methods = GetOriginalPointer<Layout>(start+Layout::kProtocolOptInstanceMethods);
+				if(ObjcValidEA::IsValidAddress(opt_instance_methods)){
+					std::string opt_inst_meths = new_name+std::string("_OptInstanceMethod");
+					AssignName(opt_instance_methods,opt_inst_meths);
+				}
+				ea_t opt_class_methods = GetOriginalPointer<Layout>(start+Layout::kProtocolOptClassMethods);
+				if(ObjcValidEA::IsValidAddress(opt_class_methods)){
+					std::string opt_inst_meths = new_name+std::string("_OptClassMethod");
+					AssignName(opt_class_methods,opt_inst_meths);
 				}
 			}
 		}
 	}
-	void ObjcRestore::ObjcConstSegObjc2(){
-		segment_t* ea = get_segm_by_name("__objc_const");
-		if(!ea){
-			return;
-		}
-		ea_t start = ea->startEA;
-		ea_t end = ea->endEA;
-		for(;start!=BADADDR;start = next_head(start,end)){
-			char name[1024] = {0};
-			if(get_name(BADADDR,start,name,1024)!=NULL){
-				const char objc_instance_methods[] = "_OBJC_INSTANCE_METHODS_";
-				const char objc_instance_variables[] = "_OBJC_INSTANCE_VARIABLES_";
-				const char objc_class_methods[] = "_OBJC_CLASS_METHODS_";
-				const char objc_category_instance_methods[] = "_OBJC_CATEGORY_INSTANCE_METHODS_";
-				const char objc_category_class_methods[] = "_OBJC_CATEGORY_CLASS_METHODS_";
-				if(!strncmp(name,objc_instance_methods,sizeof(objc_instance_methods)-1)){
-					std::string class_name = std::string(name+sizeof(objc_instance_methods)-1);
-					RenameMethodMemberName(start,class_name);
-					std::string method_name = std::string("instance_impl_")+class_name;
-					if(set_name(start,method_name.c_str(),SN_NOWARN|SN_CHECK)){
-						RenameIncEA(start,"",method_name);
-					}
+	template<typename Layout>
+	void ObjcRestore::ObjcDataSegObjc2Head(ea_t start,const char* name){
+		if(name!=NULL){//__objc2_class
+			const char meta_class[] = "_OBJC_METACLASS_$_";
+			const char objc_class[] = "_OBJC_CLASS_$_";
+			if(!strncmp(name,meta_class,sizeof(meta_class)-1)){
+				std::string meta_class_name(std::string("metaclass_")+std::string(name+sizeof(meta_class)-1));
+				AssignName(start,meta_class_name);
+				ea_t class_data = static_cast<ea_t>(GetOriginalPointer<Layout>(start+Layout::kClassData)&Layout::ClassDataMask());
+				if(ObjcValidEA::IsValidAddress(class_data)){
+					std::string meta_data_name(std::string("metadata_")+std::string(name+sizeof(meta_class)-1));
+					AssignName(class_data,meta_data_name);
 				}
-				else if(!strncmp(name,objc_class_methods,sizeof(objc_class_methods)-1)){
-					std::string class_name = std::string(name+sizeof(objc_class_methods)-1);
-					RenameMethodMemberName(start,class_name);
-					std::string method_name = std::string("class_impl_")+class_name;
-					if(set_name(start,method_name.c_str(),SN_NOWARN|SN_CHECK)){
-						RenameIncEA(start,"",method_name);
-					}
+			}
+			else if(!strncmp(name,objc_class,sizeof(objc_class)-1)){
+				std::string class_name(std::string(name+sizeof(objc_class)-1));
+				AssignName(start,class_name);
+				ea_t class_data = static_cast<ea_t>(GetOriginalPointer<Layout>(start+Layout::kClassData)&Layout::ClassDataMask());
+				if(ObjcValidEA::IsValidAddress(class_data)){
+					std::string meta_data_name(std::string("classdata_")+std::string(name+sizeof(objc_class)-1));
+					AssignName(class_data,meta_data_name);
 				}
-				else if(!strncmp(name,objc_category_instance_methods,sizeof(objc_category_instance_methods)-1)){
-					std::string class_name = std::string(name+sizeof(objc_category_instance_methods)-1);
-					RenameMethodMemberName(start,class_name);
-					class_name = ObjcString::ReplaceAll(class_name,"_$_","::");
-					std::string method_name = std::string("category_impl_")+class_name;
-					if(set_name(start,method_name.c_str(),SN_NOWARN|SN_CHECK)){
-						RenameIncEA(start,"",method_name);
-					}
+			}
+		}
+	}
+	void ObjcRestore::ObjcConstSegObjc2Head(ea_t start,const char* name){
+		if(name!=NULL){
+			const char objc_instance_methods[] = "_OBJC_INSTANCE_METHODS_";
+			const char objc_instance_variables[] = "_OBJC_INSTANCE_VARIABLES_";
+			const char objc_class_methods[] = "_OBJC_CLASS_METHODS_";
+			const char objc_category_instance_methods[] = "_OBJC_CATEGORY_INSTANCE_METHODS_";
+			const char objc_category_class_methods[] = "_OBJC_CATEGORY_CLASS_METHODS_";
+			if(!strncmp(name,objc_instance_methods,sizeof(objc_instance_methods)-1)){
+				std::string class_name = std::string(name+sizeof(objc_instance_methods)-1);
+				RenameMethodMemberName(start,class_name,0);
+				std::string method_name = std::string("instance_impl_")+class_name;
+				AssignName(start,method_name);
+			}
+			else if(!strncmp(name,objc_class_methods,sizeof(objc_class_methods)-1)){
+				std::string class_name = std::string(name+sizeof(objc_class_methods)-1);
+				RenameMethodMemberName(start,class_name,RestoreRecord::kClassMethods);
+				std::string method_name = std::string("class_impl_")+class_name;
+				AssignName(start,method_name);
+			}
+			else if(!strncmp(name,objc_category_instance_methods,sizeof(objc_category_instance_methods)-1)){
+				std::string class_name = std::string(name+sizeof(objc_category_instance_methods)-1);
+				RenameMethodMemberName(start,class_name,0);
+				class_name = ObjcString::ReplaceAll(class_name,"_$_","::");
+				std::string method_name = std::string("category_impl_")+class_name;
+				AssignName(start,method_name);
+			}
+			else if(!strncmp(name,objc_category_class_methods,sizeof(objc_category_class_methods)-1)){
+				std::string class_name = std::string(name+sizeof(objc_category_class_methods)-1);
+				RenameMethodMemberName(start,class_name,RestoreRecord::kClassMethods);
+				class_name = ObjcString::ReplaceAll(class_name,"_$_","::");
+				std::string method_name = std::string("category_impl_")+class_name;
+				AssignName(start,method_name);
+			}
+			else if(!strncmp(name,objc_instance_variables,sizeof(objc_instance_variables)-1)){
+				std::string ivars_name(std::string("ivars_")+std::string(name+sizeof(objc_instance_variables)-1));
+				AssignName(start,ivars_name);
+			}
+		}
+	}
+	void ObjcRestore::DataSegObjc2Finish(const segment_t* seg){
+		QueuePipeline(kObjc2ProtocolHead);
+	}
+	void ObjcRestore::ObjcDataSegObjc2Finish(const segment_t* seg){
+		QueuePipeline(kObjc2ClassHead);
+	}
+	void ObjcRestore::ObjcConstSegObjc2Finish(const segment_t* seg){
+		QueuePipeline(kObjc2ConstHead);
+	}
+	void ObjcRestore::ModuleInfoSegObjc1Finish(const segment_t* seg){
+		QueuePipeline(kObjc1ModuleHead);
+	}
+	void ObjcRestore::QueuePipeline(uint32 kind){
+		//named from the strings the metadata points at,so stripped images
+		//are restored too and only the metadata itself is read
+		decoder_->CollectHeads(kind,pipeline_);
+		if(restore_ranges_!=NULL){
+			pipeline_->Filter(HeadInRanges(*restore_ranges_));
+		}
+		//the walker returns after finishing a section,StepRestore then asks
+		//for the heads to be decoded before it commits them
+		run_->commit_kind = kind;
+		run_->decode_pending = true;
+	}
+	bool ObjcRestore::CommitPipeline(uint64 deadline){
+		//decoding is pure and ran on the pool,the database is only touched
+		//here on the ui thread,head by head in address order
+		const std::vector<RestoreWork>& work = run_->pipeline.work();
+		while(run_->commit_index<work.size()){
+			const RestoreWork& head = work[run_->commit_index++];
+			commit_head_ = static_cast<ea_t>(head.ea);
+			ApplyRecords(head);
+			commit_head_ = BADADDR;
+			if(deadline!=SectionWalker::kNoDeadline){
+				uint64 now = 0;
+				get_nsec_stamp(&now);
+				if(now>=deadline&&run_->commit_index<work.size()){
+					return false;
 				}
-				else if(!strncmp(name,objc_category_class_methods,sizeof(objc_category_class_methods)-1)){
-					std::string class_name = std::string(name+sizeof(objc_category_class_methods)-1);
-					RenameMethodMemberName(start,class_name);
-					class_name = ObjcString::ReplaceAll(class_name,"_$_","::");
-					std::string method_name = std::string("category_impl_")+class_name;
-					if(set_name(start,method_name.c_str(),SN_NOWARN|SN_CHECK)){
-						RenameIncEA(start,"",method_name);
-					}
+			}
+		}
+		run_->pipeline.Clear();
+		run_->committing = false;
+		return true;
+	}
+	void ObjcRestore::ApplyRecords(const RestoreWork& work){
+		for(RestoreRecords::const_iterator it = work.records.begin();it!=work.records.end();++it){
+			ea_t ea = static_cast<ea_t>(it->ea);
+			const char* name = work.RecordName(*it);
+			switch(it->kind){
+			case RestoreRecord::kRename:
+				AssignName(ea,name);
+				break;
+			case RestoreRecord::kRenamePointee:
+				if(ObjcValidEA::IsValidAddress(ea)){
+					AssignName(ea,name);
 				}
-				else if(!strncmp(name,objc_instance_variables,sizeof(objc_instance_variables)-1)){
-					std::string ivars_name(std::string("ivars_")+std::string(name+sizeof(objc_instance_variables)-1));
-					if(!set_name(start,ivars_name.c_str(),SN_NOWARN|SN_CHECK)){
-						RenameIncEA(start,"",ivars_name);
+				break;
+			case RestoreRecord::kMethodImp:{
+					ea_t start = RenameMethodImp((it->slot!=RestoreRecord::kNoSlot)?static_cast<ea_t>(it->slot):BADADDR,ea,name);
+					if(start!=BADADDR&&it->selector!=RestoreRecord::kNoName){
+						IndexMethod(work.names.c_str()+it->owner,work.names.c_str()+it->selector,start,it->flags);
+					}
+					if(start!=BADADDR&&it->types!=RestoreRecord::kNoName){
+						prototypes_.Add(start,work.names.c_str()+it->types);
 					}
 				}
+				break;
+			case RestoreRecord::kLegacyMethodList:
+				RenameObjc1MethodList(ea,name,it->flags);
+				break;
 			}
 		}
 	}
-	std::string ObjcRestore::GuessType(uint32 ea){
-		char buf[MAXSTR] = {0};
-		print_type(ea,buf,MAXSTR,0);
-		if(buf != NULL && *buf != '\0'){
-			std::string result((const char*)buf);
-			return result;
-		}
-		type_t * types = new type_t [MAXSTR];
-		p_list * fields = new p_list [MAXSTR];
-		guess_type(ea,types,MAXSTR,fields,MAXSTR);
-		set_ti(ea,types,fields);
-		std::string result((const char*)types);
-		delete[] types;
-		delete[] fields;
-		return result;
+	bool ObjcRestore::HeadHasType(ea_t ea,uint32 type){
+		//heads ida cannot type at all are handled as if they matched
+		uint32 id = types_.Classify(ea);
+		return (id==type||id==kObjcTypeUnknown);
 	}
 	
-	void ObjcRestore::RenameMethodMemberName(uint32 ea,const std::string& class_name){
-		//__objc2_meth
-		uint32 method_number = get_original_long(ea+0x4);
-		ea_t start = ea+0x8;
+	bool ObjcRestore::OpenInputImage(){
+		if(decoder_!=NULL){
+			return true;
+		}
+		char path[QMAXPATH] = {0};
+		if(get_input_file_path(path,QMAXPATH)<=0||!input_file_.Open(path)){
+			msg("objc: input file is not available,reading metadata from the database\n");
+			return false;
+		}
+		//the file at the input path may have been rebuilt since it was loaded
+		uint32 crc = retrieve_input_file_crc32();
+		if(crc!=0&&calc_crc32(0,input_file_.data(),input_file_.size())!=crc){
+			msg("objc: %s is not the file the database was built from,reading metadata from the database\n",path);
+			input_file_.Close();
+			return false;
+		}
+		if(!input_image_.Parse(input_file_.data(),input_file_.size())){
+			input_file_.Close();
+			return false;
+		}
+		if(!SelectLoadedSlice()){
+			msg("objc: no slice of %s matches the database,reading metadata from the database\n",path);
+			input_file_.Close();
+			return false;
+		}
+		decoder_ = CreateHeadDecoder(input_image_);
+		return true;
+	}
+	bool ObjcRestore::SelectLoadedSlice(){
+		uint32 cputype = 0;
+		if(ph.id==PLFM_386){
+			cputype = inf.is_64bit()?MachoImage::kCpuTypeX86_64:MachoImage::kCpuTypeX86;
+		}
+		else if(ph.id==PLFM_ARM){
+			cputype = inf.is_64bit()?MachoImage::kCpuTypeArm64:MachoImage::kCpuTypeArm;
+		}
+		//the checksum already vouches for a thin file
+		if(input_image_.slices().size()==1){
+			return cputype==0||input_image_.cputype()==cputype;
+		}
+		//a fat input file holds several slices,armv7 and armv7s or arm64 and
+		//arm64e share a cpu type and differ in the subtype the header holds
+		for(size_t index=0;index<input_image_.slices().size();index++){
+			if(input_image_.SelectSlice(index)&&(cputype==0||input_image_.cputype()==cputype)&&SliceIsLoaded(input_image_)){
+				return true;
+			}
+		}
+		return false;
+	}
+	void ObjcRestore::RenameMethodMemberName(uint32 ea,const std::string& class_name,uint32 flags){
+		//__objc2_meth,decoded straight from the mapped input file.objc1 method
+		//lists share the count/entries offsets but carry no entsize,they go
+		//through the database below
+		if(decoder_!=NULL){
+			method_work_.Clear();
+			if(decoder_->DecodeMethodList(ea,class_name,flags,&method_work_)){
+				ApplyRecords(method_work_);
+				return;
+			}
+		}
+		RenameObjc1MethodList(ea,class_name,flags);
+	}
+	void ObjcRestore::RenameObjc1MethodList(uint32 ea,const std::string& class_name,uint32 flags){
+		uint32 method_number = original_bytes_.Read32(ea+Objc1Layout::kMethodListCount);
+		ea_t start = ea+Objc1Layout::kMethodListEntries;
 		//msg("method number:%d start offset:%x\r\n",method_number,start);
 		if(method_number==-1||!ObjcValidEA::IsValidAddress(start)){
 			return;
 		}
-		const std::string new_class_name = ObjcString::ReplaceAll(class_name,"_$_","::");
 		for(uint32 index=0;index<method_number;index++){
-			std::string func_name = ObjcString::GetString(get_original_long(start),get_str_type(get_original_long(start)));
-			std::replace(func_name.begin(),func_name.end(),':','_');
-			func_name = ObjcString::ReplaceAll(func_name,"_$_","::");
-			std::string new_func_name = new_class_name+std::string("::")+func_name;
-			func_t* func = get_func(get_original_long(start+0x8));
-			if(func!=NULL){
-				if(!set_name(func->startEA,new_func_name.c_str(),SN_NOWARN|SN_CHECK)){
-					RenameIncEA(func->startEA,"",new_func_name);
+			ea_t name_ea = original_bytes_.Read32(start+Objc1Layout::kMethodName);
+			StringPiece func_name = ObjcString::GetStringPiece(name_ea,get_str_type(name_ea),&string_buffer_);
+			name_buffer_.clear();
+			NameWriter(&name_buffer_).AppendCategoryName(class_name).Append("::").AppendSelector(func_name);
+			ea_t imp = RenameMethodImp(start+Objc1Layout::kMethodImp,original_bytes_.Read32(start+Objc1Layout::kMethodImp),name_buffer_.c_str());
+			if(imp!=BADADDR){
+				IndexMethod(class_name,func_name,imp,flags);
+				ea_t types_ea = original_bytes_.Read32(start+Objc1Layout::kMethodTypes);
+				if(ObjcValidEA::IsValidAddress(types_ea)){
+					prototypes_.Add(imp,ObjcString::GetStringPiece(types_ea,ASCSTR_C,&encoding_buffer_));
 				}
-				patch_long(start+0x8,func->startEA);
 			}
-			start += (sizeof(ea_t)*3);
+			start += Objc1Layout::kMethodSize;
 		}
 	}
-	void ObjcRestore::RenameIncEA(uint32 ea,const std::string& symb,const std::string& name){
-		for(int i=0;;i++){
-			char buf[1024] = {0};
-			_snprintf(buf,1024,"%s%s_%d",symb.c_str(),name.c_str(),i);
-			if(set_name(ea,buf,SN_NOWARN|SN_CHECK)){
-				break;
-			}
+	template<typename Layout>
+	ea_t ObjcRestore::GetOriginalPointer(ea_t ea){
+		if(Layout::kPtrSize==4){
+			return static_cast<ea_t>(original_bytes_.Read32(ea));
 		}
+		uint64 low = original_bytes_.Read32(Layout::kBigEndian?ea+4:ea);
+		uint64 high = original_bytes_.Read32(Layout::kBigEndian?ea:ea+4);
+		return static_cast<ea_t>((high<<32)|low);
+	}
+	ea_t ObjcRestore::RenameMethodImp(ea_t imp_slot,ea_t imp,const char* func_name){
+		Track(imp);
+		//imps outside of code are garbage or bound from another image
+		if(!ObjcValidEA::IsAddressIn(imp,SegmentIntervals::kAddressCode|SegmentIntervals::kAddressExec)){
+			return BADADDR;
+		}
+		func_t* func = get_func(imp);
+		if(func==NULL){
+			return BADADDR;
+		}
+		AssignName(func->startEA,func_name);
+		if(imp_slot!=BADADDR){
+			original_bytes_.Patch32(imp_slot,func->startEA);
+		}
+		return func->startEA;
+	}
+	void ObjcRestore::IndexMethod(const StringPiece& owner,const StringPiece& selector,ea_t imp,uint32 flags){
+		selector_index_.Add(owner,selector,imp,((flags&RestoreRecord::kClassMethods)!=0)?uint32(SelectorIndex::kClassMethod):0);
 	}
 }
\ No newline at end of file
@@ -5,6 +5,18 @@
 #include <string>
 #include "objc/objc_string.h"
 #include "objc/obj_valid_ea.h"
+#include "objc/objc_section.h"
+#include "objc/macho_image.h"
+#include "objc/objc2_parser.h"
+#include "objc/objc_layout.h"
+#include "objc/objc_name_allocator.h"
+#include "objc/objc_pipeline.h"
+#include "objc/objc_type_cache.h"
+#include "objc/objc_dirty_ranges.h"
+#include "objc/objc_fingerprint.h"
+#include "objc/objc_local_symbols.h"
+#include "objc/objc_selector_index.h"
+#include "objc/objc_prototypes.h"
 //////////////////////////////////////////////////////////////////////////
 namespace objc{
 	class ObjcRestore:private ObjcString,ObjcValidEA
@@ -12,23 +24,128 @@ namespace objc{
 	public:
 		ObjcRestore(void);
 		~ObjcRestore(void);
-		void ClassSeg();
-		void MetaClassSeg();
-		void NlSymbolPtrSeg();
-		void ClsRefsSeg();
-		void CategorySeg();
-		void MessageRefsSeg();
-		void CFStringSeg();
-		void ModuleInfoSeg();
-		void SymbolsSeg();
-		void DataSegObjc2();
-		void ObjcDataSegObjc2();
-		void ObjcConstSegObjc2();
+		enum RestoreStep{
+			kRestoreDone,
+			kRestoreMore,
+			//the heads of a finished section must be decoded before the next step
+			kRestoreDecode
+		};
+		void RestoreSegments();
+		//reprocesses only the heads affected by changes noted since the last run
+		void RestoreChanges();
+		//the two above in slices.BeginRestore,StepRestore and EndRestore run on
+		//the ui thread,DecodeRestore does not touch the database and may run on
+		//any thread.a budget of 0 steps until the run is done
+		bool BeginRestore(bool changes_only);
+		uint32 StepRestore(uint32 budget_ms);
+		void DecodeRestore();
+		void EndRestore(bool cancelled);
+		bool restore_open() const{
+			return run_!=NULL;
+		}
+		//per mille of the open run
+		uint32 restore_progress() const;
+		//database change notifications,ignored while a slice of a run applies
+		//its own changes
+		void NoteChange(ea_t start,ea_t end);
+		void NoteRename(ea_t ea,const char* name);
+		//call xrefs from every objc_msgSend site to the implementations of
+		//its selector,needs the input file
+		void ResolveMessageSends();
+		//implementations of every selector seen by the method list renames,
+		//complete after the first full run
+		const SelectorIndex& selector_index() const{
+			return selector_index_;
+		}
+		//classes with their categories merged,rebuilt once every section of a
+		//run on the input image is walked
+		const ClassGraph& class_graph() const{
+			return class_graph_;
+		}
+		bool restored() const{
+			return restored_;
+		}
 	protected:
-		std::string GuessType(uint32 ea);
+		bool HeadHasType(ea_t ea,uint32 type);
 	private:
-		void RenameMethodMemberName(uint32 ea,const std::string& class_name);
-		void RenameIncEA(uint32 ea,const std::string& symb,const std::string& name);
+		struct RestoreRun;
+		void RunRestore();
+		bool AssignName(ea_t ea,const char* name);
+		bool AssignName(ea_t ea,const std::string& name){
+			return AssignName(ea,name.c_str());
+		}
+		//prefix followed by the current name of the head,left alone when the
+		//name has the prefix already
+		bool AssignPrefixedName(ea_t ea,const char* prefix,const char* name);
+		//remembers that the current head touched target
+		void Track(ea_t target);
+		void ClassSegHead(ea_t start,const char* name);
+		void MetaClassSegHead(ea_t start,const char* name);
+		void NlSymbolPtrSegHead(ea_t start,const char* name);
+		void ClsRefsSegHead(ea_t start,const char* name);
+		void CategorySegHead(ea_t start,const char* name);
+		void MessageRefsSegHead(ea_t start,const char* name);
+		void CFStringSegHead(ea_t start,const char* name);
+		void CFStringSegFinish(const segment_t* seg);
+		void ModuleInfoSegHead(ea_t start,const char* name);
+		void SymbolsSegHead(ea_t start,const char* name);
+		template<typename Layout> void DataSegObjc2Head(ea_t start,const char* name);
+		template<typename Layout> void ObjcDataSegObjc2Head(ea_t start,const char* name);
+		void ObjcConstSegObjc2Head(ea_t start,const char* name);
+		//objc2 sections when the input image is mapped:heads are collected,
+		//decoded on the pool and applied when the section is finished
+		void DataSegObjc2Finish(const segment_t* seg);
+		void ObjcDataSegObjc2Finish(const segment_t* seg);
+		void ObjcConstSegObjc2Finish(const segment_t* seg);
+		void ModuleInfoSegObjc1Finish(const segment_t* seg);
+		void QueuePipeline(uint32 kind);
+		//false when deadline passed before every decoded head was applied
+		bool CommitPipeline(uint64 deadline);
+		void ApplyRecords(const RestoreWork& work);
+		//maps the input file once it is known to be the one the database was
+		//built from
+		bool OpenInputImage();
+		//the slice of the input file that was loaded,false when none matches
+		bool SelectLoadedSlice();
+		template<typename Layout> ea_t GetOriginalPointer(ea_t ea);
+		//flags are the RestoreRecord flags of the list
+		void RenameMethodMemberName(uint32 ea,const std::string& class_name,uint32 flags);
+		void RenameObjc1MethodList(uint32 ea,const std::string& class_name,uint32 flags);
+		//start of the renamed function,BADADDR if imp is not in one
+		ea_t RenameMethodImp(ea_t imp_slot,ea_t imp,const char* func_name);
+		void IndexMethod(const StringPiece& owner,const StringPiece& selector,ea_t imp,uint32 flags);
+		//attaches the categories to their classes,then comments the methods
+		//they override class by class.false when deadline passed first
+		void BeginMergeCategories();
+		bool MergeCategories(uint64 deadline);
+		RestoreRun* run_;
+		MappedFile input_file_;
+		MachoImage input_image_;
+		HeadDecoder* decoder_;
+		RestorePipeline* pipeline_;
+		//reused for every method list outside the pipeline
+		RestoreWork method_work_;
+		std::string name_buffer_;
+		std::string string_buffer_;
+		std::string encoding_buffer_;
+		NameAllocator names_;
+		TypeCache types_;
+		DirtyRanges dirty_;
+		DependencyIndex dependencies_;
+		AnalysisFingerprint fingerprint_;
+		LocalSymbolRestore local_symbols_;
+		SelectorIndex selector_index_;
+		ClassGraph class_graph_;
+		//typed in slices once every section of a run is walked
+		PrototypeApplier prototypes_;
+		//set for the duration of a run
+		const SectionWalker* walker_;
+		const DirtyRanges* restore_ranges_;
+		ea_t commit_head_;
+		//set while a slice of the run changes the database,what the user
+		//does between two slices is still noted
+		bool applying_;
+		bool restored_;
 		DISALLOW_EVIL_CONSTRUCTORS(ObjcRestore);
 	};
 }
@@ -0,0 +1,223 @@
+#include "objc/objc_section.h"
+#include <ida.hpp>
+#include <bytes.hpp>
+#include <name.hpp>
+#include <kernwin.hpp>
+
+namespace objc{
+	SectionDirectory::SectionDirectory(void):api_calls_(0){
+	}
+	SectionDirectory::~SectionDirectory(void){
+	}
+	void SectionDirectory::Build(){
+		sections_.clear();
+		int seg_num = get_segm_qty();
+		api_calls_ = 1;
+		for(int index=0;index<seg_num;index++){
+			segment_t* seg = getnseg(index);
+			api_calls_++;
+			if(seg==NULL){
+				continue;
+			}
+			char seg_name[1024] = {0};
+			api_calls_++;
+			if(get_true_segm_name(seg,seg_name,1024)<=0){
+				continue;
+			}
+			//get_segm_by_name returns the first match,keep that behaviour
+			if(sections_.find(seg_name)==sections_.end()){
+				sections_[seg_name] = seg->startEA;
+			}
+		}
+	}
+	segment_t* SectionDirectory::Find(const std::string& name) const{
+		std::map<std::string,ea_t>::const_iterator it = sections_.find(name);
+		if(it==sections_.end()){
+			return NULL;
+		}
+		api_calls_++;
+		return getseg(it->second);
+	}
+	SectionWalker::SectionWalker(const SectionDirectory& directory):directory_(directory),current_head_(BADADDR),only_(NULL),entry_(0),
+		section_start_(BADADDR),section_end_(BADADDR),cursor_(BADADDR),range_end_(BADADDR),last_(BADADDR),section_open_(false),whole_section_(false),finished_(false){
+		memset(&stats_,0,sizeof(stats_));
+	}
+	SectionWalker::~SectionWalker(void){
+		for(std::vector<SectionEntry>::iterator it = entries_.begin();it!=entries_.end();++it){
+			for(std::vector<HeadVisitor*>::iterator visitor = it->visitors.begin();visitor!=it->visitors.end();++visitor){
+				delete *visitor;
+			}
+		}
+	}
+	SectionWalker::SectionEntry& SectionWalker::AddEntry(const std::string& section_name){
+		for(std::vector<SectionEntry>::iterator it = entries_.begin();it!=entries_.end();++it){
+			if(it->name==section_name){
+				return *it;
+			}
+		}
+		SectionEntry entry;
+		entry.name = section_name;
+		entry.walk_heads = false;
+		entries_.push_back(entry);
+		return entries_.back();
+	}
+	void SectionWalker::Register(const std::string& section_name,HeadVisitor* visitor){
+		SectionEntry& entry = AddEntry(section_name);
+		entry.visitors.push_back(visitor);
+		entry.walk_heads = true;
+	}
+	void SectionWalker::RegisterFinish(const std::string& section_name,HeadVisitor* visitor){
+		AddEntry(section_name).visitors.push_back(visitor);
+	}
+	std::vector<std::string> SectionWalker::section_names() const{
+		std::vector<std::string> names;
+		for(std::vector<SectionEntry>::const_iterator it = entries_.begin();it!=entries_.end();++it){
+			names.push_back(it->name);
+		}
+		return names;
+	}
+	void SectionWalker::Run(const DirtyRanges* only){
+		Begin(only);
+		while(!Step(kNoDeadline)){
+		}
+	}
+	void SectionWalker::Begin(const DirtyRanges* only){
+		only_ = only;
+		entry_ = 0;
+		cursor_ = BADADDR;
+		section_open_ = false;
+		finished_ = false;
+	}
+	bool SectionWalker::Step(uint64 deadline){
+		while(entry_<entries_.size()){
+			const SectionEntry& entry = entries_[entry_];
+			if(!section_open_&&!OpenSection(entry)){
+				entry_++;
+				continue;
+			}
+			while(entry.walk_heads&&(cursor_!=BADADDR||NextRange())){
+				VisitHead(entry);
+				if(deadline!=kNoDeadline&&stats_.heads%kHeadsPerClock==0){
+					uint64 now = 0;
+					get_nsec_stamp(&now);
+					stats_.head_calls++;
+					if(now>=deadline){
+						return false;
+					}
+				}
+			}
+			FinishSection(entry);
+			entry_++;
+			//finishing may leave work behind for the caller
+			return false;
+		}
+		if(!finished_){
+			finished_ = true;
+			stats_.segment_calls = directory_.api_calls();
+			msg("objc: walked %u sections,%u heads,%u name fetches,%u dispatches,%u ida calls (%u segment,%u head)\n",
+				stats_.sections,stats_.heads,stats_.name_fetches,stats_.dispatches,stats_.segment_calls+stats_.head_calls,
+				stats_.segment_calls,stats_.head_calls);
+		}
+		return true;
+	}
+	uint32 SectionWalker::progress() const{
+		if(entries_.empty()||entry_>=entries_.size()){
+			return 1000;
+		}
+		uint64 done = static_cast<uint64>(entry_)*1000;
+		if(section_open_&&cursor_!=BADADDR&&section_end_>section_start_){
+			done += static_cast<uint64>(cursor_-section_start_)*1000/(section_end_-section_start_);
+		}
+		return static_cast<uint32>(done/entries_.size());
+	}
+	bool SectionWalker::OpenSection(const SectionEntry& entry){
+		segment_t* seg = directory_.Find(entry.name);
+		if(!seg){
+			return false;
+		}
+		stats_.sections++;
+		//bounds are kept rather than the segment,the database may change
+		//between two slices
+		section_start_ = seg->startEA;
+		section_end_ = seg->endEA;
+		cursor_ = BADADDR;
+		last_ = BADADDR;
+		whole_section_ = (only_==NULL);
+		if(only_!=NULL){
+			range_ = only_->begin();
+		}
+		section_open_ = true;
+		return true;
+	}
+	bool SectionWalker::NextRange(){
+		if(only_==NULL){
+			if(!whole_section_){
+				return false;
+			}
+			whole_section_ = false;
+			cursor_ = section_start_;
+			range_end_ = section_end_;
+			return true;
+		}
+		for(;range_!=only_->end();++range_){
+			if(range_->second<=section_start_||range_->first>=section_end_){
+				continue;
+			}
+			//start at the head of the item the range begins in
+			ea_t start = section_start_;
+			if(range_->first>section_start_){
+				start = get_item_head(range_->first);
+				stats_.head_calls++;
+			}
+			if(start<section_start_){
+				start = section_start_;
+			}
+			else if(start!=section_start_){
+				stats_.head_calls++;
+				if(!isHead(get_flags_novalue(start))){
+					start = next_head(start,section_end_);
+					stats_.head_calls++;
+				}
+			}
+			ea_t end = (range_->second<section_end_)?range_->second:section_end_;
+			if(start!=BADADDR&&start<end){
+				++range_;
+				cursor_ = start;
+				range_end_ = end;
+				return true;
+			}
+		}
+		return false;
+	}
+	void SectionWalker::VisitHead(const SectionEntry& entry){
+		ea_t start = cursor_;
+		//ranges are sorted,a head spanning two of them is visited once
+		if(last_==BADADDR||start>last_){
+			last_ = start;
+			char name[1024] = {0};
+			const char* head_name = get_name(BADADDR,start,name,1024);
+			stats_.heads++;
+			stats_.name_fetches++;
+			stats_.head_calls++;
+			current_head_ = start;
+			for(std::vector<HeadVisitor*>::const_iterator it = entry.visitors.begin();it!=entry.visitors.end();++it){
+				(*it)->VisitHead(start,head_name);
+				stats_.dispatches++;
+			}
+			current_head_ = BADADDR;
+		}
+		cursor_ = next_head(start,range_end_);
+		stats_.head_calls++;
+	}
+	void SectionWalker::FinishSection(const SectionEntry& entry){
+		section_open_ = false;
+		cursor_ = BADADDR;
+		segment_t* seg = directory_.Find(entry.name);
+		if(seg==NULL){
+			return;
+		}
+		for(std::vector<HeadVisitor*>::const_iterator it = entry.visitors.begin();it!=entry.visitors.end();++it){
+			(*it)->FinishSection(seg);
+		}
+	}
+}
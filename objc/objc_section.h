@@ -0,0 +1,139 @@
+#ifndef OBJC_OBJC_SECTION_H_
+#define OBJC_OBJC_SECTION_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <ida.hpp>
+#include <segment.hpp>
+#include "objc/objc_dirty_ranges.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//every segment of the database indexed by name,built once per run
+	class SectionDirectory
+	{
+	public:
+		SectionDirectory(void);
+		~SectionDirectory(void);
+		void Build();
+		segment_t* Find(const std::string& name) const;
+		//ida calls made by Build and Find:get_segm_qty,getnseg and
+		//get_true_segm_name per segment,getseg per Find
+		uint32 api_calls() const{
+			return api_calls_;
+		}
+	private:
+		std::map<std::string,ea_t> sections_;
+		mutable uint32 api_calls_;
+		DISALLOW_EVIL_CONSTRUCTORS(SectionDirectory);
+	};
+	//receives every head of one section,name is NULL when the head has no name
+	class HeadVisitor
+	{
+	public:
+		virtual ~HeadVisitor(){}
+		virtual void VisitHead(ea_t ea,const char* name) = 0;
+		virtual void FinishSection(const segment_t* seg){}
+	};
+	template<typename T>
+	class MemberHeadVisitor:public HeadVisitor
+	{
+	public:
+		typedef void (T::*HeadFunc)(ea_t ea,const char* name);
+		typedef void (T::*FinishFunc)(const segment_t* seg);
+		MemberHeadVisitor(T* obj,HeadFunc head,FinishFunc finish = NULL):obj_(obj),head_(head),finish_(finish){}
+		virtual void VisitHead(ea_t ea,const char* name){
+			if(head_!=NULL){
+				(obj_->*head_)(ea,name);
+			}
+		}
+		virtual void FinishSection(const segment_t* seg){
+			if(finish_!=NULL){
+				(obj_->*finish_)(seg);
+			}
+		}
+	private:
+		T* obj_;
+		HeadFunc head_;
+		FinishFunc finish_;
+	};
+	struct SectionWalkStats
+	{
+		uint32 sections;
+		uint32 heads;
+		uint32 name_fetches;
+		uint32 dispatches;
+		//ida calls of the directory and of the walk itself (next_head,get_name,
+		//get_item_head,get_flags_novalue,get_nsec_stamp),not the visitors'
+		uint32 segment_calls;
+		uint32 head_calls;
+	};
+	//walks each registered section once,fetches every head name once and
+	//hands it to all visitors registered for that section in registration order
+	class SectionWalker
+	{
+	public:
+		explicit SectionWalker(const SectionDirectory& directory);
+		~SectionWalker(void);
+		//visitor is owned by the walker
+		void Register(const std::string& section_name,HeadVisitor* visitor);
+		//visitor only gets FinishSection.a section with nothing but these is
+		//not walked,it is still opened,finished and listed in section_names
+		void RegisterFinish(const std::string& section_name,HeadVisitor* visitor);
+		//only is NULL for a full run,otherwise just the heads overlapping it
+		//are visited.sections are finished either way
+		void Run(const DirtyRanges* only = NULL);
+		//Run in slices:Step walks heads until get_nsec_stamp passes deadline or a
+		//section has been finished,and returns true once every section is done.
+		//only must stay alive until then
+		void Begin(const DirtyRanges* only);
+		bool Step(uint64 deadline);
+		//per mille of the registered sections walked so far
+		uint32 progress() const;
+		const SectionWalkStats& stats() const{
+			return stats_;
+		}
+		std::vector<std::string> section_names() const;
+		enum{
+			kNoDeadline = 0,
+			//heads walked between two reads of the clock
+			kHeadsPerClock = 32
+		};
+		//head being dispatched,BADADDR outside of VisitHead
+		ea_t current_head() const{
+			return current_head_;
+		}
+	private:
+		struct SectionEntry{
+			std::string name;
+			std::vector<HeadVisitor*> visitors;
+			bool walk_heads;
+		};
+		SectionEntry& AddEntry(const std::string& section_name);
+		bool OpenSection(const SectionEntry& entry);
+		//moves cursor_ to the first head of the next range of the open section
+		bool NextRange();
+		void VisitHead(const SectionEntry& entry);
+		void FinishSection(const SectionEntry& entry);
+		const SectionDirectory& directory_;
+		std::vector<SectionEntry> entries_;
+		SectionWalkStats stats_;
+		ea_t current_head_;
+		//position of a sliced walk
+		const DirtyRanges* only_;
+		DirtyRanges::const_iterator range_;
+		size_t entry_;
+		ea_t section_start_;
+		ea_t section_end_;
+		ea_t cursor_;
+		ea_t range_end_;
+		ea_t last_;
+		bool section_open_;
+		bool whole_section_;
+		bool finished_;
+		DISALLOW_EVIL_CONSTRUCTORS(SectionWalker);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
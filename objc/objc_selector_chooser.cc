@@ -0,0 +1,124 @@
+#include "objc/objc_selector_chooser.h"
+#include <ida.hpp>
+#include <kernwin.hpp>
+#include <expr.hpp>
+#include <name.hpp>
+#include <funcs.hpp>
+
+namespace objc{
+	namespace{
+		const char kSelectorArgs[] = {VT_STR2,0};
+		const char kImplementationArgs[] = {VT_STR2,VT_LONG,0};
+		const int kColumnWidths[] = {4,32,16,32};
+	}
+	const char SelectorChooser::kMenuPath[] = "Jump/Jump to function...";
+	const char SelectorChooser::kMenuName[] = "Objc implementations...";
+	const char SelectorChooser::kHotkey[] = "Alt-Shift-I";
+	const SelectorIndex* SelectorChooser::index_ = NULL;
+	void SelectorChooser::Install(const SelectorIndex* index){
+		index_ = index;
+		set_idc_func_ex("ObjcImplementationCount",IdcCount,kSelectorArgs,0);
+		set_idc_func_ex("ObjcImplementationAt",IdcAt,kImplementationArgs,0);
+		set_idc_func_ex("ObjcImplementationClass",IdcClass,kImplementationArgs,0);
+		set_idc_func_ex("ObjcImplementationFlags",IdcFlags,kImplementationArgs,0);
+		add_menu_item(kMenuPath,kMenuName,kHotkey,SETMENU_APP,Show,NULL);
+	}
+	void SelectorChooser::Uninstall(){
+		del_menu_item((std::string("Jump/")+kMenuName).c_str());
+		//a NULL function takes the name back
+		set_idc_func_ex("ObjcImplementationCount",NULL,NULL,0);
+		set_idc_func_ex("ObjcImplementationAt",NULL,NULL,0);
+		set_idc_func_ex("ObjcImplementationClass",NULL,NULL,0);
+		set_idc_func_ex("ObjcImplementationFlags",NULL,NULL,0);
+		index_ = NULL;
+	}
+	bool idaapi SelectorChooser::Show(void* user_data){
+		if(index_==NULL||index_->selector_count()==0){
+			warning("objc: no selectors indexed,run the restore first");
+			return false;
+		}
+		const char* text = askstr(HIST_IDENT,NULL,"Selector (-sel or +sel for one kind)");
+		if(text==NULL||text[0]=='\0'){
+			return false;
+		}
+		Selection selection;
+		selection.kind = kAnyKind;
+		if(text[0]=='-'||text[0]=='+'){
+			selection.kind = (text[0]=='+')?uint32(SelectorIndex::kClassMethod):0;
+			text++;
+		}
+		selection.selector = index_->FindSelector(text);
+		if(selection.selector==SelectorIndex::kNoId){
+			warning("objc: no implementation of %s",text);
+			return false;
+		}
+		for(const SelectorIndex::Implementation* it = index_->begin(selection.selector);it!=index_->end(selection.selector);++it){
+			if(selection.kind==kAnyKind||(it->flags&SelectorIndex::kClassMethod)==selection.kind){
+				selection.rows.push_back(it);
+			}
+		}
+		if(selection.rows.empty()){
+			warning("objc: no %s method %s",(selection.kind==0)?"instance":"class",text);
+			return false;
+		}
+		std::string title = std::string("Implementations of ")+index_->selector_name(selection.selector);
+		//a modal chooser answers 1 based,0 is cancel
+		uint32 choice = choose2(&selection,qnumber(kColumnWidths),kColumnWidths,Size,Line,title.c_str());
+		if(choice==0||choice>selection.rows.size()){
+			return false;
+		}
+		jumpto(static_cast<ea_t>(selection.rows[choice-1]->imp));
+		return true;
+	}
+	uint32 idaapi SelectorChooser::Size(void* obj){
+		return static_cast<uint32>(static_cast<Selection*>(obj)->rows.size());
+	}
+	void idaapi SelectorChooser::Line(void* obj,uint32 n,char* const* cells){
+		if(n==0){
+			qstrncpy(cells[0],"Kind",MAXSTR);
+			qstrncpy(cells[1],"Class",MAXSTR);
+			qstrncpy(cells[2],"Address",MAXSTR);
+			qstrncpy(cells[3],"Function",MAXSTR);
+			return;
+		}
+		const Selection* selection = static_cast<Selection*>(obj);
+		const SelectorIndex::Implementation* row = selection->rows[n-1];
+		ea_t ea = static_cast<ea_t>(row->imp);
+		qstrncpy(cells[0],((row->flags&SelectorIndex::kClassMethod)!=0)?"+":"-",MAXSTR);
+		qstrncpy(cells[1],index_->owner_name(row->owner),MAXSTR);
+		qsnprintf(cells[2],MAXSTR,"%a",ea);
+		if(get_true_name(BADADDR,ea,cells[3],MAXSTR)==NULL){
+			cells[3][0] = '\0';
+		}
+	}
+	const SelectorIndex::Implementation* SelectorChooser::Lookup(const idc_value_t* argv){
+		if(index_==NULL){
+			return NULL;
+		}
+		uint32 selector = index_->FindSelector(argv[0].c_str());
+		if(selector==SelectorIndex::kNoId||argv[1].num<0||static_cast<uint32>(argv[1].num)>=index_->implementation_count(selector)){
+			return NULL;
+		}
+		return index_->begin(selector)+argv[1].num;
+	}
+	error_t idaapi SelectorChooser::IdcCount(idc_value_t* argv,idc_value_t* result){
+		uint32 selector = (index_!=NULL)?index_->FindSelector(argv[0].c_str()):uint32(SelectorIndex::kNoId);
+		result->set_long((selector!=SelectorIndex::kNoId)?index_->implementation_count(selector):0);
+		return eOk;
+	}
+	error_t idaapi SelectorChooser::IdcAt(idc_value_t* argv,idc_value_t* result){
+		const SelectorIndex::Implementation* row = Lookup(argv);
+		result->set_long((row!=NULL)?static_cast<ea_t>(row->imp):BADADDR);
+		return eOk;
+	}
+	error_t idaapi SelectorChooser::IdcClass(idc_value_t* argv,idc_value_t* result){
+		const SelectorIndex::Implementation* row = Lookup(argv);
+		result->set_string((row!=NULL)?index_->owner_name(row->owner):"");
+		return eOk;
+	}
+	error_t idaapi SelectorChooser::IdcFlags(idc_value_t* argv,idc_value_t* result){
+		const SelectorIndex::Implementation* row = Lookup(argv);
+		result->set_long((row!=NULL)?static_cast<sval_t>(row->flags):-1);
+		return eOk;
+	}
+}
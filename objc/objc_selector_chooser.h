@@ -0,0 +1,50 @@
+#ifndef OBJC_OBJC_SELECTOR_CHOOSER_H_
+#define OBJC_OBJC_SELECTOR_CHOOSER_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <ida.hpp>
+#include <expr.hpp>
+#include "objc/objc_selector_index.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//the selector index as idc functions and a chooser behind kHotkey:
+	//	ObjcImplementationCount(selector)
+	//	ObjcImplementationAt(selector,n)    address or BADADDR
+	//	ObjcImplementationClass(selector,n) class or Class_$_Category
+	//	ObjcImplementationFlags(selector,n) 1 for class methods,-1 if n is out of range
+	//the index belongs to the caller and has to outlive Uninstall
+	class SelectorChooser
+	{
+	public:
+		static void Install(const SelectorIndex* index);
+		static void Uninstall();
+	private:
+		struct Selection{
+			uint32 selector;
+			//SelectorIndex::kClassMethod,or kAnyKind
+			uint32 kind;
+			std::vector<const SelectorIndex::Implementation*> rows;
+		};
+		enum{
+			kAnyKind = 0xFFFFFFFF
+		};
+		static const char kMenuPath[];
+		static const char kMenuName[];
+		static const char kHotkey[];
+		static bool idaapi Show(void* user_data);
+		static uint32 idaapi Size(void* obj);
+		static void idaapi Line(void* obj,uint32 n,char* const* cells);
+		//the n-th implementation of the selector in argv[0],NULL when there is none
+		static const SelectorIndex::Implementation* Lookup(const idc_value_t* argv);
+		static error_t idaapi IdcCount(idc_value_t* argv,idc_value_t* result);
+		static error_t idaapi IdcAt(idc_value_t* argv,idc_value_t* result);
+		static error_t idaapi IdcClass(idc_value_t* argv,idc_value_t* result);
+		static error_t idaapi IdcFlags(idc_value_t* argv,idc_value_t* result);
+		static const SelectorIndex* index_;
+		DISALLOW_EVIL_CONSTRUCTORS(SelectorChooser);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
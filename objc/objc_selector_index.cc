@@ -0,0 +1,93 @@
+#include "objc/objc_selector_index.h"
+#include <algorithm>
+
+namespace objc{
+	StringInterner::StringInterner(void){
+	}
+	StringInterner::~StringInterner(void){
+	}
+	uint32 StringInterner::Intern(const StringPiece& str){
+		key_.assign(str.data(),str.size());
+		std::unordered_map<std::string,uint32>::const_iterator it = ids_.find(key_);
+		if(it!=ids_.end()){
+			return it->second;
+		}
+		uint32 id = static_cast<uint32>(offsets_.size());
+		offsets_.push_back(static_cast<uint32>(pool_.size()));
+		pool_.insert(pool_.end(),str.data(),str.data()+str.size());
+		pool_.push_back('\0');
+		ids_[key_] = id;
+		return id;
+	}
+	uint32 StringInterner::Find(const StringPiece& str) const{
+		key_.assign(str.data(),str.size());
+		std::unordered_map<std::string,uint32>::const_iterator it = ids_.find(key_);
+		return (it!=ids_.end())?it->second:uint32(kNoId);
+	}
+	void StringInterner::Clear(){
+		pool_.clear();
+		offsets_.clear();
+		ids_.clear();
+	}
+	bool SelectorIndex::Pending::operator<(const Pending& other) const{
+		if(selector!=other.selector){
+			return selector<other.selector;
+		}
+		if(implementation.owner!=other.implementation.owner){
+			return implementation.owner<other.implementation.owner;
+		}
+		if(implementation.flags!=other.implementation.flags){
+			return implementation.flags<other.implementation.flags;
+		}
+		return implementation.imp<other.implementation.imp;
+	}
+	bool SelectorIndex::Pending::operator==(const Pending& other) const{
+		return selector==other.selector&&implementation.owner==other.implementation.owner&&
+			implementation.flags==other.implementation.flags&&implementation.imp==other.implementation.imp;
+	}
+	SelectorIndex::SelectorIndex(void){
+	}
+	SelectorIndex::~SelectorIndex(void){
+	}
+	void SelectorIndex::Add(const StringPiece& owner,const StringPiece& selector,uint64_t imp,uint32 flags){
+		Pending pending;
+		pending.selector = selectors_.Intern(selector);
+		pending.implementation.imp = imp;
+		pending.implementation.owner = owners_.Intern(owner);
+		pending.implementation.flags = flags;
+		pending_.push_back(pending);
+	}
+	void SelectorIndex::Build(){
+		if(pending_.empty()&&!rows_.empty()){
+			return;
+		}
+		//the rows built before go back in with the new methods
+		for(uint32 selector=0;selector<row_count();selector++){
+			for(uint32 index=rows_[selector];index<rows_[selector+1];index++){
+				Pending pending = {selector,entries_[index]};
+				pending_.push_back(pending);
+			}
+		}
+		std::sort(pending_.begin(),pending_.end());
+		pending_.erase(std::unique(pending_.begin(),pending_.end()),pending_.end());
+		rows_.assign(selectors_.size()+1,0);
+		entries_.clear();
+		entries_.reserve(pending_.size());
+		for(std::vector<Pending>::const_iterator it = pending_.begin();it!=pending_.end();++it){
+			rows_[it->selector+1]++;
+			entries_.push_back(it->implementation);
+		}
+		for(size_t index=1;index<rows_.size();index++){
+			rows_[index] += rows_[index-1];
+		}
+		//the staging buffer is as large as the index,give it back
+		std::vector<Pending>().swap(pending_);
+	}
+	void SelectorIndex::Clear(){
+		selectors_.Clear();
+		owners_.Clear();
+		std::vector<Pending>().swap(pending_);
+		rows_.clear();
+		entries_.clear();
+	}
+}
@@ -0,0 +1,113 @@
+#ifndef OBJC_OBJC_SELECTOR_INDEX_H_
+#define OBJC_OBJC_SELECTOR_INDEX_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "objc/objc_string.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//strings stored once,back to back,and numbered in the order they came
+	class StringInterner
+	{
+	public:
+		enum{
+			kNoId = 0xFFFFFFFF
+		};
+		StringInterner(void);
+		~StringInterner(void);
+		uint32 Intern(const StringPiece& str);
+		uint32 Find(const StringPiece& str) const;
+		const char* Get(uint32 id) const{
+			return &pool_[offsets_[id]];
+		}
+		uint32 size() const{
+			return static_cast<uint32>(offsets_.size());
+		}
+		void Clear();
+	private:
+		std::vector<char> pool_;
+		std::vector<uint32> offsets_;
+		std::unordered_map<std::string,uint32> ids_;
+		//reused by Find
+		mutable std::string key_;
+		DISALLOW_EVIL_CONSTRUCTORS(StringInterner);
+	};
+	//selector -> the classes and categories implementing it.methods are
+	//added while the method lists are renamed and Build sorts them into
+	//compressed rows,one row of implementations per selector id.no ida
+	//headers here
+	class SelectorIndex
+	{
+	public:
+		enum{
+			kNoId = StringInterner::kNoId,
+			//the method is in the metaclass or a category's class list
+			kClassMethod = 0x1
+		};
+		struct Implementation
+		{
+			uint64_t imp;
+			//class or Class_$_Category,see owner_name
+			uint32 owner;
+			uint32 flags;
+		};
+		SelectorIndex(void);
+		~SelectorIndex(void);
+		void Add(const StringPiece& owner,const StringPiece& selector,uint64_t imp,uint32 flags);
+		//merges what was added since the last Build into the rows,a method
+		//added twice is kept once
+		void Build();
+		void Clear();
+		//kNoId when no method has the selector
+		uint32 FindSelector(const StringPiece& selector) const{
+			uint32 id = selectors_.Find(selector);
+			return (id<row_count())?id:uint32(kNoId);
+		}
+		//rows are sorted by owner,then instance methods before class methods
+		const Implementation* begin(uint32 selector) const{
+			return entries_.empty()?NULL:&entries_[0]+rows_[selector];
+		}
+		const Implementation* end(uint32 selector) const{
+			return entries_.empty()?NULL:&entries_[0]+rows_[selector+1];
+		}
+		uint32 implementation_count(uint32 selector) const{
+			return rows_[selector+1]-rows_[selector];
+		}
+		const char* selector_name(uint32 selector) const{
+			return selectors_.Get(selector);
+		}
+		const char* owner_name(uint32 owner) const{
+			return owners_.Get(owner);
+		}
+		uint32 selector_count() const{
+			return row_count();
+		}
+		uint32 method_count() const{
+			return static_cast<uint32>(entries_.size());
+		}
+	private:
+		struct Pending
+		{
+			uint32 selector;
+			Implementation implementation;
+			bool operator<(const Pending& other) const;
+			bool operator==(const Pending& other) const;
+		};
+		uint32 row_count() const{
+			return rows_.empty()?0:static_cast<uint32>(rows_.size()-1);
+		}
+		StringInterner selectors_;
+		StringInterner owners_;
+		std::vector<Pending> pending_;
+		//entries_[rows_[s]..rows_[s+1]) implement selector s
+		std::vector<uint32> rows_;
+		std::vector<Implementation> entries_;
+		DISALLOW_EVIL_CONSTRUCTORS(SelectorIndex);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
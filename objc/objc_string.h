@@ -1,11 +1,112 @@
 #ifndef OBJC_OBJC_STRING_H_
 #define OBJC_OBJC_STRING_H_
 //////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <string.h>
 #include "thirdparty/glog/basictypes.h"
 #include <string>
 #include "objc/obj_valid_ea.h"
+#include "objc/objc_string_table.h"
+#include "objc/objc_original_bytes.h"
 //////////////////////////////////////////////////////////////////////////
 namespace objc{
+	//non-owning view of characters,valid as long as the source is
+	class StringPiece
+	{
+	public:
+		StringPiece():data_(""),size_(0){}
+		StringPiece(const char* str):data_((str!=NULL)?str:""),size_((str!=NULL)?strlen(str):0){}
+		StringPiece(const char* data,size_t size):data_(data),size_(size){}
+		StringPiece(const std::string& str):data_(str.data()),size_(str.size()){}
+		const char* data() const{
+			return data_;
+		}
+		size_t size() const{
+			return size_;
+		}
+		bool empty() const{
+			return size_==0;
+		}
+		char operator[](size_t index) const{
+			return data_[index];
+		}
+		bool starts_with(const StringPiece& prefix) const{
+			return size_>=prefix.size_&&memcmp(data_,prefix.data_,prefix.size_)==0;
+		}
+		StringPiece substr(size_t pos) const{
+			return (pos<size_)?StringPiece(data_+pos,size_-pos):StringPiece();
+		}
+	private:
+		const char* data_;
+		size_t size_;
+	};
+	struct StringReplacement
+	{
+		StringPiece from;
+		StringPiece to;
+	};
+	//appends names to a buffer the caller keeps across names.clearing a
+	//std::string keeps its capacity,so once the buffer has grown to the
+	//longest name building one costs no allocation
+	class NameWriter
+	{
+	public:
+		explicit NameWriter(std::string* out):out_(out){}
+		NameWriter& Append(const StringPiece& piece){
+			out_->append(piece.data(),piece.size());
+			return *this;
+		}
+		//one left to right pass,at each position the first matching pattern
+		//wins and the scan continues after the replaced text
+		NameWriter& AppendReplaced(const StringPiece& piece,const StringReplacement* replacements,size_t count){
+			size_t pos = 0;
+			while(pos<piece.size()){
+				size_t index = 0;
+				for(;index<count;index++){
+					const StringPiece& from = replacements[index].from;
+					if(!from.empty()&&piece.substr(pos).starts_with(from)){
+						break;
+					}
+				}
+				if(index<count){
+					Append(replacements[index].to);
+					pos += replacements[index].from.size();
+				}
+				else{
+					out_->push_back(piece[pos++]);
+				}
+			}
+			return *this;
+		}
+		//"_$_" separates class and category in symbol names
+		NameWriter& AppendCategoryName(const StringPiece& name){
+			return AppendSelector(name,false);
+		}
+		//selector with ':' -> '_',then "_$_" -> "::",in a single pass
+		NameWriter& AppendSelector(const StringPiece& selector){
+			return AppendSelector(selector,true);
+		}
+	private:
+		NameWriter& AppendSelector(const StringPiece& selector,bool colons){
+			size_t pos = 0;
+			while(pos<selector.size()){
+				if(pos+3<=selector.size()&&IsUnderscore(selector[pos],colons)&&
+					selector[pos+1]=='$'&&IsUnderscore(selector[pos+2],colons)){
+					out_->append("::",2);
+					pos += 3;
+				}
+				else{
+					char c = selector[pos++];
+					out_->push_back((colons&&c==':')?'_':c);
+				}
+			}
+			return *this;
+		}
+		static bool IsUnderscore(char c,bool colons){
+			return c=='_'||(colons&&c==':');
+		}
+		std::string* out_;
+	};
 	class ObjcString:private ObjcValidEA
 	{
 	public:
@@ -15,8 +116,14 @@ namespace objc{
 	protected:
 		bool IsStringType(uint32 ea);
 		std::string GetString(uint32 address,uint32 type);
-		std::string  ReplaceAll(const std::string& str,const std::string& old_value,const std::string& new_value);
+		//like GetString,storage only holds the result if it is not interned
+		StringPiece GetStringPiece(uint32 address,uint32 type,std::string* storage);
+		std::string ReplaceAll(const std::string& str,const std::string& old_value,const std::string& new_value);
 		void AddComment(uint32 to_ea,uint32 ea);
+		//c strings are served from here while it is built
+		ObjcStringTable string_table_;
+		//get_original_long and patch_long go through here
+		OriginalBytes original_bytes_;
 	private:
 		DISALLOW_EVIL_CONSTRUCTORS(ObjcString);
 	};
@@ -0,0 +1,35 @@
+#include "objc/objc_string_arena.h"
+
+namespace objc{
+	namespace{
+		const size_t kArenaBlockSize = 1<<20;
+	}
+	StringArena::StringArena(void):cursor_(NULL),remaining_(0),allocated_(0){
+	}
+	StringArena::~StringArena(void){
+		Release();
+	}
+	char* StringArena::Allocate(size_t size){
+		if(size>remaining_){
+			//sections larger than a block get a block of their own
+			size_t block_size = (size>kArenaBlockSize)?size:kArenaBlockSize;
+			cursor_ = new char[block_size];
+			remaining_ = block_size;
+			blocks_.push_back(cursor_);
+		}
+		char* result = cursor_;
+		cursor_ += size;
+		remaining_ -= size;
+		allocated_ += size;
+		return result;
+	}
+	void StringArena::Release(){
+		for(std::vector<char*>::iterator it = blocks_.begin();it!=blocks_.end();++it){
+			delete[] *it;
+		}
+		std::vector<char*>().swap(blocks_);
+		cursor_ = NULL;
+		remaining_ = 0;
+		allocated_ = 0;
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef OBJC_OBJC_STRING_ARENA_H_
+#define OBJC_OBJC_STRING_ARENA_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//bump allocator,everything is freed at once by Release
+	class StringArena
+	{
+	public:
+		StringArena(void);
+		~StringArena(void);
+		char* Allocate(size_t size);
+		void Release();
+		size_t allocated() const{
+			return allocated_;
+		}
+	private:
+		std::vector<char*> blocks_;
+		char* cursor_;
+		size_t remaining_;
+		size_t allocated_;
+		DISALLOW_EVIL_CONSTRUCTORS(StringArena);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,65 @@
+#include "objc/objc_string_table.h"
+#include <ida.hpp>
+#include <bytes.hpp>
+#include <segment.hpp>
+#include <kernwin.hpp>
+#include <string.h>
+#include "objc/objc_section.h"
+
+namespace objc{
+	namespace{
+		//selector,class name and type strings,objc2 and objc1 names
+		const char* const kStringSections[] = {
+			"__objc_methname",
+			"__objc_classname",
+			"__objc_methtype",
+			"__meth_var_names",
+			"__class_names",
+			"__meth_var_types",
+			"__cstring"
+		};
+	}
+	ObjcStringTable::ObjcStringTable(void):string_count_(0){
+	}
+	ObjcStringTable::~ObjcStringTable(void){
+	}
+	void ObjcStringTable::Build(const SectionDirectory& directory){
+		Release();
+		for(size_t index=0;index<sizeof(kStringSections)/sizeof(kStringSections[0]);index++){
+			segment_t* seg = directory.Find(kStringSections[index]);
+			if(seg==NULL||seg->endEA<=seg->startEA){
+				continue;
+			}
+			size_t size = static_cast<size_t>(seg->endEA-seg->startEA);
+			//one extra nul so the last string of a section is terminated too
+			char* data = arena_.Allocate(size+1);
+			if(!get_many_bytes(seg->startEA,data,size)){
+				continue;
+			}
+			data[size] = '\0';
+			//memchr is vectorized by the crt,this is the only pass over the bytes
+			for(const char* p = data;p<data+size;){
+				const char* nul = static_cast<const char*>(memchr(p,0,data+size-p));
+				if(nul==NULL){
+					string_count_++;
+					break;
+				}
+				if(nul!=p){
+					string_count_++;
+				}
+				p = nul+1;
+			}
+			Range range;
+			range.start = seg->startEA;
+			range.end = seg->endEA;
+			range.data = data;
+			ranges_.push_back(range);
+		}
+		msg("objc: interned %u strings,%u KB\n",string_count_,static_cast<uint32>(arena_.allocated()>>10));
+	}
+	void ObjcStringTable::Release(){
+		std::vector<Range>().swap(ranges_);
+		arena_.Release();
+		string_count_ = 0;
+	}
+}
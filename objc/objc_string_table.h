@@ -0,0 +1,46 @@
+#ifndef OBJC_OBJC_STRING_TABLE_H_
+#define OBJC_OBJC_STRING_TABLE_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+#include "objc/objc_string_arena.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	class SectionDirectory;
+	//copies of the c-string sections,each string is stored once and an
+	//address inside a section resolves to its characters without a kernel call
+	class ObjcStringTable
+	{
+	public:
+		ObjcStringTable(void);
+		~ObjcStringTable(void);
+		void Build(const SectionDirectory& directory);
+		void Release();
+		//nul terminated string at ea,NULL when ea is not in a scanned section
+		const char* Find(uint64_t ea) const{
+			for(std::vector<Range>::const_iterator it = ranges_.begin();it!=ranges_.end();++it){
+				if(it->start<=ea&&ea<it->end){
+					return it->data+(ea-it->start);
+				}
+			}
+			return NULL;
+		}
+		uint32 string_count() const{
+			return string_count_;
+		}
+	private:
+		struct Range{
+			uint64_t start;
+			uint64_t end;
+			const char* data;
+		};
+		std::vector<Range> ranges_;
+		StringArena arena_;
+		uint32 string_count_;
+		DISALLOW_EVIL_CONSTRUCTORS(ObjcStringTable);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
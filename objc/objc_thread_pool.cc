@@ -0,0 +1,93 @@
+#include "objc/objc_thread_pool.h"
+
+namespace objc{
+	namespace{
+		//indices handed out per lock,keeps the counter off the hot path
+		const size_t kMaxChunk = 64;
+	}
+	ThreadPool::ThreadPool(uint32 threads):task_(NULL),count_(0),next_(0),chunk_(1),generation_(0),busy_(0),stop_(false){
+		for(uint32 index=1;index<threads;index++){
+			workers_.push_back(std::thread(&ThreadPool::WorkerMain,this));
+		}
+	}
+	ThreadPool::~ThreadPool(void){
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		wake_.notify_all();
+		for(std::vector<std::thread>::iterator it = workers_.begin();it!=workers_.end();++it){
+			it->join();
+		}
+	}
+	uint32 ThreadPool::DefaultThreadCount(){
+		uint32 threads = std::thread::hardware_concurrency();
+		return (threads!=0)?threads:1;
+	}
+	void ThreadPool::ParallelFor(size_t count,const ParallelTask& task){
+		if(count==0){
+			return;
+		}
+		if(workers_.empty()||count==1){
+			for(size_t index=0;index<count;index++){
+				task.Run(index);
+			}
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			task_ = &task;
+			count_ = count;
+			next_ = 0;
+			chunk_ = count/(thread_count()*8);
+			chunk_ = (chunk_==0)?1:((chunk_>kMaxChunk)?kMaxChunk:chunk_);
+			busy_ = static_cast<uint32>(workers_.size());
+			generation_++;
+		}
+		wake_.notify_all();
+		RunChunks();
+		std::unique_lock<std::mutex> lock(mutex_);
+		while(busy_!=0){
+			done_.wait(lock);
+		}
+		task_ = NULL;
+	}
+	void ThreadPool::RunChunks(){
+		for(;;){
+			size_t begin;
+			size_t end;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if(next_>=count_){
+					return;
+				}
+				begin = next_;
+				end = (count_-begin>chunk_)?begin+chunk_:count_;
+				next_ = end;
+			}
+			for(size_t index=begin;index<end;index++){
+				task_->Run(index);
+			}
+		}
+	}
+	void ThreadPool::WorkerMain(){
+		uint32 seen = 0;
+		for(;;){
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				while(!stop_&&generation_==seen){
+					wake_.wait(lock);
+				}
+				if(stop_){
+					return;
+				}
+				seen = generation_;
+			}
+			RunChunks();
+			std::lock_guard<std::mutex> lock(mutex_);
+			if(--busy_==0){
+				done_.notify_one();
+			}
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#ifndef OBJC_OBJC_THREAD_POOL_H_
+#define OBJC_OBJC_THREAD_POOL_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include "thirdparty/glog/basictypes.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+//////////////////////////////////////////////////////////////////////////
+//no ida headers here:tasks run off the ui thread and must not call into
+//the kernel,they only decode bytes
+namespace objc{
+	class ParallelTask
+	{
+	public:
+		virtual ~ParallelTask(){}
+		//called once for every index in [0,count),from any worker
+		virtual void Run(size_t index) const = 0;
+	};
+	//fixed set of workers,ParallelFor blocks the caller until every index is done.
+	//the caller takes part in the work so a pool of one thread runs serially
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(uint32 threads);
+		~ThreadPool(void);
+		void ParallelFor(size_t count,const ParallelTask& task);
+		uint32 thread_count() const{
+			return static_cast<uint32>(workers_.size())+1;
+		}
+		static uint32 DefaultThreadCount();
+	private:
+		void WorkerMain();
+		void RunChunks();
+		std::vector<std::thread> workers_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		std::condition_variable done_;
+		const ParallelTask* task_;
+		size_t count_;
+		size_t next_;
+		size_t chunk_;
+		uint32 generation_;
+		uint32 busy_;
+		bool stop_;
+		DISALLOW_EVIL_CONSTRUCTORS(ThreadPool);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,89 @@
+#include "objc/objc_type_cache.h"
+#include <nalt.hpp>
+#include <bytes.hpp>
+#include <string.h>
+
+namespace objc{
+	TypeCache::TypeCache(void):text_(MAXSTR),types_(MAXSTR),fields_(MAXSTR),hits_(0),printed_(0){
+	}
+	TypeCache::~TypeCache(void){
+	}
+	void TypeCache::Clear(){
+		by_ea_.clear();
+		by_signature_.clear();
+		by_struct_.clear();
+		hits_ = 0;
+		printed_ = 0;
+	}
+	uint32 TypeCache::Classify(ea_t ea){
+		std::unordered_map<ea_t,uint32>::const_iterator cached = by_ea_.find(ea);
+		if(cached!=by_ea_.end()){
+			hits_++;
+			return cached->second;
+		}
+		uint32 id = kObjcTypeUnknown;
+		flags_t flags = get_flags_novalue(ea);
+		opinfo_t info;
+		bool typed = get_tinfo2(ea,&tinfo_);
+		if(!typed&&isStruct(flags)&&get_opinfo(ea,0,flags,&info)!=NULL){
+			std::unordered_map<tid_t,uint32>::const_iterator found = by_struct_.find(info.tid);
+			if(found!=by_struct_.end()){
+				hits_++;
+				id = found->second;
+			}
+			else{
+				id = ClassifyPrinted(ea);
+				by_struct_[info.tid] = id;
+			}
+			by_ea_[ea] = id;
+			return id;
+		}
+		if(!typed){
+			types_[0] = 0;
+			fields_[0] = 0;
+			if(guess_type(ea,&types_[0],types_.size(),&fields_[0],fields_.size())!=GUESS_FUNC_FAILED){
+				set_ti(ea,&types_[0],&fields_[0]);
+				typed = get_tinfo2(ea,&tinfo_);
+			}
+		}
+		if(typed&&tinfo_.serialize(&serialized_)){
+			key_.assign(reinterpret_cast<const char*>(serialized_.c_str()),serialized_.length());
+			std::unordered_map<std::string,uint32>::const_iterator found = by_signature_.find(key_);
+			if(found!=by_signature_.end()){
+				hits_++;
+				id = found->second;
+			}
+			else{
+				id = ClassifyPrinted(ea);
+				by_signature_[key_] = id;
+			}
+		}
+		else if(typed){
+			id = ClassifyPrinted(ea);
+		}
+		by_ea_[ea] = id;
+		return id;
+	}
+	uint32 TypeCache::ClassifyPrinted(ea_t ea){
+		text_[0] = '\0';
+		print_type(ea,&text_[0],text_.size(),false);
+		printed_++;
+		return ClassifySignature(&text_[0]);
+	}
+	uint32 TypeCache::ClassifySignature(const char* type_text){
+		if(*type_text=='\0'){
+			return kObjcTypeUnknown;
+		}
+		uint32 id = kObjcTypeOther;
+		if(strstr(type_text,"__CFString")!=NULL||strstr(type_text,"__cfstring_struct")!=NULL){
+			id = kObjcTypeCFString;
+		}
+		else if(strstr(type_text,"__objc_module_info_struct")!=NULL||strstr(type_text,"__module_info_struct")!=NULL){
+			id = kObjcTypeModuleInfo;
+		}
+		else if(strstr(type_text,"__objc_symtab_struct")!=NULL||strstr(type_text,"__symtab_struct")!=NULL){
+			id = kObjcTypeSymtab;
+		}
+		return id;
+	}
+}
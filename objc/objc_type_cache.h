@@ -0,0 +1,62 @@
+#ifndef OBJC_OBJC_TYPE_CACHE_H_
+#define OBJC_OBJC_TYPE_CACHE_H_
+//////////////////////////////////////////////////////////////////////////
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ida.hpp>
+#include <typeinf.hpp>
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	enum ObjcTypeId{
+		//no type,not even after guessing one
+		kObjcTypeUnknown = 0,
+		kObjcTypeCFString,
+		kObjcTypeModuleInfo,
+		kObjcTypeSymtab,
+		kObjcTypeOther
+	};
+	//type of a head reduced to an id.heads without a type get a guessed one
+	//applied first,as the segment passes always did.results are cached per
+	//address and keyed on what the head already carries,its serialized type
+	//or its struct id,so print_type runs once per distinct type
+	class TypeCache
+	{
+	public:
+		TypeCache(void);
+		~TypeCache(void);
+		uint32 Classify(ea_t ea);
+		void Clear();
+		uint32 hits() const{
+			return hits_;
+		}
+		uint32 signatures() const{
+			return static_cast<uint32>(by_signature_.size()+by_struct_.size());
+		}
+		uint32 printed() const{
+			return printed_;
+		}
+	private:
+		//the id of the type print_type gives for ea
+		uint32 ClassifyPrinted(ea_t ea);
+		uint32 ClassifySignature(const char* type_text);
+		std::unordered_map<ea_t,uint32> by_ea_;
+		//serialized type string -> id
+		std::unordered_map<std::string,uint32> by_signature_;
+		//struct id of a struct item without a type -> id
+		std::unordered_map<tid_t,uint32> by_struct_;
+		tinfo_t tinfo_;
+		qtype serialized_;
+		//scratch buffers,allocated once
+		std::vector<char> text_;
+		std::vector<type_t> types_;
+		std::vector<p_list> fields_;
+		std::string key_;
+		uint32 hits_;
+		uint32 printed_;
+		DISALLOW_EVIL_CONSTRUCTORS(TypeCache);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,259 @@
+#include "objc/objc_type_encoding.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace objc{
+	namespace{
+		//nesting beyond this is a broken encoding,not a real type
+		const uint32 kMaxDepth = 32;
+		//what the scalar codes of runtime.h are declared as.l is 32 bits
+		//wide even where long is not
+		const char* ScalarType(char code){
+			switch(code){
+			case 'c':return "char";
+			case 'C':return "unsigned char";
+			case 's':return "short";
+			case 'S':return "unsigned short";
+			case 'i':return "int";
+			case 'I':return "unsigned int";
+			case 'l':return "int";
+			case 'L':return "unsigned int";
+			case 'q':return "long long";
+			case 'Q':return "unsigned long long";
+			case 't':return "__int128";
+			case 'T':return "unsigned __int128";
+			case 'f':return "float";
+			case 'd':return "double";
+			case 'D':return "long double";
+			case 'B':return "bool";
+			case 'v':return "void";
+			case '*':return "char *";
+			case '#':return "Class";
+			case ':':return "SEL";
+			//the pointee of a function pointer
+			case '?':return "void";
+			}
+			return NULL;
+		}
+		bool IsQualifier(char code){
+			return code=='r'||code=='n'||code=='N'||code=='o'||code=='O'||code=='R'||code=='V'||code=='A';
+		}
+		//aggregates named like c++ templates cannot be declared
+		bool IsIdentifier(const char* start,const char* end){
+			if(start==end||(start[0]>='0'&&start[0]<='9')){
+				return false;
+			}
+			for(const char* p=start;p<end;p++){
+				char c = *p;
+				if(!((c>='a'&&c<='z')||(c>='A'&&c<='Z')||(c>='0'&&c<='9')||c=='_')){
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+	TypeEncodingParser::TypeEncodingParser(void):scratch_(kMaxDepth+2),hits_(0){
+	}
+	TypeEncodingParser::~TypeEncodingParser(void){
+	}
+	void TypeEncodingParser::Clear(){
+		encodings_.Clear();
+		by_encoding_.clear();
+		signatures_.clear();
+		arguments_.clear();
+		types_.Clear();
+		opaque_.clear();
+		hits_ = 0;
+	}
+	uint32 TypeEncodingParser::Parse(const StringPiece& encoding){
+		uint32 id = encodings_.Intern(encoding);
+		if(id<by_encoding_.size()){
+			hits_++;
+			return by_encoding_[id];
+		}
+		const char* p = encoding.data();
+		const char* end = p+encoding.size();
+		Signature signature = {0,static_cast<uint32>(arguments_.size()),0,0};
+		TypeText type;
+		bool ok = true;
+		for(bool result=true;ok&&p<end;result=false){
+			ok = ParseType(&p,end,0,&type)&&!type.unnamed;
+			if(!ok){
+				break;
+			}
+			if(type.aggregate){
+				//by value the layout is needed,there is nothing to make opaque
+				type.opaque = type.text;
+				signature.flags |= kByValueAggregate;
+			}
+			else if(type.text!=type.opaque){
+				signature.flags |= kAggregatePointer;
+			}
+			uint32 type_id = InternType(type);
+			if(result){
+				signature.result = type_id;
+			}
+			else{
+				arguments_.push_back(type_id);
+				signature.argument_count++;
+			}
+			//the frame size after the result,the offset after an argument
+			SkipNumber(&p,end);
+		}
+		uint32 index = kNoSignature;
+		if(ok&&signature.argument_count>=2){
+			index = static_cast<uint32>(signatures_.size());
+			signatures_.push_back(signature);
+		}
+		else{
+			arguments_.resize(signature.first_argument);
+		}
+		by_encoding_.push_back(index);
+		return index;
+	}
+	void TypeEncodingParser::Declaration(uint32 signature,const StringPiece& name,bool opaque,std::string* decl) const{
+		const Signature& parsed = signatures_[signature];
+		decl->assign(types_.Get(opaque?opaque_[parsed.result]:parsed.result));
+		decl->append(" ").append(name.data(),name.size()).append("(id self, SEL _cmd");
+		char argument[32] = {0};
+		for(uint32 index=2;index<parsed.argument_count;index++){
+			uint32 type = arguments_[parsed.first_argument+index];
+			sprintf(argument," arg%u",index);
+			decl->append(", ").append(types_.Get(opaque?opaque_[type]:type)).append(argument);
+		}
+		decl->append(")");
+	}
+	bool TypeEncodingParser::ParseType(const char** p,const char* end,uint32 depth,TypeText* type){
+		if(depth>kMaxDepth){
+			return false;
+		}
+		//only const changes the declaration,in,out,bycopy and the like do not
+		bool constant = false;
+		while(*p<end&&IsQualifier(**p)){
+			constant = constant||(**p=='r');
+			(*p)++;
+		}
+		if(*p>=end){
+			return false;
+		}
+		char code = *(*p)++;
+		type->aggregate = false;
+		type->unnamed = false;
+		const char* scalar = ScalarType(code);
+		if(scalar!=NULL){
+			type->text.assign(scalar);
+			type->opaque.assign(scalar);
+		}
+		else if(code=='@'){
+			//@? is a block,@"Name" an object of a class the til may not know
+			if(*p<end&&**p=='?'){
+				(*p)++;
+			}
+			else if(*p<end&&**p=='"'){
+				const char* close = static_cast<const char*>(memchr(*p+1,'"',end-(*p+1)));
+				if(close==NULL){
+					return false;
+				}
+				*p = close+1;
+			}
+			type->text.assign("id");
+			type->opaque.assign("id");
+		}
+		else if(code=='^'||code=='['||code=='j'){
+			//arrays are only seen as arguments,where they decay to pointers.
+			//complex numbers keep the type of their parts
+			if(code=='['){
+				SkipNumber(p,end);
+			}
+			if(!ParseType(p,end,depth+1,type)){
+				return false;
+			}
+			if(code=='['&&(*p>=end||*(*p)++!=']')){
+				return false;
+			}
+			if(code!='j'){
+				if(type->unnamed){
+					type->text.assign("void");
+					type->opaque.assign("void");
+				}
+				type->text.append(" *");
+				type->opaque.append(" *");
+				type->aggregate = false;
+				type->unnamed = false;
+			}
+		}
+		else if(code=='{'||code=='('){
+			char close = (code=='{')?'}':')';
+			const char* name = *p;
+			while(*p<end&&**p!='='&&**p!=close){
+				(*p)++;
+			}
+			const char* name_end = *p;
+			if(*p<end&&**p=='='){
+				(*p)++;
+				if(!SkipFields(p,end,close,depth+1)){
+					return false;
+				}
+			}
+			if(*p>=end||*(*p)++!=close){
+				return false;
+			}
+			type->aggregate = true;
+			type->unnamed = !IsIdentifier(name,name_end);
+			type->text.assign((code=='{')?"struct ":"union ").append(name,name_end);
+			type->opaque.assign("void");
+		}
+		else if(code=='b'){
+			//bitfields are only inside aggregates,which are not kept
+			SkipNumber(p,end);
+			type->text.assign("unsigned int");
+			type->opaque.assign("unsigned int");
+		}
+		else{
+			return false;
+		}
+		if(constant){
+			type->text.insert(0,"const ");
+			type->opaque.insert(0,"const ");
+		}
+		return true;
+	}
+	bool TypeEncodingParser::SkipFields(const char** p,const char* end,char close,uint32 depth){
+		//one scratch type per depth,sized up front so nested fields never move it
+		while(*p<end&&**p!=close){
+			//fields of a named aggregate carry quoted names
+			if(**p=='"'){
+				const char* quote = static_cast<const char*>(memchr(*p+1,'"',end-(*p+1)));
+				if(quote==NULL){
+					return false;
+				}
+				*p = quote+1;
+			}
+			if(!ParseType(p,end,depth,&scratch_[depth])){
+				return false;
+			}
+		}
+		return true;
+	}
+	void TypeEncodingParser::SkipNumber(const char** p,const char* end){
+		//old encodings have negative offsets for arguments in registers
+		if(*p<end&&**p=='-'){
+			(*p)++;
+		}
+		while(*p<end&&**p>='0'&&**p<='9'){
+			(*p)++;
+		}
+	}
+	uint32 TypeEncodingParser::InternType(const TypeText& type){
+		uint32 id = types_.Intern(type.text);
+		if(id==opaque_.size()){
+			uint32 opaque = types_.Intern(type.opaque);
+			opaque_.push_back(opaque);
+			//the opaque spelling may be new as well,it is its own opaque form
+			if(opaque==opaque_.size()){
+				opaque_.push_back(opaque);
+			}
+		}
+		return id;
+	}
+}
@@ -0,0 +1,86 @@
+#ifndef OBJC_OBJC_TYPE_ENCODING_H_
+#define OBJC_OBJC_TYPE_ENCODING_H_
+//////////////////////////////////////////////////////////////////////////
+#include <stddef.h>
+#include <stdint.h>
+#include "thirdparty/glog/basictypes.h"
+#include <string>
+#include <vector>
+#include "objc/objc_selector_index.h"
+//////////////////////////////////////////////////////////////////////////
+namespace objc{
+	//method type encodings like v24@0:8@16 turned into c declarations.the
+	//same few thousand encodings come back for every method list,so each is
+	//parsed once and later calls are a hash lookup.no ida headers here,which
+	//is why objc2_type_t of the sdk's mach-o/common.h is not used
+	class TypeEncodingParser
+	{
+	public:
+		enum{
+			kNoSignature = 0xFFFFFFFF
+		};
+		enum{
+			//a struct or union is passed or returned by value,the til has to
+			//know it for the declaration to parse
+			kByValueAggregate = 0x1,
+			//a pointer to a named struct or union,Declaration with opaque
+			//set makes it void *
+			kAggregatePointer = 0x2
+		};
+		struct Signature
+		{
+			uint32 result;
+			uint32 first_argument;
+			//self and _cmd included
+			uint32 argument_count;
+			uint32 flags;
+		};
+		TypeEncodingParser(void);
+		~TypeEncodingParser(void);
+		//kNoSignature when the encoding is malformed or has an unnamed
+		//aggregate passed by value
+		uint32 Parse(const StringPiece& encoding);
+		//result name(id self,SEL _cmd,type arg2,...)
+		void Declaration(uint32 signature,const StringPiece& name,bool opaque,std::string* decl) const;
+		const Signature& signature(uint32 id) const{
+			return signatures_[id];
+		}
+		uint32 signature_count() const{
+			return static_cast<uint32>(signatures_.size());
+		}
+		uint32 hits() const{
+			return hits_;
+		}
+		void Clear();
+	private:
+		//one c type in both spellings,opaque has void where a named
+		//aggregate is
+		struct TypeText
+		{
+			std::string text;
+			std::string opaque;
+			bool aggregate;
+			bool unnamed;
+		};
+		//the type at *p,false when it is malformed
+		bool ParseType(const char** p,const char* end,uint32 depth,TypeText* type);
+		//struct and union bodies are walked for their end,not kept
+		bool SkipFields(const char** p,const char* end,char close,uint32 depth);
+		static void SkipNumber(const char** p,const char* end);
+		uint32 InternType(const TypeText& type);
+		//encoding id -> signature,kNoSignature for malformed ones
+		StringInterner encodings_;
+		std::vector<uint32> by_encoding_;
+		std::vector<Signature> signatures_;
+		//type ids of the results and arguments of every signature
+		std::vector<uint32> arguments_;
+		StringInterner types_;
+		//type id -> type id of its opaque spelling
+		std::vector<uint32> opaque_;
+		std::vector<TypeText> scratch_;
+		uint32 hits_;
+		DISALLOW_EVIL_CONSTRUCTORS(TypeEncodingParser);
+	};
+}
+//////////////////////////////////////////////////////////////////////////
+#endif